@@ -2,6 +2,10 @@
 #include "InetAddress.h"
 #include "Logger.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 static int createNonblocking() {
     int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if(sockfd < 0) {
@@ -15,9 +19,18 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
     , acceptSocket_(createNonblocking()) // socket 创建一个非阻塞的listenfd
     , acceptChannel_(loop, acceptSocket_.fd())
     , listening_(false)
+    , acceptBatch_(kDefaultAcceptBatch)
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
+    , wakeups_(0)
+    , accepted_(0)
+    , shed_(0)
+    , fdExhausted_(0)
 {
+    if(idleFd_ < 0) {
+        LOG_ERROR("%s:%s:%d open idle fd err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
     acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(true);
+    acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(listenAddr); // bind
     // TcpServer::start() Acceptor.listen  有新用户的连接，要执行一个回调（connfd=》channel=》subloop）
     // baseLoop => acceptChannel_(listenfd) => 
@@ -27,6 +40,9 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusepor
 Acceptor::~Acceptor() {
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    if(idleFd_ >= 0) {
+        ::close(idleFd_);
+    }
 }
 
 void Acceptor::listen() {
@@ -36,23 +52,61 @@ void Acceptor::listen() {
     // channel设置为可读，才能让Poller监听
 }
 
+Acceptor::Stats Acceptor::stats() const {
+    Stats stats;
+    stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.shed = shed_.load(std::memory_order_relaxed);
+    stats.fdExhausted = fdExhausted_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // listenfd有事件发生了，就是有新用户连接
+// 一次最多accept acceptBatch_个连接，连接风暴时一次唤醒处理一批，剩下的下次epoll_wait还会通知（水平触发）
 void Acceptor::handleRead() {
-    InetAddress peerAddr; // 客户端连接到来
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if(connfd >= 0) {
-        if(newConnectionCallback_) {
-            newConnectionCallback_(connfd, peerAddr);
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    for(int i = 0; i < acceptBatch_; ++i) {
+        InetAddress peerAddr; // 客户端连接到来
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if(connfd >= 0) {
+            accepted_.fetch_add(1, std::memory_order_relaxed);
+            if(newConnectionCallback_) {
+                newConnectionCallback_(connfd, peerAddr);
+            }
+            else {
+                ::close(connfd);
+            }
         }
-        else {
-            ::close(connfd);
+        else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+            break; // 全连接队列已经空了
         }
-    }
-    else {
-        LOG_ERROR("%s:%s:%d accept err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
-        if (errno == EMFILE)
-        {
+        else if(errno == EMFILE || errno == ENFILE) {
+            // 文件描述符耗尽，连接一直留在全连接队列中，listenfd会一直可读
+            fdExhausted_.fetch_add(1, std::memory_order_relaxed);
             LOG_ERROR("%s:%s:%d sockfd reached limit! \n", __FILE__, __FUNCTION__, __LINE__);
+            if(!shedConnection()) {
+                break; // 空闲fd也被别的线程用掉了，只能等下次唤醒
+            }
         }
+        else if(errno != EINTR && errno != ECONNABORTED && errno != EPROTO) {
+            LOG_ERROR("%s:%s:%d accept err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+            break;
+        }
+    }
+}
+
+// 释放预留的空闲fd，用它accept一个连接后立即关闭，对端会收到FIN，然后重新预留
+bool Acceptor::shedConnection() {
+    if(idleFd_ < 0) {
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        return false;
     }
-}
\ No newline at end of file
+    ::close(idleFd_);
+    int connfd = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+    if(connfd >= 0) {
+        ::close(connfd);
+        shed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return connfd >= 0;
+}
@@ -6,6 +6,8 @@
 #include "Channel.h"
 
 #include <functional>
+#include <atomic>
+#include <stdint.h>
 
 class EventLoop;
 class InetAddress;
@@ -13,21 +15,45 @@ class InetAddress;
 class Acceptor : noncopyable {
 public:
     using NewConnectionCallback = std::function<void(int sockfd, const InetAddress&)>;
+
+    // 统计信息，可以在任意线程中读取
+    struct Stats {
+        uint64_t wakeups; // listenfd可读的次数
+        uint64_t accepted; // accept成功的连接数
+        uint64_t shed; // 文件描述符耗尽时，用空闲fd接受后立即关闭的连接数
+        uint64_t fdExhausted; // accept返回EMFILE/ENFILE的次数
+    };
+
+    static const int kDefaultAcceptBatch = 16;
+
     Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport);
     ~Acceptor();
 
     void setNewConnectionCallback(const NewConnectionCallback& cb) {
         newConnectionCallback_ = cb;
     }
+    // 每次listenfd可读时最多accept的连接数
+    void setAcceptBatch(int batch) { acceptBatch_ = batch > 0 ? batch : 1; }
 
+    EventLoop* getLoop() const { return loop_; }
     bool listenning() const { return listening_; }
     void listen();
+
+    Stats stats() const;
 private:
     void handleRead();
+    bool shedConnection();
 
     EventLoop* loop_; // Acceptor用的就是用户定义的那个baseLoop，也称作mainLoop
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
     bool listening_;
-};
\ No newline at end of file
+    int acceptBatch_;
+    int idleFd_; // 预留的空闲fd，文件描述符耗尽时用它接受连接再关闭，避免listenfd一直可读导致loop空转
+
+    std::atomic<uint64_t> wakeups_;
+    std::atomic<uint64_t> accepted_;
+    std::atomic<uint64_t> shed_;
+    std::atomic<uint64_t> fdExhausted_;
+};
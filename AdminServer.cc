@@ -0,0 +1,26 @@
+#include "AdminServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "LoopMetrics.h"
+
+AdminServer::AdminServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& nameArg)
+    : server_(loop, listenAddr, nameArg)
+{
+    server_.setHttpCallback(
+        std::bind(&AdminServer::onRequest, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void AdminServer::onRequest(const HttpRequest& req, HttpResponse* resp) {
+    if(req.path() != "/metrics") {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        return;
+    }
+    if(req.method() != HttpRequest::kGet && req.method() != HttpRequest::kHead) {
+        resp->setStatusCode(HttpResponse::k405MethodNotAllowed);
+        resp->addHeader("Allow", "GET, HEAD");
+        return;
+    }
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setContentType("text/plain; version=0.0.4");
+    resp->setBody(LoopMetrics::prometheusText());
+}
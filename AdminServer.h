@@ -0,0 +1,23 @@
+#pragma once
+
+#include "HttpServer.h"
+#include "noncopyable.h"
+
+#include <string>
+
+/**
+ * 内置的管理端口，GET /metrics返回本进程所有EventLoop的统计，Prometheus文本格式
+ * 只在构造时传入的loop中处理请求，不开subLoop，一般放在mainLoop上，抓取时不会打扰处理业务的subLoop
+ * 统计是在请求到达时现场汇总的，不抓取时没有额外开销
+*/
+class AdminServer : noncopyable {
+public:
+    AdminServer(EventLoop* loop, const InetAddress& listenAddr,
+                const std::string& nameArg = "AdminServer");
+
+    void start() { server_.start(); }
+private:
+    void onRequest(const HttpRequest& req, HttpResponse* resp);
+
+    HttpServer server_;
+};
@@ -0,0 +1,261 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Timestamp.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+
+static std::atomic<uint64_t> s_numCreated(0);
+
+// 每个线程缓存最近使用的ThreadBuffer，避免每条日志都去查找注册表
+// 用对象序号而不是地址来判断缓存是否有效，防止对象销毁后新对象复用同一地址时拿到失效的缓冲区
+__thread uint64_t t_ownerId = 0;
+__thread void* t_threadBuffer = nullptr;
+
+// 一个线程可能轮流写多个AsyncLogging（比如访问日志和普通日志各一个），每个对象一项，来回切换时不会重新注册
+// 线程退出时析构，把自己的ThreadBuffer标记为已退出，剩下的日志由后端写完以后释放，短命的线程不会一直占着缓冲区
+struct AsyncLogging::ThreadBufferCache {
+    ~ThreadBufferCache() {
+        for(auto& entry : entries) {
+            std::unique_lock<std::mutex> lock(entry.second->mutex);
+            entry.second->exited = true;
+        }
+        t_ownerId = 0;
+        t_threadBuffer = nullptr;
+    }
+
+    std::vector<std::pair<uint64_t, ThreadBufferPtr>> entries;
+};
+
+AsyncLogging::AsyncLogging(const std::string& basename,
+                           off_t rollSize,
+                           int flushInterval,
+                           int maxBuffersPerThread)
+    : id_(++s_numCreated)
+    , flushInterval_(flushInterval)
+    , maxBuffersPerThread_(maxBuffersPerThread < 2 ? 2 : maxBuffersPerThread)
+    , running_(false)
+    , basename_(basename)
+    , rollSize_(rollSize)
+    , thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging")
+    , dropped_(0)
+    , reportedDropped_(0)
+{
+}
+
+AsyncLogging::~AsyncLogging() {
+    if(running_) {
+        stop();
+    }
+
+    // 还活着的线程的缓存中仍然引用着ThreadBuffer，先把缓冲区释放掉，只留下很小的ThreadBuffer等线程清理
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(const ThreadBufferPtr& tb : threadBuffers_) {
+        std::unique_lock<std::mutex> tbLock(tb->mutex);
+        tb->closed = true;
+        tb->current.reset();
+        tb->full.clear();
+        tb->spare.clear();
+    }
+}
+
+void AsyncLogging::start() {
+    {
+        std::unique_lock<std::mutex> lock(outputMutex_);
+        output_.reset(new LogFile(basename_, rollSize_, flushInterval_));
+    }
+    running_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+
+    std::unique_lock<std::mutex> lock(outputMutex_);
+    output_.reset();
+}
+
+void AsyncLogging::flush() {
+    std::unique_lock<std::mutex> lock(outputMutex_);
+    if(output_) {
+        writeBuffers(true);
+    }
+}
+
+// 当前线程的前端缓冲区，第一次写日志时注册
+AsyncLogging::ThreadBuffer* AsyncLogging::threadBuffer() {
+    if(t_ownerId != id_) {
+        t_threadBuffer = findThreadBuffer();
+        t_ownerId = id_;
+    }
+    return static_cast<ThreadBuffer*>(t_threadBuffer);
+}
+
+AsyncLogging::ThreadBuffer* AsyncLogging::findThreadBuffer() {
+    static thread_local ThreadBufferCache cache;
+
+    for(const auto& entry : cache.entries) {
+        if(entry.first == id_) {
+            return entry.second.get();
+        }
+    }
+
+    // 第一次写这个对象，顺便丢掉已经析构的对象留下的项
+    for(auto it = cache.entries.begin(); it != cache.entries.end(); ) {
+        bool closed = false;
+        {
+            std::unique_lock<std::mutex> lock(it->second->mutex);
+            closed = it->second->closed;
+        }
+        it = closed ? cache.entries.erase(it) : it + 1;
+    }
+
+    ThreadBufferPtr tb(std::make_shared<ThreadBuffer>());
+    tb->current.reset(new Buffer);
+    tb->allocated = 1;
+    tb->exited = false;
+    tb->closed = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        threadBuffers_.push_back(tb);
+    }
+    cache.entries.push_back(std::make_pair(id_, tb));
+    return tb.get();
+}
+
+void AsyncLogging::append(const char* logline, size_t len) {
+    ThreadBuffer* tb = threadBuffer();
+    bool notify = false;
+    {
+        std::unique_lock<std::mutex> lock(tb->mutex);
+        if(tb->current && tb->current->append(logline, len)) {
+            return; // 绝大多数情况只是一次memcpy
+        }
+
+        if(tb->current) { // 当前缓冲区写满了，交给后端
+            tb->full.push_back(std::move(tb->current));
+            notify = true;
+        }
+
+        if(!tb->spare.empty()) {
+            tb->current = std::move(tb->spare.back());
+            tb->spare.pop_back();
+        }
+        else if(tb->allocated < maxBuffersPerThread_) {
+            tb->current.reset(new Buffer);
+            ++tb->allocated;
+        }
+
+        // 缓冲区用完了说明后端跟不上，丢弃日志保证内存有上限
+        if(!tb->current || !tb->current->append(logline, len)) {
+            ++dropped_;
+        }
+    }
+    if(notify) {
+        cond_.notify_one();
+    }
+}
+
+void AsyncLogging::collect(BufferVector* buffersToWrite,
+                           std::vector<ThreadBufferPtr>* owners,
+                           bool flushCurrent)
+{
+    std::vector<ThreadBufferPtr> threadBuffers;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        threadBuffers = threadBuffers_;
+    }
+
+    std::vector<ThreadBuffer*> exited;
+    for(const ThreadBufferPtr& tb : threadBuffers) {
+        std::unique_lock<std::mutex> lock(tb->mutex);
+        for(BufferPtr& buffer : tb->full) {
+            buffersToWrite->push_back(std::move(buffer));
+            owners->push_back(tb);
+        }
+        tb->full.clear();
+
+        // 超时唤醒时把没写满的缓冲区也换出来，日志量小的时候也能及时落盘
+        // 线程已经退出时不会再写了，没写满的缓冲区也一起写出，空闲缓冲区直接释放
+        if((flushCurrent || tb->exited) && tb->current && tb->current->length() > 0) {
+            buffersToWrite->push_back(std::move(tb->current));
+            owners->push_back(tb);
+            if(!tb->spare.empty()) {
+                tb->current = std::move(tb->spare.back());
+                tb->spare.pop_back();
+            }
+            else if(!tb->exited && tb->allocated < maxBuffersPerThread_) {
+                tb->current.reset(new Buffer);
+                ++tb->allocated;
+            }
+        }
+        if(tb->exited) {
+            tb->current.reset();
+            tb->spare.clear();
+            exited.push_back(tb.get());
+        }
+    }
+
+    if(!exited.empty()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        threadBuffers_.erase(std::remove_if(threadBuffers_.begin(), threadBuffers_.end(),
+            [&exited](const ThreadBufferPtr& tb) {
+                return std::find(exited.begin(), exited.end(), tb.get()) != exited.end();
+            }), threadBuffers_.end());
+    }
+}
+
+void AsyncLogging::writeBuffers(bool flushCurrent) {
+    collect(&buffersToWrite_, &owners_, flushCurrent);
+
+    uint64_t dropped = dropped_;
+    if(dropped != reportedDropped_) {
+        char buf[256];
+        int n = snprintf(buf, sizeof buf, "[ERROR]%s:Dropped %lu log records, %lu in total\n",
+                         Timestamp::now().tostring().c_str(),
+                         static_cast<unsigned long>(dropped - reportedDropped_),
+                         static_cast<unsigned long>(dropped));
+        output_->append(buf, n);
+        reportedDropped_ = dropped;
+    }
+
+    for(const BufferPtr& buffer : buffersToWrite_) {
+        output_->append(buffer->data(), buffer->length());
+    }
+
+    // 写完的缓冲区还给对应的前端线程，线程已经退出的直接释放
+    for(size_t i = 0; i < buffersToWrite_.size(); ++i) {
+        buffersToWrite_[i]->reset();
+        std::unique_lock<std::mutex> lock(owners_[i]->mutex);
+        if(!owners_[i]->exited && !owners_[i]->closed) {
+            owners_[i]->spare.push_back(std::move(buffersToWrite_[i]));
+        }
+    }
+    buffersToWrite_.clear();
+    owners_.clear(); // 已经退出的线程的ThreadBuffer在这里释放
+    output_->flush();
+}
+
+void AsyncLogging::threadFunc() {
+    bool stopping = false;
+    while(!stopping) {
+        bool timeout = true;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(running_) {
+                timeout = cond_.wait_for(lock, std::chrono::seconds(flushInterval_))
+                    == std::cv_status::timeout;
+            }
+        }
+        // 停止前最后再收集一次，把所有线程缓冲区中的日志都写入文件
+        stopping = !running_;
+        std::unique_lock<std::mutex> lock(outputMutex_);
+        writeBuffers(timeout || stopping);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+#include "FixedBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * 异步日志后端
+ * 前端：每个写日志的线程有自己的缓冲区（ThreadBuffer），写日志只是一次memcpy，锁只和后端线程竞争
+ * 后端：一个专门的线程定期把所有线程写满的缓冲区换出来，批量写入滚动日志文件，再把空缓冲区还给前端
+ * 每个线程最多持有maxBuffersPerThread块缓冲区，后端来不及写时直接丢弃日志并计数，内存有上限
+ *
+ * 使用方法：
+ *   AsyncLogging log("/tmp/server", 500 * 1000 * 1000);
+ *   log.start();
+ *   Logger::instance().setOutput(std::bind(&AsyncLogging::append, &log, _1, _2));
+ *   Logger::instance().setFlush(std::bind(&AsyncLogging::flush, &log)); // LOG_FATAL退出前把缓冲区中的日志写进文件
+*/
+class LogFile;
+
+class AsyncLogging : noncopyable {
+public:
+    AsyncLogging(const std::string& basename,
+                 off_t rollSize,
+                 int flushInterval = 3,
+                 int maxBuffersPerThread = 4);
+    ~AsyncLogging();
+
+    // 前端接口，可以在任意线程中调用
+    void append(const char* logline, size_t len);
+
+    void start();
+    // 停止后端线程，停止前会把所有线程缓冲区中的日志写入文件
+    void stop();
+    // 在调用者线程中同步地把所有线程缓冲区（包括没写满的）写入文件并fflush，可以在任意线程中调用
+    // 给Logger::setFlush使用，LOG_FATAL调用exit之前日志不会留在缓冲区中丢失；start之前或stop之后调用什么都不做
+    void flush();
+
+    // 因为后端来不及处理而被丢弃的日志条数
+    uint64_t droppedRecords() const { return dropped_; }
+private:
+    using Buffer = FixedBuffer<kLargeBuffer>;
+    using BufferPtr = std::unique_ptr<Buffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    // 每个前端线程一个，mutex只在前端和后端线程之间竞争
+    struct ThreadBuffer {
+        std::mutex mutex;
+        BufferPtr current; // 正在写入的缓冲区
+        BufferVector full; // 已写满，等待后端写入文件
+        BufferVector spare; // 后端写完还回来的空缓冲区
+        int allocated; // 已经分配的缓冲区个数
+        bool exited; // 所属线程已经退出，后端写完剩下的日志以后从threadBuffers_中删除
+        bool closed; // AsyncLogging已经析构，线程下次查找缓存时丢弃这一项
+    };
+    using ThreadBufferPtr = std::shared_ptr<ThreadBuffer>;
+    // 每个线程一个，记录这个线程在各个AsyncLogging对象中的ThreadBuffer，见AsyncLogging.cc
+    struct ThreadBufferCache;
+
+    ThreadBuffer* threadBuffer();
+    // 缓存中没有当前对象的ThreadBuffer时查找或者注册
+    ThreadBuffer* findThreadBuffer();
+    // 把所有线程的缓冲区换出来，flushCurrent为true时没写满的缓冲区也换出来，线程已经退出的ThreadBuffer从注册表中删除
+    void collect(BufferVector* buffersToWrite, std::vector<ThreadBufferPtr>* owners, bool flushCurrent);
+    // 收集缓冲区并写入output_，调用者持有outputMutex_
+    void writeBuffers(bool flushCurrent);
+    void threadFunc();
+
+    const uint64_t id_; // 区分不同的AsyncLogging对象，见threadBuffer()
+    const int flushInterval_;
+    const int maxBuffersPerThread_;
+    std::atomic_bool running_;
+    const std::string basename_;
+    const off_t rollSize_;
+    Thread thread_;
+
+    // 后端线程和flush()都会写文件，outputMutex_保证收集和写入的顺序一致
+    // 加锁顺序：outputMutex_ -> mutex_ -> ThreadBuffer::mutex
+    std::mutex outputMutex_;
+    std::unique_ptr<LogFile> output_; // start时创建，stop时关闭
+    BufferVector buffersToWrite_;
+    std::vector<ThreadBufferPtr> owners_;
+
+    std::mutex mutex_; // 保护threadBuffers_
+    std::condition_variable cond_;
+    std::vector<ThreadBufferPtr> threadBuffers_; // 线程的缓存也持有一份，线程先退出或者对象先析构都不会悬空
+
+    std::atomic<uint64_t> dropped_;
+    uint64_t reportedDropped_; // 已经在日志文件中报告过的丢弃条数，outputMutex_保护
+};
@@ -0,0 +1,108 @@
+#include "BlockPool.h"
+#include "CurrentThread.h"
+
+#include <new>
+
+const size_t BlockPool::kDefaultMaxCachedBlocks;
+
+BlockPool::BlockPool(size_t maxCachedBlocks)
+    : threadId_(CurrentThread::tid())
+    , maxCachedBlocks_(maxCachedBlocks)
+    , blockSize_(0)
+    , freeList_(nullptr)
+    , blocksCached_(0)
+    , allocations_(0)
+    , systemAllocations_(0)
+    , remoteFreeList_(nullptr)
+    , blocksInUse_(0)
+    , remoteFrees_(0)
+{
+}
+
+// 所有PoolAllocator都已经析构，不会再有其它线程归还内存块
+BlockPool::~BlockPool() {
+    reclaimRemoteBlocks();
+    while(freeList_ != nullptr) {
+        FreeBlock* next = freeList_->next;
+        ::operator delete(freeList_);
+        freeList_ = next;
+    }
+}
+
+void* BlockPool::allocate(size_t size) {
+    ++allocations_;
+    blocksInUse_.fetch_add(1, std::memory_order_relaxed);
+    if(blockSize_ == 0 && size >= sizeof(FreeBlock)) {
+        blockSize_ = size;
+    }
+    if(size != blockSize_) {
+        return ::operator new(size);
+    }
+
+    if(freeList_ == nullptr) {
+        reclaimRemoteBlocks();
+    }
+    if(freeList_ != nullptr) {
+        FreeBlock* block = freeList_;
+        freeList_ = block->next;
+        --blocksCached_;
+        return block;
+    }
+    ++systemAllocations_;
+    return ::operator new(size);
+}
+
+void BlockPool::deallocate(void* block, size_t size) {
+    blocksInUse_.fetch_sub(1, std::memory_order_relaxed);
+    if(size != blockSize_) {
+        ::operator delete(block);
+        return;
+    }
+
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    if(CurrentThread::tid() == threadId_) {
+        if(blocksCached_ >= maxCachedBlocks_) {
+            ::operator delete(block);
+            return;
+        }
+        freeBlock->next = freeList_;
+        freeList_ = freeBlock;
+        ++blocksCached_;
+        return;
+    }
+
+    // 其它线程：压进无锁栈，由所属线程取回
+    remoteFrees_.fetch_add(1, std::memory_order_relaxed);
+    freeBlock->next = remoteFreeList_.load(std::memory_order_relaxed);
+    while(!remoteFreeList_.compare_exchange_weak(freeBlock->next, freeBlock,
+                                                 std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+// 整个栈一次取走，不会有ABA问题；取回的内存块放进空闲链表，超出缓存上限的部分直接还给系统
+void BlockPool::reclaimRemoteBlocks() {
+    FreeBlock* block = remoteFreeList_.exchange(nullptr, std::memory_order_acquire);
+    while(block != nullptr) {
+        FreeBlock* next = block->next;
+        if(blocksCached_ < maxCachedBlocks_) {
+            block->next = freeList_;
+            freeList_ = block;
+            ++blocksCached_;
+        }
+        else {
+            ::operator delete(block);
+        }
+        block = next;
+    }
+}
+
+BlockPool::Stats BlockPool::stats() const {
+    Stats stats;
+    stats.blockSize = blockSize_;
+    stats.blocksInUse = blocksInUse_.load(std::memory_order_relaxed);
+    stats.blocksCached = blocksCached_;
+    stats.allocations = allocations_;
+    stats.systemAllocations = systemAllocations_;
+    stats.remoteFrees = remoteFrees_.load(std::memory_order_relaxed);
+    return stats;
+}
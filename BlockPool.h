@@ -0,0 +1,95 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * 每个EventLoop一个的定长内存块池，给TcpConnection使用
+ * TcpServer用allocate_shared + PoolAllocator创建连接，shared_ptr的控制块和TcpConnection（连同内嵌的Socket、Channel）
+ * 在同一个内存块中，连接析构后内存块回到创建它的loop的空闲链表，下一个连接直接复用，不经过malloc
+ *
+ * 只在所属loop的线程中分配；连接的最后一个引用经常在其它线程（subLoop）中释放，这些内存块先压进一个无锁栈，
+ * 所属loop下次分配时一次全部取回，内存总是回到所属loop，各个线程之间不争用malloc的锁
+ * 第一次分配的大小就是块大小，大小不同的请求直接使用operator new；空闲链表最多缓存maxCachedBlocks个
+ *
+ * PoolAllocator持有BlockPool的shared_ptr，内存块全部归还之前BlockPool不会析构，即使所属的EventLoop已经退出
+*/
+class BlockPool : noncopyable {
+public:
+    struct Stats {
+        size_t blockSize;
+        size_t blocksInUse; // 正在被连接使用的内存块个数
+        size_t blocksCached; // 空闲链表中的内存块个数，不含其它线程归还、还没有取回的
+        size_t allocations; // allocate调用次数
+        size_t systemAllocations; // 空闲链表为空，向系统申请内存的次数
+        size_t remoteFrees; // 在其它线程中归还的次数
+    };
+
+    static const size_t kDefaultMaxCachedBlocks = 4096;
+
+    // 在所属loop的线程中构造
+    explicit BlockPool(size_t maxCachedBlocks = kDefaultMaxCachedBlocks);
+    ~BlockPool();
+
+    void* allocate(size_t size);
+    // size必须和allocate时相同，可以在任意线程中调用
+    void deallocate(void* block, size_t size);
+
+    // 除blocksInUse和remoteFrees以外的字段都是普通变量，只能在所属loop的线程中调用
+    Stats stats() const;
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    void reclaimRemoteBlocks();
+
+    const pid_t threadId_; // 所属loop的线程
+    const size_t maxCachedBlocks_;
+    size_t blockSize_; // 0表示还没有分配过
+
+    FreeBlock* freeList_; // 只在所属线程中访问
+    size_t blocksCached_;
+    size_t allocations_;
+    size_t systemAllocations_;
+
+    std::atomic<FreeBlock*> remoteFreeList_; // 其它线程归还的内存块，多个线程压栈，所属线程整个取走
+    std::atomic<size_t> blocksInUse_;
+    std::atomic<size_t> remoteFrees_;
+};
+
+// 从BlockPool分配内存的分配器，给std::allocate_shared使用
+template<typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(const std::shared_ptr<BlockPool>& pool)
+        : pool_(pool)
+    {}
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other)
+        : pool_(other.pool())
+    {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool_->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+    const std::shared_ptr<BlockPool>& pool() const { return pool_; }
+private:
+    std::shared_ptr<BlockPool> pool_;
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs) {
+    return lhs.pool() == rhs.pool();
+}
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs) {
+    return lhs.pool() != rhs.pool();
+}
@@ -1,16 +1,145 @@
 #include "Buffer.h"
+#include "BufferPool.h"
+#include "Logger.h"
 
 #include <errno.h>
+#include <stdlib.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+
+// 从内存池或者系统申请至少size字节
+static char* allocateStorage(BufferPool* pool, size_t size, size_t* capacity) {
+    if(pool != nullptr) {
+        return pool->allocate(size, capacity);
+    }
+    char* storage = static_cast<char*>(::malloc(size));
+    if(storage == nullptr) {
+        LOG_FATAL("Buffer allocate %lu bytes failed \n", size);
+    }
+    *capacity = size;
+    return storage;
+}
+
+static void freeStorage(BufferPool* pool, char* storage, size_t capacity) {
+    if(pool != nullptr) {
+        pool->deallocate(storage, capacity);
+    }
+    else {
+        ::free(storage);
+    }
+}
+
+Buffer::Buffer(size_t initialSize, BufferPool* pool)
+    : buffer_(nullptr)
+    , capacity_(0)
+    , readerIndex_(kCheapPrepend)
+    , writerIndex_(kCheapPrepend)
+    , pool_(pool)
+{
+    if(pool_ == nullptr) {
+        buffer_ = allocateStorage(nullptr, kCheapPrepend + initialSize, &capacity_);
+    }
+}
+
+Buffer::~Buffer() {
+    if(buffer_ != nullptr) {
+        freeStorage(pool_, buffer_, capacity_);
+    }
+}
+
+Buffer::Buffer(const Buffer& rhs)
+    : buffer_(nullptr)
+    , capacity_(0)
+    , readerIndex_(rhs.readerIndex_)
+    , writerIndex_(rhs.writerIndex_)
+    , pool_(nullptr)
+{
+    if(rhs.buffer_ != nullptr) {
+        buffer_ = allocateStorage(nullptr, rhs.capacity_, &capacity_);
+        ::memcpy(buffer_, rhs.buffer_, rhs.writerIndex_);
+    }
+}
+
+void Buffer::releaseStorage() {
+    if(buffer_ != nullptr) {
+        freeStorage(pool_, buffer_, capacity_);
+        buffer_ = nullptr;
+        capacity_ = 0;
+    }
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = kCheapPrepend;
+}
+
+char* Buffer::detachStorage(size_t* capacity, size_t* readerIndex, size_t* writerIndex) {
+    char* storage = buffer_;
+    *capacity = capacity_;
+    *readerIndex = readerIndex_;
+    *writerIndex = writerIndex_;
+    buffer_ = nullptr;
+    capacity_ = 0;
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = kCheapPrepend;
+    return storage;
+}
+
+void Buffer::makeSpace(size_t len) {
+    if(writableBytes() + prependableBytes() < len + kCheapPrepend || buffer_ == nullptr) {
+        // 空间不够，申请一块新的内存，只拷贝可读的数据
+        // 按两倍扩容，内存池的内存块大小也是按两倍分级的，超出最大分级的大块内存同样要避免每次只扩一点
+        size_t readable = readableBytes();
+        size_t size = std::max(kCheapPrepend + readable + len, capacity_ * 2);
+        size_t capacity = 0;
+        char* storage = allocateStorage(pool_, size, &capacity);
+        if(buffer_ != nullptr) {
+            ::memcpy(storage + kCheapPrepend, begin() + readerIndex_, readable);
+            freeStorage(pool_, buffer_, capacity_);
+        }
+        buffer_ = storage;
+        capacity_ = capacity;
+        readerIndex_ = kCheapPrepend;
+        writerIndex_ = kCheapPrepend + readable;
+    }
+    else {
+        size_t readable = readableBytes();
+        std::copy(begin() + readerIndex_,
+                  begin() + writerIndex_, 
+                  begin() + kCheapPrepend);
+        readerIndex_ = kCheapPrepend;
+        writerIndex_ = readerIndex_ + readable;
+    }
+}
+
+// 预留空间不够放下len字节时，重新分配内存，可读数据前面留出len字节
+void Buffer::makePrependSpace(size_t len) {
+    size_t readable = readableBytes();
+    size_t prepend = std::max(len, kCheapPrepend);
+    size_t capacity = 0;
+    char* storage = allocateStorage(pool_, prepend + readable + std::max(writableBytes(), kCheapPrepend), &capacity);
+    if(buffer_ != nullptr) {
+        ::memcpy(storage + prepend, begin() + readerIndex_, readable);
+        freeStorage(pool_, buffer_, capacity_);
+    }
+    buffer_ = storage;
+    capacity_ = capacity;
+    readerIndex_ = prepend;
+    writerIndex_ = prepend + readable;
+}
+
 /**
  * 从fd上读取数据  Poller工作在LT模式
  * Buffer缓冲区是有大小的！ 但是从fd上读数据的时候，却不知道tcp数据最终的大小
  */ 
 // 从fd上读取数据
 ssize_t Buffer::readFd(int fd, int* saveErrno) {
-    char extrabuf[65536] = {0}; // 栈上的内存空间 64K
+    char extrabuf[65536]; // 栈上的内存空间 64K
+
+    // 使用内存池的Buffer在空闲时不持有内存，读之前先取一个最小的内存块
+    if(buffer_ == nullptr) {
+        ensureWriteableBytes(BufferPool::kMinChunkSize - kCheapPrepend);
+    }
 
     struct iovec vec[2];
 
@@ -30,9 +159,13 @@ ssize_t Buffer::readFd(int fd, int* saveErrno) {
         writerIndex_ += n;
     }
     else { // extrabuf里面也写入了数据
-        writerIndex_ = buffer_.size();
+        writerIndex_ = capacity_;
         append(extrabuf, n - writable);
     }
+
+    if(pool_ != nullptr && readableBytes() == 0) {
+        releaseStorage(); // 没有读到数据，不占用内存块
+    }
     return n;
 }   
 
@@ -1,8 +1,13 @@
 #pragma once 
 
-#include <vector>
 #include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+#include <endian.h>
 #include <string>
+#include <algorithm>
+
+class BufferPool;
 
 /// A buffer class modeled after org.jboss.netty.buffer.ChannelBuffer
 ///
@@ -21,18 +26,24 @@ public:
     static const size_t kCheapPrepend = 8; // 预先准备的字节数
     static const size_t kInitialSize = 1024;
 
-    explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize)
-        , readerIndex_(kCheapPrepend)
-        , writerIndex_(kCheapPrepend)
-    { }
+    // pool为空时和原来一样，构造时就分配kCheapPrepend + initialSize字节
+    // 指定pool时不预先分配，需要写入数据时才从内存池中取内存块，数据被取完时归还给内存池
+    explicit Buffer(size_t initialSize = kInitialSize, BufferPool* pool = nullptr);
+    ~Buffer();
+
+    // 拷贝得到的Buffer不使用内存池
+    Buffer(const Buffer& rhs);
+    Buffer& operator=(Buffer rhs) {
+        swap(rhs);
+        return *this;
+    }
 
     size_t readableBytes() const {
         return writerIndex_ - readerIndex_;
     }
 
     size_t writableBytes() const {
-        return buffer_.size() - writerIndex_;
+        return capacity_ > writerIndex_ ? capacity_ - writerIndex_ : 0;
     }
 
     size_t prependableBytes() const {
@@ -58,6 +69,9 @@ public:
     void retrieveAll() {
         readerIndex_ = kCheapPrepend;
         writerIndex_ = kCheapPrepend;
+        if(pool_ != nullptr) {
+            releaseStorage(); // 数据取完了，内存块还给内存池
+        }
     }
 
     // 把onMessage函数上报的Buffer数据，转成string类型的数据返回
@@ -78,7 +92,7 @@ public:
         return result;
     }
 
-    // writableBytes() = buffer_.size() - writerIndex_
+    // writableBytes() = capacity_ - writerIndex_
     void ensureWriteableBytes(size_t len) {
         if(writableBytes() < len) {
             makeSpace(len); // 扩容函数
@@ -92,6 +106,127 @@ public:
         writerIndex_ += len;
     }
 
+    void append(const std::string& str) {
+        append(str.data(), str.size());
+    }
+
+    // 以网络字节序追加整数
+    void appendInt64(int64_t x) {
+        uint64_t be = htobe64(static_cast<uint64_t>(x));
+        append(reinterpret_cast<const char*>(&be), sizeof be);
+    }
+
+    void appendInt32(int32_t x) {
+        uint32_t be = htobe32(static_cast<uint32_t>(x));
+        append(reinterpret_cast<const char*>(&be), sizeof be);
+    }
+
+    void appendInt16(int16_t x) {
+        uint16_t be = htobe16(static_cast<uint16_t>(x));
+        append(reinterpret_cast<const char*>(&be), sizeof be);
+    }
+
+    void appendInt8(int8_t x) {
+        append(reinterpret_cast<const char*>(&x), sizeof x);
+    }
+
+    // 以网络字节序读取整数，不取走数据，调用者保证readableBytes()足够
+    int64_t peekInt64() const {
+        uint64_t be = 0;
+        ::memcpy(&be, peek(), sizeof be);
+        return static_cast<int64_t>(be64toh(be));
+    }
+
+    int32_t peekInt32() const {
+        uint32_t be = 0;
+        ::memcpy(&be, peek(), sizeof be);
+        return static_cast<int32_t>(be32toh(be));
+    }
+
+    int16_t peekInt16() const {
+        uint16_t be = 0;
+        ::memcpy(&be, peek(), sizeof be);
+        return static_cast<int16_t>(be16toh(be));
+    }
+
+    int8_t peekInt8() const {
+        return static_cast<int8_t>(*peek());
+    }
+
+    // 以网络字节序读取整数并取走，调用者保证readableBytes()足够
+    int64_t readInt64() {
+        int64_t result = peekInt64();
+        retrieve(sizeof result);
+        return result;
+    }
+
+    int32_t readInt32() {
+        int32_t result = peekInt32();
+        retrieve(sizeof result);
+        return result;
+    }
+
+    int16_t readInt16() {
+        int16_t result = peekInt16();
+        retrieve(sizeof result);
+        return result;
+    }
+
+    int8_t readInt8() {
+        int8_t result = peekInt8();
+        retrieve(sizeof result);
+        return result;
+    }
+
+    // 把数据放到可读数据的前面，使用kCheapPrepend预留的空间，不移动已有数据
+    // 先写消息体再补长度头的协议不需要为了加头拷贝一次消息体
+    void prepend(const void* data, size_t len) {
+        if(prependableBytes() < len || buffer_ == nullptr) {
+            makePrependSpace(len);
+        }
+        readerIndex_ -= len;
+        ::memcpy(begin() + readerIndex_, data, len);
+    }
+
+    void prependInt64(int64_t x) {
+        uint64_t be = htobe64(static_cast<uint64_t>(x));
+        prepend(&be, sizeof be);
+    }
+
+    void prependInt32(int32_t x) {
+        uint32_t be = htobe32(static_cast<uint32_t>(x));
+        prepend(&be, sizeof be);
+    }
+
+    void prependInt16(int16_t x) {
+        uint16_t be = htobe16(static_cast<uint16_t>(x));
+        prepend(&be, sizeof be);
+    }
+
+    void prependInt8(int8_t x) {
+        prepend(&x, sizeof x);
+    }
+
+    // 在[start, beginWrite())中查找"\r\n"，没有找到返回nullptr
+    const char* findCRLF(const char* start) const {
+        const char* end = beginWrite();
+        while(start < end) {
+            const char* cr = static_cast<const char*>(::memchr(start, '\r', end - start));
+            if(cr == nullptr || cr + 1 >= end) {
+                return nullptr;
+            }
+            if(cr[1] == '\n') {
+                return cr;
+            }
+            start = cr + 1;
+        }
+        return nullptr;
+    }
+
+    const char* findCRLF() const {
+        return findCRLF(peek());
+    }
+
     char* beginWrite() {
         return begin() + writerIndex_;
     }
@@ -100,34 +235,43 @@ public:
         return begin() + writerIndex_;
     }
 
+    // 交换两个缓冲区的内容，不拷贝数据
+    void swap(Buffer& rhs) {
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(readerIndex_, rhs.readerIndex_);
+        std::swap(writerIndex_, rhs.writerIndex_);
+        std::swap(pool_, rhs.pool_);
+    }
+
+    BufferPool* pool() const { return pool_; }
+    // 当前占用的内存大小
+    size_t internalCapacity() const { return capacity_; }
+    // 归还底层内存，可读数据会被丢弃，TcpConnection在loop线程中销毁连接时调用
+    void releaseStorage();
+    // 交出底层内存，不拷贝，调用后Buffer为空；调用者负责按pool()归还内存块，数据在[readerIndex, writerIndex)中
+    // OutputChain接管send(Buffer*)的数据时使用，没有内存时返回nullptr
+    char* detachStorage(size_t* capacity, size_t* readerIndex, size_t* writerIndex);
+
     // 从fd上读取数据
     ssize_t readFd(int fd, int* saveErrno);
     // 从fd上发送数据
     ssize_t writeFd(int fd, int* saveErnno);
 private:
     char* begin() {
-        // it.operator*()
-        return &*buffer_.begin(); // vector底层数组首元素的地址，也就是数组的起始地址
+        return buffer_; // 底层数组的起始地址
     }
 
     const char* begin() const {
-        return &*buffer_.begin();
+        return buffer_;
     }
 
-    void makeSpace(size_t len) {
-        if(writableBytes() + prependableBytes() < len + kCheapPrepend) {
-            buffer_.resize(writerIndex_ + len);
-        }
-        else {
-            size_t readable = readableBytes();
-            std::copy(begin() + readerIndex_,
-                      begin() + writerIndex_, 
-                      begin() + kCheapPrepend);
-            writerIndex_ = readerIndex_ + readable;
-        }
-    }
+    void makeSpace(size_t len);
+    void makePrependSpace(size_t len);
 
-    std::vector<char> buffer_;
+    char* buffer_;
+    size_t capacity_;
     size_t readerIndex_; // 变量被用于表示缓冲区读取指针位置索引值
     size_t writerIndex_; // C中任何对象所能达到的最大长度，它是无符号整数,在数组下标和内存管理函数之类的地方广泛使用
+    BufferPool* pool_; // 为空时使用malloc/free
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "BufferPool.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <stdlib.h>
+
+const size_t BufferPool::kMinChunkSize;
+const size_t BufferPool::kDefaultMaxCachedBytes;
+
+BufferPool::BufferPool(EventLoop* loop, size_t maxCachedBytes)
+    : loop_(loop)
+    , maxCachedBytes_(maxCachedBytes)
+    , bytesCached_(0)
+    , allocations_(0)
+    , systemAllocations_(0)
+    , oversizeAllocations_(0)
+    , chunksInUse_(0)
+    , bytesInUse_(0)
+{
+}
+
+BufferPool::~BufferPool() {
+    for(int i = 0; i < kNumClasses; ++i) {
+        for(char* chunk : freeLists_[i]) {
+            ::free(chunk);
+        }
+    }
+}
+
+// size所属的级别，超过最大级别返回-1
+int BufferPool::classOf(size_t size) {
+    size_t chunkSize = kMinChunkSize;
+    for(int i = 0; i < kNumClasses; ++i) {
+        if(size <= chunkSize) {
+            return i;
+        }
+        chunkSize <<= 1;
+    }
+    return -1;
+}
+
+char* BufferPool::allocate(size_t size, size_t* capacity) {
+    ++allocations_;
+    ++chunksInUse_;
+
+    int cls = classOf(size);
+    if(cls < 0) {
+        ++oversizeAllocations_;
+        *capacity = size;
+        bytesInUse_ += size;
+        return static_cast<char*>(::malloc(size));
+    }
+
+    *capacity = kMinChunkSize << cls;
+    bytesInUse_ += *capacity;
+    std::vector<char*>& freeList = freeLists_[cls];
+    if(!freeList.empty()) {
+        char* chunk = freeList.back();
+        freeList.pop_back();
+        bytesCached_ -= *capacity;
+        return chunk;
+    }
+
+    ++systemAllocations_;
+    char* chunk = static_cast<char*>(::malloc(*capacity));
+    if(chunk == nullptr) {
+        LOG_FATAL("BufferPool::allocate %lu bytes failed \n", *capacity);
+    }
+    return chunk;
+}
+
+void BufferPool::deallocate(char* chunk, size_t capacity) {
+    --chunksInUse_;
+    bytesInUse_ -= capacity;
+
+    int cls = classOf(capacity);
+    // 超大内存块、其它线程归还的内存块、缓存已满时，直接还给系统
+    if(cls < 0 || !loop_->isInLoopThread() || bytesCached_ + capacity > maxCachedBytes_) {
+        ::free(chunk);
+        return;
+    }
+    freeLists_[cls].push_back(chunk);
+    bytesCached_ += capacity;
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats stats;
+    stats.chunksInUse = chunksInUse_;
+    stats.bytesInUse = bytesInUse_;
+    stats.chunksCached = 0;
+    for(int i = 0; i < kNumClasses; ++i) {
+        stats.chunksCached += freeLists_[i].size();
+    }
+    stats.bytesCached = bytesCached_;
+    stats.allocations = allocations_;
+    stats.systemAllocations = systemAllocations_;
+    stats.oversizeAllocations = oversizeAllocations_;
+    return stats;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+class EventLoop;
+
+/**
+ * 每个EventLoop一个的缓冲区内存池，给连接的Buffer和OutputChain提供内存块
+ * 按大小分级：4K, 8K, ... 1M，每一级是一个空闲链表，超过1M的直接malloc，归还时直接free
+ * Buffer中的数据被取完时就把内存块还给内存池，空闲连接不占用缓冲区内存，
+ * 内存池缓存的空闲内存块总大小不超过maxCachedBytes，多出来的还给系统，内存占用跟随实际的数据量而不是历史峰值
+ *
+ * 只在loop线程中分配；在其它线程中归还（比如连接在其它线程析构）时直接free，不进入空闲链表
+*/
+class BufferPool : noncopyable {
+public:
+    struct Stats {
+        size_t chunksInUse; // 正在被Buffer使用的内存块个数
+        size_t bytesInUse;
+        size_t chunksCached; // 空闲链表中的内存块个数
+        size_t bytesCached;
+        size_t allocations; // allocate调用次数
+        size_t systemAllocations; // 空闲链表为空，向系统申请内存的次数
+        size_t oversizeAllocations; // 超过最大级别，直接malloc的次数
+    };
+
+    static const size_t kMinChunkSize = 4096;
+    static const int kNumClasses = 9; // 4K << 8 = 1M
+    static const size_t kDefaultMaxCachedBytes = 16 * 1024 * 1024;
+
+    explicit BufferPool(EventLoop* loop, size_t maxCachedBytes = kDefaultMaxCachedBytes);
+    ~BufferPool();
+
+    // 分配至少size字节的内存块，实际容量通过capacity返回
+    char* allocate(size_t size, size_t* capacity);
+    // capacity必须是allocate返回的容量
+    void deallocate(char* chunk, size_t capacity);
+
+    Stats stats() const;
+private:
+    static int classOf(size_t size);
+
+    EventLoop* loop_;
+    const size_t maxCachedBytes_;
+    std::vector<char*> freeLists_[kNumClasses];
+    size_t bytesCached_;
+    size_t allocations_;
+    size_t systemAllocations_;
+    size_t oversizeAllocations_;
+
+    // 可能在其它线程中归还，使用原子变量
+    std::atomic<size_t> chunksInUse_;
+    std::atomic<size_t> bytesInUse_;
+};
@@ -2,12 +2,16 @@
 
 #include <memory>
 #include <functional>
+#include <stdint.h>
 
 class Buffer;
 class TcpConnection;
 class Timestamp;
 
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+// TcpServer分配的连接ID，见ConnectionRegistry；TcpClient和连接池建立的连接为0
+using ConnectionId = uint64_t;
+using TimerCallback = std::function<void()>;
 using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
@@ -15,4 +19,13 @@ using MessageCallback = std::function<void(const TcpConnectionPtr&,
                                         Buffer*,
                                         Timestamp)>;
 using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
-// 高水位，发送方发送快，接收方接收慢，会造成数据丢失
\ No newline at end of file
+
+// TcpServer的所有连接共用一份回调，TcpConnection只保存指针，不为每个连接拷贝std::function
+struct ConnectionCallbacks {
+    ConnectionCallback connection;
+    MessageCallback message;
+    WriteCompleteCallback writeComplete;
+    CloseCallback close;
+};
+using ConnectionCallbacksPtr = std::shared_ptr<ConnectionCallbacks>;
+// 高水位，发送方发送快，接收方接收慢，会造成数据丢失
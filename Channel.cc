@@ -8,13 +8,67 @@ const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
 
+// 把四个回调函数对象包装成ChannelHandler，没有设置的回调什么也不做
+class Channel::CallbackHandler : public ChannelHandler {
+public:
+    void handleRead(Timestamp receiveTime) override {
+        if(readCallback_) {
+            readCallback_(receiveTime);
+        }
+    }
+    void handleWrite() override {
+        if(writeCallback_) {
+            writeCallback_();
+        }
+    }
+    void handleClose() override {
+        if(closeCallback_) {
+            closeCallback_();
+        }
+    }
+    void handleError() override {
+        if(errorCallback_) {
+            errorCallback_();
+        }
+    }
+
+    ReadEventCallback readCallback_; // 类型为回调函数的变量
+    EventCallback writeCallback_;
+    EventCallback closeCallback_;
+    EventCallback errorCallback_;
+};
+
 // EventLoop: ChannelList Poller
 Channel::Channel(EventLoop* loop, int fd)
-    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), tied_(false)
+    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), edgeTriggered_(false), tied_(false), handler_(nullptr)
 {}
 
 Channel::~Channel() {}
 
+Channel::CallbackHandler* Channel::callbacks() {
+    if(!callbacks_) {
+        callbacks_.reset(new CallbackHandler());
+    }
+    handler_ = callbacks_.get();
+    return callbacks_.get();
+}
+
+void Channel::setReadCallback(ReadEventCallback cb) {
+    callbacks()->readCallback_ = std::move(cb);
+}
+
+void Channel::setWriteCallback(EventCallback cb) {
+    callbacks()->writeCallback_ = std::move(cb);
+}
+
+void Channel::setErrorCallback(EventCallback cb) {
+    callbacks()->errorCallback_ = std::move(cb);
+}
+
+void Channel::setCloseCallback(EventCallback cb) {
+    callbacks()->closeCallback_ = std::move(cb);
+}
+
 // channel的tie方法什么时候调用? TcpConnection新连接创建时 TcpConnection => Channel
 void Channel::tie(const std::shared_ptr<void>& obj) {
     tie_ = obj;
@@ -48,37 +102,26 @@ void Channel::handleEvent(Timestamp receiveTime) {
     }
 }
 
-// 根据poller通知的channel发生的具体事件，由channel负责调用具体的回调操作
+// 根据poller通知的channel发生的具体事件，由channel负责调用handler中具体的处理函数
 void Channel::handleEventWithGuard(Timestamp receiveTime) {
-    LOG_INFO("channel handleEvent revent : %d\n", revents_);
+    LOG_DEBUG("channel handleEvent revent : %d\n", revents_);
+    if(handler_ == nullptr) {
+        return;
+    }
 
     if((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) { // EPOLLHUP (挂起)表示读写都关闭
-        if(closeCallback_) {
-            closeCallback_();
-        }
+        handler_->handleClose();
     }
 
     if(revents_ & (EPOLLERR)) { // 按位与 同1为1
-        if(errorCallback_) {
-            errorCallback_();
-        }
+        handler_->handleError();
     }
 
     if(revents_ & (EPOLLIN | EPOLLPRI)) {
-        if(readCallback_) {
-            readCallback_(receiveTime);
-        }
+        handler_->handleRead(receiveTime);
     }
 
-    /*
-     *writeCallback_ 是一个 EventCallback 类型的成员变量，它表示当有可写事件发生时需要执行的回调函数。
-     *如果该成员变量不为空，说明已经注册了回调函数，那么就执行该回调函数。执行回调函数的方式是通过执行函数对象 writeCallback_() 来实现，
-     *因为 writeCallback_ 是一个 std::function 对象，可以像函数一样执行它。该回调函数是无参数和无返回值的，因为 EventCallback 的定义就是一个无参数和无返回值的 std::function 对象。
-     *这种通过函数指针或函数对象来实现回调操作的方式，是一种常见的设计模式，称为回调模式或观察者模式。利用回调模式可以实现代码解耦，降低代码复杂度，提高程序扩展性和维护性。
-    */
     if(revents_ & EPOLLOUT) {
-        if(writeCallback_) {
-            writeCallback_();
-        }
+        handler_->handleWrite();
     }
-}
\ No newline at end of file
+}
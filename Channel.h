@@ -11,6 +11,21 @@
 // 如果需要访问被声明类的成员函数或成员变量，则需要包含该类的头文件。
 class EventLoop;
 
+/**
+ * Channel的事件处理接口，每个连接都有一个Channel的类（TcpConnection）直接实现它
+ * 分发一个事件只有一次虚函数调用；不用在每个Channel中保存四个std::function，也不用为每个std::bind分配内存
+ * Acceptor、TimerQueue这些只有一两个回调的Channel仍然使用setReadCallback等接口
+*/
+class ChannelHandler {
+public:
+    virtual void handleRead(Timestamp receiveTime) = 0;
+    virtual void handleWrite() = 0;
+    virtual void handleClose() = 0;
+    virtual void handleError() = 0;
+protected:
+    ~ChannelHandler() {}
+};
+
 /*
  * Channel 类封装了文件描述符和其所关注的事件类型
  * Channel 理解为通道，封装了sockfd和其感兴趣的event, 如EPOLLIN、EPOLLOUT事件
@@ -30,17 +45,20 @@ public:
     // fd得到poller的通知后，调用相应的回调函数处理事件
     void handleEvent(Timestamp receiveTime); // EventLoop使用可以前置声明，Timestamp不可以
 
-    // 设置回调函数对象
-    void setReadCallback(ReadEventCallback cb) { readCallback_ = std::move(cb); }
-    void setWriteCallback(EventCallback cb) { writeCallback_  = std::move(cb); }
-    void setErrorCallback(EventCallback cb) { errorCallback_ = std::move(cb); }
-    void setCloseCallback(EventCallback cb) { closeCallback_ = std::move(cb); }
+    // 事件交给handler处理，handler的生命周期由调用者保证，通常就是拥有这个Channel的对象
+    void setHandler(ChannelHandler* handler) { handler_ = handler; }
+    // 设置回调函数对象，第一次设置时创建一个保存std::function的handler
+    void setReadCallback(ReadEventCallback cb);
+    void setWriteCallback(EventCallback cb);
+    void setErrorCallback(EventCallback cb);
+    void setCloseCallback(EventCallback cb);
 
     // 防止当channel被手动remove掉，channel还在执行回调操作
     void tie(const std::shared_ptr<void>&); // 智能指针
 
     int fd() const { return fd_; }
     int events() const { return events_; } // 返回fd感兴趣的事件
+    int revents() const { return revents_; }
     void set_revent(int revt) { revents_ = revt; } // poller监听fd本身发生的事件，提供对外接口设置
 
     // 设置fd相应的事件状态
@@ -50,6 +68,10 @@ public:
     void disableWriting() { events_ &= ~kWriteEvent; update(); }
     void disableAll() { events_ = kNoneEvent; update(); }
 
+    // 边缘触发，需要在第一次注册事件之前设置，回调中要一直读写到EAGAIN
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool isEdgeTriggered() const { return edgeTriggered_; }
+
     // 返回fd当前的事件状态
     bool isNoneEvent() const { return events_ == kNoneEvent; }
     bool isWriting() const { return events_ & kWriteEvent; }
@@ -62,8 +84,11 @@ public:
     EventLoop* ownerLoop() { return loop_; }
     void remove();
 private:
+    class CallbackHandler; // 用std::function实现的ChannelHandler，定义在Channel.cc中
+
     void update();
     void handleEventWithGuard(Timestamp receiveTime);
+    CallbackHandler* callbacks();
 
     static const int kNoneEvent;
     static const int kReadEvent;
@@ -74,13 +99,12 @@ private:
     int events_; // 注册fd感兴趣的事件
     int revents_; // poller返回的具体发生的事件
     int index_;
+    bool edgeTriggered_;
 
     std::weak_ptr<void> tie_; // 弱智能指针要监控强智能指针
     bool tied_;
 
-    // 因为channel通道里面能够获知fd最终发生的具体事件revent_，所以它负责调用具体事件的回调操作
-    ReadEventCallback readCallback_; // 类型为回调函数的变量
-    EventCallback writeCallback_;
-    EventCallback closeCallback_;
-    EventCallback errorCallback_;
+    // 因为channel通道里面能够获知fd最终发生的具体事件revent_，所以它负责调用具体事件的处理函数
+    ChannelHandler* handler_;
+    std::unique_ptr<CallbackHandler> callbacks_; // 使用setReadCallback等接口时才创建
 };
\ No newline at end of file
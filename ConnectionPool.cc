@@ -0,0 +1,391 @@
+#include "ConnectionPool.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "BlockPool.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sys/socket.h>
+
+static void defaultConnectionCallback(const TcpConnectionPtr&) {
+}
+
+static void discardMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+    buf->retrieveAll();
+}
+
+// 连接池析构以后连接可能还没有关闭，关闭时不能再回调ConnectionPool::removeConnection
+static void destroyConnection(EventLoop* loop, const TcpConnectionPtr& conn) {
+    loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+ConnectionPool::Options::Options()
+    : maxConnections(8)
+    , minIdle(0)
+    , maxIdle(8)
+    , maxIdleTime(60.0)
+    , maxLifetime(0)
+    , maxPending(1024)
+    , acquireTimeout(1.0)
+    , connectTimeout(1.0)
+    , healthCheckInterval(1.0)
+{
+}
+
+ConnectionPool::ConnectionPool(EventLoop* loop,
+                               const InetAddress& serverAddr,
+                               const std::string& nameArg,
+                               const Options& options)
+    : loop_(loop)
+    , serverAddr_(serverAddr)
+    , name_(nameArg)
+    , options_(options)
+    , nextWaiterId_(1)
+    , nextConnId_(1)
+    , closing_(false)
+    , created_(0)
+    , reused_(0)
+    , closed_(0)
+    , timeouts_(0)
+    , rejected_(0)
+{
+    loop_->runInLoop(std::bind(&ConnectionPool::startInLoop, this));
+}
+
+ConnectionPool::~ConnectionPool() {
+    closing_ = true;
+    loop_->cancel(healthTimer_);
+
+    for(const ConnectorPtr& connector : connectors_) {
+        connector->stop();
+    }
+    connectors_.clear();
+
+    std::deque<Waiter> pending;
+    pending.swap(pending_);
+    for(Waiter& waiter : pending) {
+        loop_->cancel(waiter.timer);
+        waiter.cb(TcpConnectionPtr());
+    }
+
+    // 连接的回调都绑定了this，换成不依赖连接池的版本后关闭
+    ConnectionCallback connectionCb = connectionCallback_ ? connectionCallback_ : defaultConnectionCallback;
+    CloseCallback closeCb = std::bind(&destroyConnection, loop_, std::placeholders::_1);
+    for(auto& item : entries_) {
+        const TcpConnectionPtr& conn = item.second.conn;
+        conn->setConnectionCallback(connectionCb);
+        conn->setMessageCallback(discardMessage);
+        conn->setCloseCallback(closeCb);
+        conn->forceClose();
+    }
+    entries_.clear();
+    idle_.clear();
+}
+
+void ConnectionPool::startInLoop() {
+    if(options_.healthCheckInterval > 0) {
+        healthTimer_ = loop_->runEvery(options_.healthCheckInterval,
+            std::bind(&ConnectionPool::healthCheck, this));
+    }
+    // 预先建立minIdle个连接
+    while(static_cast<int>(connectors_.size()) < options_.minIdle
+        && static_cast<int>(totalConnections()) < options_.maxConnections) {
+        connectOne();
+    }
+}
+
+void ConnectionPool::acquire(const AcquireCallback& cb) {
+    loop_->runInLoop(std::bind(&ConnectionPool::acquireInLoop, this, cb));
+}
+
+void ConnectionPool::acquireInLoop(const AcquireCallback& cb) {
+    if(closing_) {
+        cb(TcpConnectionPtr());
+        return;
+    }
+
+    Timestamp now(Timestamp::now());
+    while(!idle_.empty()) {
+        Entry& entry = entries_[idle_.back()];
+        idle_.pop_back();
+        if(!entry.conn->connected() || expired(entry, now)) {
+            entry.conn->forceClose();
+            continue;
+        }
+        ++reused_;
+        lease(entry, cb);
+        return;
+    }
+
+    if(static_cast<int>(pending_.size()) >= options_.maxPending) {
+        ++rejected_;
+        LOG_ERROR("ConnectionPool[%s] - %d requests pending, reject \n", name_.c_str(), options_.maxPending);
+        cb(TcpConnectionPtr());
+        return;
+    }
+
+    Waiter waiter;
+    waiter.id = nextWaiterId_++;
+    waiter.cb = cb;
+    if(options_.acquireTimeout > 0) {
+        waiter.timer = loop_->runAfter(options_.acquireTimeout,
+            std::bind(&ConnectionPool::handleAcquireTimeout, this, waiter.id));
+    }
+    pending_.push_back(std::move(waiter));
+    serveWaiters();
+}
+
+void ConnectionPool::release(const TcpConnectionPtr& conn) {
+    auto it = entries_.find(conn.get());
+    if(it == entries_.end() || !it->second.leased) {
+        return; // 已经断开并从池中删除，或者重复归还
+    }
+    Entry& entry = it->second;
+    // 用户借出期间设置的消息回调不再有效
+    conn->setMessageCallback(std::bind(&ConnectionPool::onIdleMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+    if(!conn->connected() || expired(entry, Timestamp::now())) {
+        entry.leased = false;
+        conn->forceClose();
+        return;
+    }
+
+    if(!pending_.empty()) { // 直接交给排队最久的请求
+        Waiter waiter(std::move(pending_.front()));
+        pending_.pop_front();
+        loop_->cancel(waiter.timer);
+        ++reused_;
+        lease(entry, waiter.cb);
+        return;
+    }
+
+    if(static_cast<int>(idle_.size()) >= options_.maxIdle) {
+        entry.leased = false;
+        conn->forceClose();
+        return;
+    }
+    putIdle(entry);
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    Stats stats;
+    stats.idle = idle_.size();
+    stats.leased = 0;
+    for(const auto& item : entries_) {
+        if(item.second.leased) {
+            ++stats.leased;
+        }
+    }
+    stats.connecting = connectors_.size();
+    stats.pending = pending_.size();
+    stats.created = created_;
+    stats.reused = reused_;
+    stats.closed = closed_;
+    stats.timeouts = timeouts_;
+    stats.rejected = rejected_;
+    return stats;
+}
+
+void ConnectionPool::connectOne() {
+    ConnectorPtr connector(new Connector(loop_, serverAddr_));
+    connector->setConnectTimeout(options_.connectTimeout);
+    connector->setNewConnectionCallback(std::bind(&ConnectionPool::newConnection, this,
+        connector.get(), std::placeholders::_1));
+    connectors_.push_back(connector);
+    connector->start();
+}
+
+void ConnectionPool::newConnection(Connector* connector, int sockfd) {
+    // connector的回调中还持有它自己的shared_ptr，这里可以直接删除
+    auto it = std::find_if(connectors_.begin(), connectors_.end(),
+        [connector](const ConnectorPtr& item) { return item.get() == connector; });
+    if(it != connectors_.end()) {
+        connectors_.erase(it);
+    }
+
+    sockaddr_in peer;
+    sockaddr_in local;
+    ::bzero(&peer, sizeof(peer));
+    ::bzero(&local, sizeof(local));
+    socklen_t addrlen = sizeof(peer);
+    if(::getpeername(sockfd, (sockaddr*)&peer, &addrlen) < 0) {
+        LOG_ERROR("ConnectionPool::newConnection getpeername error:%d \n", errno);
+    }
+    addrlen = sizeof(local);
+    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0) {
+        LOG_ERROR("ConnectionPool::newConnection getsockname error:%d \n", errno);
+    }
+    InetAddress peerAddr(peer);
+    InetAddress localAddr(local);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
+    ++nextConnId_;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(PoolAllocator<TcpConnection>(loop_->blockPool()),
+                          loop_, connName, sockfd, localAddr, peerAddr));
+    conn->setConnectionCallback(std::bind(&ConnectionPool::onConnection, this, std::placeholders::_1));
+    conn->setMessageCallback(std::bind(&ConnectionPool::onIdleMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    conn->setCloseCallback(std::bind(&ConnectionPool::removeConnection, this, std::placeholders::_1));
+
+    Timestamp now(Timestamp::now());
+    Entry& entry = entries_[conn.get()];
+    entry.conn = conn;
+    entry.created = now;
+    entry.idleSince = now;
+    entry.leased = false;
+    ++created_;
+    conn->connectEstablished();
+
+    if(!pending_.empty()) {
+        Waiter waiter(std::move(pending_.front()));
+        pending_.pop_front();
+        loop_->cancel(waiter.timer);
+        lease(entry, waiter.cb);
+    }
+    else {
+        putIdle(entry);
+    }
+}
+
+// 对端关闭、出错或者被连接池主动关闭，都从这里删除
+void ConnectionPool::removeConnection(const TcpConnectionPtr& conn) {
+    auto it = entries_.find(conn.get());
+    if(it != entries_.end()) {
+        if(!it->second.leased) {
+            dropIdle(conn.get());
+        }
+        entries_.erase(it);
+        ++closed_;
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    serveWaiters(); // 腾出了连接数，排队的请求可以新建连接
+}
+
+void ConnectionPool::onConnection(const TcpConnectionPtr& conn) {
+    LOG_INFO("ConnectionPool[%s] - connection %s is %s \n",
+        name_.c_str(), conn->name().c_str(), conn->connected() ? "UP" : "DOWN");
+    if(connectionCallback_) {
+        connectionCallback_(conn);
+    }
+}
+
+void ConnectionPool::onIdleMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    size_t len = buf->readableBytes(); // LOG_ERROR宏中也有一个buf
+    LOG_ERROR("ConnectionPool[%s] - unexpected %lu bytes on idle connection %s, close it \n",
+        name_.c_str(), len, conn->name().c_str());
+    buf->retrieveAll();
+    conn->forceClose();
+}
+
+void ConnectionPool::handleAcquireTimeout(uint64_t id) {
+    auto it = std::find_if(pending_.begin(), pending_.end(),
+        [id](const Waiter& waiter) { return waiter.id == id; });
+    if(it == pending_.end()) {
+        return;
+    }
+    AcquireCallback cb(std::move(it->cb));
+    pending_.erase(it);
+    ++timeouts_;
+    LOG_ERROR("ConnectionPool[%s] - acquire timeout after %.3f seconds \n", name_.c_str(), options_.acquireTimeout);
+    cb(TcpConnectionPtr());
+}
+
+// 周期性检查空闲连接，关闭失效的连接，补充预热连接，停止不再需要的connect
+void ConnectionPool::healthCheck() {
+    Timestamp now(Timestamp::now());
+    std::vector<TcpConnection*> idle;
+    idle.swap(idle_);
+    for(TcpConnection* item : idle) {
+        Entry& entry = entries_[item];
+        bool healthy = entry.conn->connected() && !expired(entry, now)
+            && (!healthCheck_ || healthCheck_(entry.conn));
+        if(healthy) {
+            idle_.push_back(item);
+        }
+        else {
+            entry.conn->forceClose();
+        }
+    }
+
+    while(static_cast<int>(idle_.size()) > options_.maxIdle) {
+        entries_[idle_.front()].conn->forceClose(); // 最早归还的连接
+        idle_.erase(idle_.begin());
+    }
+
+    while(static_cast<int>(idle_.size() + connectors_.size()) < options_.minIdle
+        && static_cast<int>(totalConnections()) < options_.maxConnections) {
+        connectOne();
+    }
+
+    // 上游不可用时Connector会一直重试，没有请求等待并且不需要预热时停止
+    size_t needed = pending_.size();
+    if(static_cast<int>(idle_.size()) < options_.minIdle) {
+        needed += options_.minIdle - idle_.size();
+    }
+    while(connectors_.size() > needed) {
+        connectors_.back()->stop();
+        connectors_.pop_back();
+    }
+}
+
+void ConnectionPool::lease(Entry& entry, const AcquireCallback& cb) {
+    entry.leased = true;
+    TcpConnectionPtr conn(entry.conn); // cb中连接可能被关闭并从entries_中删除
+    cb(conn);
+}
+
+void ConnectionPool::putIdle(Entry& entry) {
+    entry.leased = false;
+    entry.idleSince = Timestamp::now();
+    idle_.push_back(entry.conn.get());
+}
+
+void ConnectionPool::dropIdle(TcpConnection* conn) {
+    auto it = std::find(idle_.begin(), idle_.end(), conn);
+    if(it != idle_.end()) {
+        idle_.erase(it);
+    }
+}
+
+// 把空闲连接交给排队的请求，还不够的话新建连接
+void ConnectionPool::serveWaiters() {
+    if(closing_) {
+        return;
+    }
+    Timestamp now(Timestamp::now());
+    while(!pending_.empty() && !idle_.empty()) {
+        Entry& entry = entries_[idle_.back()];
+        idle_.pop_back();
+        if(!entry.conn->connected() || expired(entry, now)) {
+            entry.conn->forceClose();
+            continue;
+        }
+        Waiter waiter(std::move(pending_.front()));
+        pending_.pop_front();
+        loop_->cancel(waiter.timer);
+        ++reused_;
+        lease(entry, waiter.cb);
+    }
+
+    while(connectors_.size() < pending_.size()
+        && static_cast<int>(totalConnections()) < options_.maxConnections) {
+        connectOne();
+    }
+}
+
+bool ConnectionPool::expired(const Entry& entry, Timestamp now) const {
+    if(options_.maxLifetime > 0 && timeDifference(now, entry.created) > options_.maxLifetime) {
+        return true;
+    }
+    if(!entry.leased && options_.maxIdleTime > 0 && timeDifference(now, entry.idleSince) > options_.maxIdleTime) {
+        return true;
+    }
+    return false;
+}
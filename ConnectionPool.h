@@ -0,0 +1,136 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Connector.h"
+#include "TimerId.h"
+#include "Timestamp.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <stdint.h>
+
+class EventLoop;
+
+/**
+ * 一个loop到一个上游地址的连接池，所有操作都在loop线程中进行，请求不会跨线程访问后端
+ * acquire => 有空闲连接直接复用，没有则新建连接或者排队等待 => 用户在连接上收发数据 => release归还
+ *
+ * 借出期间用户自己设置连接的消息回调，归还时恢复成连接池的回调：
+ * 空闲连接上收到数据说明请求和响应已经错位，直接关闭
+ * 对端关闭空闲连接时poller会通知，连接随即从池中删除，不需要额外的探测
+*/
+class ConnectionPool : noncopyable {
+public:
+    // 拿到连接时conn不为空；排队超时、排队已满或者连接池已经析构时conn为空
+    using AcquireCallback = std::function<void(const TcpConnectionPtr& conn)>;
+    // 健康检查时对每个空闲连接调用，返回false的连接会被关闭
+    using HealthCheckCallback = std::function<bool(const TcpConnectionPtr& conn)>;
+
+    struct Options {
+        Options();
+
+        int maxConnections; // 到上游的最大连接数，包括正在connect的
+        int minIdle; // 保持预热的空闲连接数
+        int maxIdle; // 最多保留的空闲连接数，超出的连接归还时关闭
+        double maxIdleTime; // 空闲超过这个秒数的连接被关闭，0表示不限制
+        double maxLifetime; // 建立超过这个秒数的连接不再借出，0表示不限制
+        int maxPending; // 连接都被占用时最多排队的请求数
+        double acquireTimeout; // 排队等待的最长秒数，0表示不限制
+        double connectTimeout; // 单次connect的超时秒数，0表示不限制
+        double healthCheckInterval; // 检查空闲连接的周期，0表示不检查
+    };
+
+    // 只能在loop线程中读取
+    struct Stats {
+        size_t idle;
+        size_t leased;
+        size_t connecting;
+        size_t pending;
+        uint64_t created; // 建立的连接总数
+        uint64_t reused; // 直接复用空闲连接的次数
+        uint64_t closed; // 关闭的连接总数
+        uint64_t timeouts; // 排队超时的请求数
+        uint64_t rejected; // 排队已满被拒绝的请求数
+    };
+
+    ConnectionPool(EventLoop* loop,
+                   const InetAddress& serverAddr,
+                   const std::string& nameArg,
+                   const Options& options = Options());
+    ~ConnectionPool(); // 必须在loop线程中析构，池中的连接都会被关闭
+
+    EventLoop* getLoop() const { return loop_; }
+    const InetAddress& serverAddress() const { return serverAddr_; }
+    const std::string& name() const { return name_; }
+
+    // 连接建立和断开时的通知，健康检查的回调，需要在使用之前设置
+    void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
+    void setHealthCheck(const HealthCheckCallback& cb) { healthCheck_ = cb; }
+
+    // 在其它线程中调用时转到loop线程中执行，回调总是在loop线程中执行
+    void acquire(const AcquireCallback& cb);
+    // 归还借出的连接，只能在loop线程中调用；已经断开的连接直接丢弃
+    void release(const TcpConnectionPtr& conn);
+
+    Stats stats() const;
+private:
+    struct Entry {
+        TcpConnectionPtr conn;
+        Timestamp created;
+        Timestamp idleSince;
+        bool leased;
+    };
+
+    struct Waiter {
+        uint64_t id;
+        AcquireCallback cb;
+        TimerId timer;
+    };
+
+    void startInLoop();
+    void acquireInLoop(const AcquireCallback& cb);
+    void connectOne();
+    void newConnection(Connector* connector, int sockfd);
+    void removeConnection(const TcpConnectionPtr& conn);
+    void onConnection(const TcpConnectionPtr& conn);
+    void onIdleMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+    void handleAcquireTimeout(uint64_t id);
+    void healthCheck();
+
+    void lease(Entry& entry, const AcquireCallback& cb);
+    void putIdle(Entry& entry);
+    void dropIdle(TcpConnection* conn);
+    void serveWaiters();
+    bool expired(const Entry& entry, Timestamp now) const;
+    size_t totalConnections() const { return entries_.size() + connectors_.size(); }
+
+    EventLoop* loop_;
+    const InetAddress serverAddr_;
+    const std::string name_;
+    const Options options_;
+
+    ConnectionCallback connectionCallback_;
+    HealthCheckCallback healthCheck_;
+
+    std::unordered_map<TcpConnection*, Entry> entries_; // 所有已经建立的连接
+    std::vector<TcpConnection*> idle_; // 空闲连接，末尾是最近归还的，优先复用
+    std::vector<ConnectorPtr> connectors_; // 正在进行的connect
+    std::deque<Waiter> pending_; // 等待连接的请求，先来先服务
+    uint64_t nextWaiterId_;
+    int nextConnId_;
+    TimerId healthTimer_;
+    bool closing_;
+
+    uint64_t created_;
+    uint64_t reused_;
+    uint64_t closed_;
+    uint64_t timeouts_;
+    uint64_t rejected_;
+};
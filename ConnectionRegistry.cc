@@ -0,0 +1,62 @@
+#include "ConnectionRegistry.h"
+
+ConnectionRegistry::ConnectionRegistry()
+    : freeHead_(kNoSlot)
+    , nextSequence_(1)
+    , size_(0)
+{
+}
+
+ConnectionId ConnectionRegistry::allocate() {
+    uint32_t slot = freeHead_;
+    if(slot != kNoSlot) {
+        freeHead_ = slots_[slot].nextFree;
+    }
+    else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(Slot());
+    }
+
+    ConnectionId id = (static_cast<ConnectionId>(nextSequence_) << 32) | slot;
+    if(++nextSequence_ == 0) { // 回绕时跳过0，保证ID不为0
+        nextSequence_ = 1;
+    }
+    slots_[slot].id = id;
+    slots_[slot].nextFree = kNoSlot;
+    ++size_;
+    return id;
+}
+
+void ConnectionRegistry::set(ConnectionId id, const TcpConnectionPtr& conn) {
+    if(occupied(id)) {
+        slots_[slotOf(id)].conn = conn;
+    }
+}
+
+bool ConnectionRegistry::remove(ConnectionId id) {
+    if(!occupied(id)) {
+        return false;
+    }
+    Slot& s = slots_[slotOf(id)];
+    s.id = 0;
+    s.conn.reset();
+    s.nextFree = freeHead_;
+    freeHead_ = slotOf(id);
+    --size_;
+    return true;
+}
+
+TcpConnectionPtr ConnectionRegistry::find(ConnectionId id) const {
+    return occupied(id) ? slots_[slotOf(id)].conn : TcpConnectionPtr();
+}
+
+void ConnectionRegistry::takeAll(std::vector<TcpConnectionPtr>* conns) {
+    for(Slot& s : slots_) {
+        if(s.id != 0 && s.conn) {
+            conns->push_back(std::move(s.conn));
+        }
+    }
+    slots_.clear();
+    freeHead_ = kNoSlot;
+    size_ = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * TcpServer保存所有连接的slab：连接放在vector的槽位中，删除后槽位串进空闲链表，给下一个连接重用
+ * 连接ID = 序号 << 32 | 槽位下标，查找和删除只需要一次下标访问和一次ID比较，不构造、不哈希字符串
+ * 序号在整个registry中递增，槽位被重用时ID一定不同，拿着已经关闭的连接的ID查不到新连接
+ * 不加锁，由TcpServer的mutex_保护
+*/
+class ConnectionRegistry : noncopyable {
+public:
+    ConnectionRegistry();
+
+    // 为新连接分配槽位和ID，连接对象创建好以后再set进来
+    ConnectionId allocate();
+    void set(ConnectionId id, const TcpConnectionPtr& conn);
+    // ID对应的槽位仍被占用时释放它并返回true
+    bool remove(ConnectionId id);
+    // 连接已经删除或者还没有set时返回空指针
+    TcpConnectionPtr find(ConnectionId id) const;
+    // 取出所有连接，registry变为空
+    void takeAll(std::vector<TcpConnectionPtr>* conns);
+
+    size_t size() const { return size_; }
+
+    static uint32_t slotOf(ConnectionId id) { return static_cast<uint32_t>(id); }
+    // 序号从1开始，就是连接名字中#后面的数字
+    static uint32_t sequenceOf(ConnectionId id) { return static_cast<uint32_t>(id >> 32); }
+private:
+    struct Slot {
+        ConnectionId id; // 0表示槽位空闲
+        uint32_t nextFree; // 空闲时指向下一个空闲槽位
+        TcpConnectionPtr conn;
+    };
+    static const uint32_t kNoSlot = 0xffffffff;
+
+    // id对应的槽位仍被这个连接占用
+    bool occupied(ConnectionId id) const {
+        uint32_t slot = slotOf(id);
+        return id != 0 && slot < slots_.size() && slots_[slot].id == id;
+    }
+
+    std::vector<Slot> slots_;
+    uint32_t freeHead_; // 空闲链表头，kNoSlot表示没有空闲槽位
+    uint32_t nextSequence_;
+    size_t size_;
+};
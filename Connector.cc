@@ -0,0 +1,254 @@
+#include "Connector.h"
+#include "EventLoop.h"
+#include "Channel.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sys/socket.h>
+
+const int Connector::kInitRetryDelayMs;
+const int Connector::kMaxRetryDelayMs;
+
+static int createNonblocking() {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(sockfd < 0) {
+        LOG_FATAL("%s:%s:%d connect socket create err:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+static int getSocketError(int sockfd) {
+    int optval;
+    socklen_t optlen = sizeof(optval);
+    if(::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+        return errno;
+    }
+    return optval;
+}
+
+// 客户端没有bind时内核分配的临时端口可能恰好等于服务端端口，服务端没有监听时
+// 连接本机的同一个端口会发生TCP同时打开，自己和自己建立连接
+static bool isSelfConnect(int sockfd) {
+    sockaddr_in local;
+    sockaddr_in peer;
+    socklen_t addrlen = sizeof(local);
+    ::bzero(&local, sizeof(local));
+    ::bzero(&peer, sizeof(peer));
+    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0) {
+        return false;
+    }
+    addrlen = sizeof(peer);
+    if(::getpeername(sockfd, (sockaddr*)&peer, &addrlen) < 0) {
+        return false;
+    }
+    return local.sin_port == peer.sin_port
+        && local.sin_addr.s_addr == peer.sin_addr.s_addr;
+}
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
+    : loop_(loop)
+    , serverAddr_(serverAddr)
+    , connect_(false)
+    , state_(kDisconnected)
+    , connectTimeout_(0)
+    , initRetryDelayMs_(kInitRetryDelayMs)
+    , maxRetryDelayMs_(kMaxRetryDelayMs)
+    , retryDelayMs_(kInitRetryDelayMs)
+{
+}
+
+Connector::~Connector() {
+    // 析构前必须已经stop，并且connect进行中的channel已经删除
+    if(channel_) {
+        LOG_ERROR("Connector::dtor channel of fd=%d is not removed \n", channel_->fd());
+    }
+}
+
+void Connector::setRetryDelay(int initMs, int maxMs) {
+    initRetryDelayMs_ = std::max(initMs, 1);
+    maxRetryDelayMs_ = std::max(maxMs, initRetryDelayMs_);
+    retryDelayMs_ = initRetryDelayMs_;
+}
+
+void Connector::start() {
+    connect_ = true;
+    loop_->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop() {
+    if(state_ != kDisconnected) {
+        return;
+    }
+    if(connect_) {
+        connect();
+    }
+    else {
+        LOG_DEBUG("Connector::startInLoop do not connect \n");
+    }
+}
+
+void Connector::restart() {
+    setState(kDisconnected);
+    retryDelayMs_ = initRetryDelayMs_;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::stop() {
+    connect_ = false;
+    loop_->queueInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::stopInLoop() {
+    cancelTimers();
+    if(state_ == kConnecting) {
+        setState(kDisconnected);
+        int sockfd = removeAndResetChannel();
+        retry(sockfd); // connect_已经是false，这里只会关闭sockfd
+    }
+}
+
+void Connector::connect() {
+    int sockfd = createNonblocking();
+    int ret = ::connect(sockfd, (sockaddr*)serverAddr_.getSockAddr(), sizeof(sockaddr_in));
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch(savedErrno) {
+        case 0:
+        case EINPROGRESS: // 非阻塞connect正在进行，等待sockfd可写
+        case EINTR:
+        case EISCONN:
+            connecting(sockfd);
+            break;
+
+        case EAGAIN: // 本地临时端口耗尽
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+            retry(sockfd);
+            break;
+
+        default: // EACCES EPERM EAFNOSUPPORT EBADF等，重试也不会成功
+            LOG_ERROR("Connector::connect %s error:%d \n", serverAddr_.toIpPort().c_str(), savedErrno);
+            ::close(sockfd);
+            break;
+    }
+}
+
+void Connector::connecting(int sockfd) {
+    setState(kConnecting);
+    channel_.reset(new Channel(loop_, sockfd));
+    // channel_由Connector持有，Connector又由shared_ptr管理，回调期间channel_不会被释放
+    channel_->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    channel_->setErrorCallback(std::bind(&Connector::handleError, this));
+    channel_->enableWriting(); // 连接建立或者失败时sockfd变为可写
+
+    if(connectTimeout_ > 0) {
+        std::weak_ptr<Connector> weak(shared_from_this());
+        timeoutTimer_ = loop_->runAfter(connectTimeout_, [weak, sockfd]() {
+            std::shared_ptr<Connector> connector(weak.lock());
+            if(connector) {
+                connector->handleTimeout(sockfd);
+            }
+        });
+    }
+}
+
+int Connector::removeAndResetChannel() {
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    // 当前可能正在Channel::handleEvent中，不能在这里释放channel_
+    loop_->queueInLoop(std::bind(&Connector::resetChannel, shared_from_this()));
+    return sockfd;
+}
+
+void Connector::resetChannel() {
+    channel_.reset();
+}
+
+void Connector::cancelTimers() {
+    loop_->cancel(timeoutTimer_);
+    loop_->cancel(retryTimer_);
+    timeoutTimer_ = TimerId();
+    retryTimer_ = TimerId();
+}
+
+void Connector::handleWrite() {
+    if(state_ != kConnecting) {
+        return;
+    }
+    loop_->cancel(timeoutTimer_);
+    timeoutTimer_ = TimerId();
+
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    if(err) {
+        LOG_ERROR("Connector::handleWrite %s SO_ERROR:%d %s \n",
+            serverAddr_.toIpPort().c_str(), err, strerror(err));
+        retry(sockfd);
+    }
+    else if(isSelfConnect(sockfd)) {
+        LOG_ERROR("Connector::handleWrite %s self connect \n", serverAddr_.toIpPort().c_str());
+        retry(sockfd);
+    }
+    else {
+        setState(kConnected);
+        if(connect_) {
+            retryDelayMs_ = initRetryDelayMs_;
+            newConnectionCallback_(sockfd); // sockfd交给TcpConnection管理
+        }
+        else {
+            ::close(sockfd);
+        }
+    }
+}
+
+void Connector::handleError() {
+    if(state_ != kConnecting) {
+        return;
+    }
+    loop_->cancel(timeoutTimer_);
+    timeoutTimer_ = TimerId();
+
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    LOG_ERROR("Connector::handleError %s SO_ERROR:%d %s \n",
+        serverAddr_.toIpPort().c_str(), err, strerror(err));
+    retry(sockfd);
+}
+
+void Connector::handleTimeout(int sockfd) {
+    timeoutTimer_ = TimerId();
+    if(state_ != kConnecting || !channel_ || channel_->fd() != sockfd) {
+        return; // 这次connect已经结束
+    }
+    LOG_ERROR("Connector::handleTimeout %s connect timeout after %.3f seconds \n",
+        serverAddr_.toIpPort().c_str(), connectTimeout_);
+    retry(removeAndResetChannel());
+}
+
+// 关闭这次失败的sockfd，connect_为true时在retryDelayMs_之后重新connect
+void Connector::retry(int sockfd) {
+    ::close(sockfd);
+    setState(kDisconnected);
+    if(connect_) {
+        LOG_INFO("Connector::retry connecting to %s in %d milliseconds \n",
+            serverAddr_.toIpPort().c_str(), retryDelayMs_);
+        std::weak_ptr<Connector> weak(shared_from_this());
+        retryTimer_ = loop_->runAfter(retryDelayMs_ / 1000.0, [weak]() {
+            std::shared_ptr<Connector> connector(weak.lock());
+            if(connector) {
+                connector->retryTimer_ = TimerId();
+                connector->startInLoop();
+            }
+        });
+        retryDelayMs_ = std::min(retryDelayMs_ * 2, maxRetryDelayMs_);
+    }
+    else {
+        LOG_DEBUG("Connector::retry do not connect \n");
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "TimerId.h"
+
+#include <functional>
+#include <memory>
+#include <atomic>
+
+class EventLoop;
+class Channel;
+
+/**
+ * 客户端主动发起连接，和服务端的Acceptor对应
+ * 非阻塞connect => EINPROGRESS => channel注册EPOLLOUT => 可写时检查SO_ERROR
+ * => 连接成功把sockfd交给TcpClient::newConnection，失败则按指数退避重试
+ *
+ * 定时器回调中可能Connector已经析构，所以通过weak_ptr回调，Connector必须由shared_ptr管理
+*/
+class Connector : noncopyable, public std::enable_shared_from_this<Connector> {
+public:
+    using NewConnectionCallback = std::function<void(int sockfd)>;
+
+    static const int kInitRetryDelayMs = 500;
+    static const int kMaxRetryDelayMs = 30 * 1000;
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb) { newConnectionCallback_ = cb; }
+    // 单次connect的超时时间，超时后关闭这次连接再重试，0表示不限制，需要在start之前设置
+    void setConnectTimeout(double seconds) { connectTimeout_ = seconds; }
+    // 重试间隔从initMs开始，每次失败翻倍，不超过maxMs，需要在start之前设置
+    void setRetryDelay(int initMs, int maxMs);
+
+    const InetAddress& serverAddress() const { return serverAddr_; }
+
+    void start(); // 可以在任意线程中调用
+    void restart(); // 只能在loop线程中调用，重置重试间隔后重新连接
+    void stop(); // 可以在任意线程中调用
+private:
+    enum States { kDisconnected, kConnecting, kConnected };
+
+    void setState(States s) { state_ = s; }
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void handleTimeout(int sockfd);
+    void retry(int sockfd);
+    int removeAndResetChannel();
+    void resetChannel();
+    void cancelTimers();
+
+    EventLoop* loop_;
+    InetAddress serverAddr_;
+    std::atomic_bool connect_; // 用户是否希望连接，stop()之后不再重试
+    States state_;
+    std::unique_ptr<Channel> channel_; // 只在connect进行中存在，连接成功后sockfd交给TcpConnection
+    NewConnectionCallback newConnectionCallback_;
+
+    double connectTimeout_;
+    int initRetryDelayMs_;
+    int maxRetryDelayMs_;
+    int retryDelayMs_;
+    TimerId timeoutTimer_;
+    TimerId retryTimer_;
+};
+
+using ConnectorPtr = std::shared_ptr<Connector>;
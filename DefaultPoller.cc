@@ -1,14 +1,30 @@
 // 本文件属于公共源文件，可以添加依赖关系
 #include "Poller.h"
 #include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "EventLoop.h"
+#include "Logger.h"
 
 #include <stdlib.h>
 
 Poller* Poller::newDefaultPoller(EventLoop* loop) {
-    if(::getenv("MUDUO_USE_POLL")) {
-        return nullptr; // 生成poll的实例
+    EventLoop::PollerType type = loop->pollerType();
+    if(type == EventLoop::kDefaultPoller) {
+        if(::getenv("MUDUO_USE_IO_URING")) {
+            type = EventLoop::kIoUringPoller;
+        }
+        else if(::getenv("MUDUO_USE_POLL")) {
+            LOG_ERROR("MUDUO_USE_POLL: poll(2) backend is not implemented, using epoll \n");
+        }
     }
-    else {
-        return new EpollPoller(loop); // 生成epoll的实例
+
+    if(type == EventLoop::kIoUringPoller) {
+        IoUringPoller* poller = new IoUringPoller(loop); // 生成io_uring的实例
+        if(poller->valid()) {
+            return poller;
+        }
+        delete poller;
+        LOG_ERROR("io_uring unavailable, fall back to epoll \n");
     }
-}
\ No newline at end of file
+    return new EpollPoller(loop); // 生成epoll的实例
+}
@@ -30,20 +30,21 @@ EpollPoller::~EpollPoller() {
 // 在 epoll_wait() 函数调用期间，内核会扫描 epoll 实例所监听的所有文件描述符，并将其中发生事件的文件描述符加入就绪列表中，同时返回就绪列表中的文件描述符个数。
 // 就绪列表本质上是一个数组或 vector，其每个元素对应一个已经准备好的文件描述符。
 Timestamp EpollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
-    LOG_INFO("func=%s => fd total count:%lu \n", __FUNCTION__, channels_.size());
+    LOG_DEBUG("func=%s => fd total count:%lu \n", __FUNCTION__, channels_.size());
+    ++pollCalls_;
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), timeoutMs); 
     int saveErrno = errno;
     Timestamp now(Timestamp::now());
 
     if(numEvents > 0) {
-        LOG_INFO("%d events happened \n", numEvents);
+        LOG_DEBUG("%d events happened \n", numEvents);
         fillActiveChannels(numEvents, activeChannels);
         if(numEvents == events_.size()) {
             events_.resize(events_.size() * 2);
         }
     }
     else if(numEvents == 0) { // 超时
-        LOG_DEBUG("%s timeout! \n", __FUNCTION);
+        LOG_DEBUG("%s timeout! \n", __FUNCTION__);
     }
     else { // 发生错误
         if(saveErrno != EINTR) {
@@ -63,7 +64,7 @@ Timestamp EpollPoller::poll(int timeoutMs, ChannelList* activeChannels) {
 */                  
 void EpollPoller::updateChannel(Channel* channel) { 
     const int index = channel->index();
-    LOG_INFO("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__, channel->fd(), channel->events(), index);
+    LOG_DEBUG("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__, channel->fd(), channel->events(), index);
 
     if(index == kNew || index == kDeleted) {
         if(index == kNew) {
@@ -90,10 +91,10 @@ void EpollPoller::removeChannel(Channel* channel) {
     int fd = channel->fd();
     channels_.erase(fd);
     
-    LOG_INFO("func=%s => fd=%d\n", __FUNCTION__, fd);
+    LOG_DEBUG("func=%s => fd=%d\n", __FUNCTION__, fd);
 
     int index = channel->index();
-    if(index == kDeleted) {
+    if(index == kAdded) { // disableAll时已经从epoll中删除过的不用再删除
         update(EPOLL_CTL_DEL, channel);
     }
     channel->set_index(kNew);
@@ -116,8 +117,12 @@ void EpollPoller::update(int operation, Channel* channel) {
 
     event.data.fd = fd;
     event.events = channel->events();
+    if(channel->isEdgeTriggered() && operation != EPOLL_CTL_DEL) {
+        event.events |= EPOLLET;
+    }
     event.data.ptr = channel; // ptr中存放fd相关的参数比如channel
 
+    ++ctlCalls_;
     if(::epoll_ctl(epollfd_, operation, fd, &event) < 0) {
         if(operation == EPOLL_CTL_DEL) {
             LOG_ERROR("epoll_ctl del error:%d\n", errno);
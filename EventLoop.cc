@@ -2,8 +2,13 @@
 #include "Logger.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "BufferPool.h"
+#include "BlockPool.h"
+#include "LoopMetrics.h"
 
 #include <sys/eventfd.h>
+#include <signal.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -14,6 +19,15 @@ __thread EventLoop* t_loopInThisThread = nullptr;
 // __thread 是 GCC/Clang 中用来标记线程局部存储的关键字，它可以将变量声明为每个线程独有的副本。在多线程编程中，
 // 使用 __thread 可以避免同一变量被多个线程共享而导致的线程安全问题。每个线程都拥有自己独立的变量副本，这样一来，即使多个线程同时访问同一个变量，也不会相互影响
 
+// 对端已经关闭的连接上write会产生SIGPIPE，默认动作是结束进程，写错误由TcpConnection根据EPIPE处理
+class IgnoreSigPipe {
+public:
+    IgnoreSigPipe() {
+        ::signal(SIGPIPE, SIG_IGN);
+    }
+};
+IgnoreSigPipe initObj;
+
 // 定义默认的Poller IO复用接口的超时时间
 const int kPollTimeMs = 10000;
 
@@ -29,14 +43,22 @@ int createEventfd() {
     return evtfd;
 }
 
-EventLoop::EventLoop() 
+EventLoop::EventLoop(PollerType pollerType) 
     : looping_(false)
     , quit_(false)
-    , callingPendingFunctors_(false)
     , threadId_(CurrentThread::tid())
+    , pollerType_(pollerType)
     , poller_(Poller::newDefaultPoller(this)) // poller_ 对象是 Poller 类型的指针，它指向 Poller 的派生类对象，在构造函数中将其初始化为 EpollPoller 对象。
+    , timerQueue_(new TimerQueue(this))
+    , bufferPool_(new BufferPool(this))
+    , blockPool_(std::make_shared<BlockPool>())
     , wakeupFd_(createEventfd())
     , wakeupChannel_(new Channel(this, wakeupFd_))
+    , callingPendingFunctors_(false)
+    , wakeupPending_(false)
+    , numConnections_(0)
+    , pendingOutputBytes_(0)
+    , metrics_(new LoopMetrics(&numConnections_, &pendingOutputBytes_))
 {
     LOG_DEBUG("EventLoop create %p in thread %d \n", this, threadId_);
     if(t_loopInThisThread) {
@@ -66,20 +88,28 @@ void EventLoop::loop() {
 
     LOG_INFO("EventLoop %p start looping \n", this);
 
+    // 每轮取三次单调时钟，分别统计阻塞在poll、处理IO事件和执行回调的时间，上一轮的结束时间就是这一轮的开始时间
+    uint64_t now = LoopMetrics::nowNanos();
     while(!quit_) {
         activeChannels_.clear();
         // 监听两类fd  一种client的fd  一种wakeupfd
         pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        const uint64_t pollEnd = LoopMetrics::nowNanos();
+        metrics_->onPoll(pollEnd - now, activeChannels_.size());
         for(Channel* channel : activeChannels_) {
             // Poller监听哪些channel发生事件，然后上报给EventLoop，通知channel处理相应事件
             channel->handleEvent(pollReturnTime_);
         }
+        const uint64_t eventsEnd = LoopMetrics::nowNanos();
+        metrics_->onEvents(eventsEnd - pollEnd);
         // 执行当前EventLoop事件循环需要处理的回调操作
         /**
          * IO线程 mainLoop accept fd <= channel subloop
          * mainLoop 事先注册一个回调cb（需要subloop来执行） wakeup subloop后，执行下面的方法，执行之前mainloop注册的cb操作
         */
-        doPendingFunctors();
+        size_t functors = doPendingFunctors();
+        now = LoopMetrics::nowNanos();
+        metrics_->onFunctors(functors, now - eventsEnd);
     }
     LOG_INFO("EventLoop %p stop looping. \n", this);
     looping_ = false;
@@ -101,20 +131,18 @@ void EventLoop::runInLoop(Functor cb) {
         cb();
     }
     else { // 在非当前loop线程中执行cb，就要唤醒loop线程，执行cb
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
 // 把cb放入队列中，唤醒loop所在的线程，执行cb
 void EventLoop::queueInLoop(Functor cb) {
-    { // 因为需要并发执行，就要添加锁
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb); // emplace_back直接构造，push为拷贝构造
-    }
+    pendingFunctors_.push(std::move(cb)); // 无锁插入，不会和其它线程竞争互斥锁
 
     // 唤醒相应的，需要执行上面回调操作的loop的线程了
     // || callingPendingFunctors_的意思是：当前loop正在执行回调，但是loop又有了新的回调,处理完doPendingFunctors()后，阻塞在poll，然后被唤醒，继续执行回调
-    if(!isInLoopThread() || callingPendingFunctors_) {
+    // wakeupPending_为true说明已经有线程写过wakeupFd_，loop还没来得及处理，不需要再写一次
+    if((!isInLoopThread() || callingPendingFunctors_) && !wakeupPending_.exchange(true)) {
         wakeup(); // 唤醒loop所在线程
     }
 }
@@ -125,6 +153,7 @@ void EventLoop::handleRead() {
     if(n != sizeof one) {
         LOG_ERROR("EventLoop::handleRead() reads %lu bytes instead of 8", n);
     }
+    metrics_->onWakeup();
 }
 
 // 用来唤醒loop所在线程 向wakeupfd_写一个数据，wakeupChannel就发生读事件，当前loop线程就会被唤醒
@@ -136,6 +165,25 @@ void EventLoop::wakeup() {
     }
 }
 
+// 在time时刻执行cb
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb) {
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+// 在delay秒之后执行cb
+TimerId EventLoop::runAfter(double delay, TimerCallback cb) {
+    return runAt(addTime(Timestamp::now(), delay), std::move(cb));
+}
+
+// 每隔interval秒执行一次cb
+TimerId EventLoop::runEvery(double interval, TimerCallback cb) {
+    return timerQueue_->addTimer(std::move(cb), addTime(Timestamp::now(), interval), interval);
+}
+
+void EventLoop::cancel(TimerId timerId) {
+    timerQueue_->cancel(timerId);
+}
+
 // EventLoop的方法 => Poller的方法
 void EventLoop::updateChannel(Channel* channel) {
     poller_->updateChannel(channel);
@@ -149,18 +197,15 @@ bool EventLoop::hasChannel(Channel* channel) {
     return poller_->hasChannel(channel);
 }
 
-void EventLoop::doPendingFunctors() { // 执行回调
-    std::vector<Functor> functors;
+size_t EventLoop::doPendingFunctors() { // 执行回调
     callingPendingFunctors_ = true;
+    // 先清除标志再取队列，之后插入的回调一定会重新唤醒loop
+    wakeupPending_ = false;
 
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
-    }
-
-    for(const Functor& functor : functors) {
+    size_t count = pendingFunctors_.consume([](const Functor& functor) {
         functor(); // 执行当前loop需要执行的回调操作
-    }
+    });
 
     callingPendingFunctors_ = false;
+    return count;
 }
\ No newline at end of file
@@ -9,16 +9,31 @@
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "MpscQueue.h"
 
 class Channel;
 class Poller;
+class TimerQueue;
+class BufferPool;
+class BlockPool;
+class LoopMetrics;
 
 // 事件循环类 主要包含两个大模块 Channel Poller(epoll的抽象类)
 class EventLoop :noncopyable{
 public:
     using Functor = std::function<void()>; // Functor 是一个无参、无返回值的函数对象
 
-    EventLoop();
+    // IO复用的实现，默认使用epoll，设置了环境变量MUDUO_USE_IO_URING时使用io_uring
+    // 指定io_uring而内核不支持时回退到epoll
+    enum PollerType {
+        kDefaultPoller,
+        kEpollPoller,
+        kIoUringPoller,
+    };
+
+    explicit EventLoop(PollerType pollerType = kDefaultPoller);
     ~EventLoop();
 
     // 开启事件循环
@@ -36,16 +51,41 @@ public:
     // 用来唤醒loop所在的线程
     void wakeup();
 
+    // 定时器，都可以在其它线程中调用
+    // 在time时刻执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    // 在delay秒之后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    // 每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    // 取消定时器
+    void cancel(TimerId timerId);
+
     // EventLoop的方法 => Poller的方法
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
     bool hasChannel(Channel* channel);
 
+    // 本loop上连接的Buffer使用的内存池，stats()可以查看内存使用情况
+    BufferPool* bufferPool() const { return bufferPool_.get(); }
+    // 在本loop中创建的TcpConnection对象使用的内存池，见BlockPool
+    const std::shared_ptr<BlockPool>& blockPool() const { return blockPool_; }
+    const Poller* poller() const { return poller_.get(); }
+    PollerType pollerType() const { return pollerType_; }
+    // 本loop的运行时统计，计数只在loop线程中修改，可以在任意线程中读取
+    LoopMetrics* metrics() const { return metrics_.get(); }
+
+    // 负载统计，由TcpConnection在loop线程中维护，其它线程（比如mainLoop选择subLoop时）可以读取
+    int64_t numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+    int64_t pendingOutputBytes() const { return pendingOutputBytes_.load(std::memory_order_relaxed); }
+    void addConnections(int64_t delta) { numConnections_.fetch_add(delta, std::memory_order_relaxed); }
+    void addPendingOutputBytes(int64_t delta) { pendingOutputBytes_.fetch_add(delta, std::memory_order_relaxed); }
+
     // 判断EventLoop对象是否在自己的线程里面
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
 private:
     void handleRead(); // wake up
-    void doPendingFunctors(); // 执行回调
+    size_t doPendingFunctors(); // 执行回调，返回执行的个数
 
     using ChannelList = std::vector<Channel*>;
 
@@ -55,7 +95,11 @@ private:
     const pid_t threadId_; // 记录当前loop所在线程的id
 
     Timestamp pollReturnTime_; // poller返回发生事件的时间节点
+    const PollerType pollerType_; // 要在poller_之前初始化
     std::unique_ptr<Poller> poller_;
+    std::unique_ptr<TimerQueue> timerQueue_; // 析构时要从poller_中删除timerfd的channel，所以放在poller_之后
+    std::unique_ptr<BufferPool> bufferPool_;
+    std::shared_ptr<BlockPool> blockPool_; // 连接可能比loop活得久，由PoolAllocator共同持有
 
     int wakeupFd_; // 主要作用，当mainLoop获取一个新用户channel，通过轮询算法选择一个subloop，通过该成员唤醒subloop处理channel
     std::unique_ptr<Channel> wakeupChannel_;
@@ -63,6 +107,10 @@ private:
     ChannelList activeChannels_;
 
     std::atomic_bool callingPendingFunctors_; // 标识当前loop是否有需要执行的回调操作
-    std::vector<Functor> pendingFunctors_; // 存储loop需要执行的所有回调操作
-    std::mutex mutex_; // 互斥锁，用来保护上面vector容器的线程安全操作
+    MpscQueue<Functor> pendingFunctors_; // 存储loop需要执行的所有回调操作，无锁队列，其它线程可以直接插入
+    std::atomic_bool wakeupPending_; // 已经写过wakeupFd_但loop还没有处理，连续多次queueInLoop只需要唤醒一次
+
+    std::atomic<int64_t> numConnections_; // 本loop上的连接数
+    std::atomic<int64_t> pendingOutputBytes_; // 本loop上所有连接发送队列中还没有发出去的字节数
+    std::unique_ptr<LoopMetrics> metrics_; // 引用上面两个负载统计，所以放在它们之后
 };
\ No newline at end of file
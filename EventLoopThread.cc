@@ -1,15 +1,24 @@
 #include "EventLoopThread.h"
 #include "EventLoop.h"
 
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
 EventLoopThread::EventLoopThread(const ThreadInitCallback& cb, 
-    const std::string& name)
+    const std::string& name,
+    EventLoop::PollerType pollerType)
     : loop_(nullptr)
     , exiting_(false)
     , thread_(std::bind(&EventLoopThread::threadFunc, this), name)
     , mutex_()
     , cond_()
     , callback_(cb)
+    , pollerType_(pollerType)
 {
+    placement_.tid = 0;
+    placement_.cpu = -1;
+    placement_.node = -1;
 }
 
 EventLoopThread::~EventLoopThread() {
@@ -34,17 +43,46 @@ EventLoop* EventLoopThread::startLoop() {
     return loop;
 }
 
+EventLoopThread::Placement EventLoopThread::placement() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return placement_;
+}
+
 // TODO 剖析one loop per thread：调用startLoop时底层函数才创建线程，同时构造函数参数创建一个事件循环
 // 下面的方法是在单独的新线程里面运行
 void EventLoopThread::threadFunc() {
-    EventLoop loop; // 创建一个单独的eventloop，和上面的线程是一一对应的，one loop per thread
+    EventLoop loop(pollerType_); // 创建一个单独的eventloop，和上面的线程是一一对应的，one loop per thread
 
     if(callback_) {
         callback_(&loop); // TcpServer中传来的线程初始化回调
     }
 
+    // 记录绑核以后的实际位置，给EventLoopThreadPool::layoutReport使用
+    Placement placement;
+    placement.name = thread_.name();
+    placement.tid = CurrentThread::tid();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(::sched_getaffinity(0, sizeof set, &set) == 0) {
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if(CPU_ISSET(cpu, &set)) {
+                placement.cpus.push_back(cpu);
+            }
+        }
+    }
+    unsigned cpu = 0, node = 0;
+    if(::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        placement.cpu = static_cast<int>(cpu);
+        placement.node = static_cast<int>(node);
+    }
+    else {
+        placement.cpu = -1;
+        placement.node = -1;
+    }
+
     { // std::condition_variable 对象通常使用 std::unique_lock<std::mutex> 来等待
         std::unique_lock<std::mutex> lock(mutex_);
+        placement_ = placement;
         loop_ = &loop;
         cond_.notify_one(); // cond_.notify_one() 通常和 cond_.wait() 对应使用
     }
@@ -2,28 +2,44 @@
 
 #include "Thread.h"
 #include "noncopyable.h"
+#include "EventLoop.h"
 
 #include <mutex>
 #include <functional>
 #include <string>
 #include <condition_variable> // 条件变量头文件
+#include <vector>
 
 /**
  * 条件变量是利用线程间共享的全局变量进行同步的一种机制，主要包括两个动作：一个线程等待 
  * 条件变量的条件成立而挂起;另一个线程使条件成立（给出条件成立信号）。为了防止竞争，条件变量的使用总是和一个互斥量结合在一起
 */ 
 
-class EventLoop;
-
 class EventLoopThread : noncopyable {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
 
+    // loop线程启动以后实际所在的位置
+    struct Placement {
+        std::string name;
+        pid_t tid;
+        std::vector<int> cpus; // 允许运行的CPU
+        int cpu; // 启动时所在的CPU
+        int node; // 启动时所在的NUMA节点
+    };
+
     EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(), 
-        const std::string& name = std::string() );
+        const std::string& name = std::string(),
+        EventLoop::PollerType pollerType = EventLoop::kDefaultPoller);
     ~EventLoopThread();
 
+    // 需要在startLoop之前设置
+    void setCpuAffinity(const std::vector<int>& cpus) { thread_.setCpuAffinity(cpus); }
+    void setNumaLocal(bool on) { thread_.setNumaLocal(on); }
+
     EventLoop* startLoop();
+    // startLoop返回以后才有效
+    Placement placement();
 private:
     void threadFunc();
 
@@ -33,4 +49,6 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallback callback_;
+    EventLoop::PollerType pollerType_;
+    Placement placement_;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
+#include "InetAddress.h"
 
 #include <memory>
 
@@ -9,6 +10,10 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const std::string&
     , started_(false)
     , numThreads_(0)
     , next_(0)
+    , pollerType_(EventLoop::kDefaultPoller)
+    , numaLocal_(false)
+    , loadBalance_(kRoundRobin)
+    , randomState_(2463534242u)
 { }
 
 EventLoopThreadPool::~EventLoopThreadPool() { }
@@ -20,7 +25,11 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb) {
     for(int i = 0; i < numThreads_; ++i) {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof(buf), "%s%d", name_.c_str(), i);
-        EventLoopThread* t = new EventLoopThread(cb, buf);
+        EventLoopThread* t = new EventLoopThread(cb, buf, pollerType_);
+        if(!cpuSets_.empty()) {
+            t->setCpuAffinity(cpuSets_[i % cpuSets_.size()]);
+        }
+        t->setNumaLocal(numaLocal_);
         threads_.push_back(std::unique_ptr<EventLoopThread>(t)); //  创建的实际上是一个 std::unique_ptr 对象，该对象所包含的指针指向 EventLoopThread 类型的实例 t
         loops_.push_back(t->startLoop()); // 底层创建线程，绑定一个新的EventLoop，并返回该loop的地址
     }
@@ -46,6 +55,99 @@ EventLoop* EventLoopThreadPool::getNextLoop() {
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getLoopForPeer(const InetAddress& peerAddr) {
+    if(loops_.empty()) {
+        return baseLoop_;
+    }
+    if(loopSelector_) {
+        return loopSelector_(loops_, peerAddr);
+    }
+
+    const size_t n = loops_.size();
+    switch(loadBalance_) {
+    case kLeastConnections: {
+        // 从轮询位置开始找，负载相同时依次分到不同的loop
+        size_t best = next_;
+        for(size_t i = 1; i < n; ++i) {
+            size_t index = (next_ + i) % n;
+            if(loops_[index]->numConnections() < loops_[best]->numConnections()) {
+                best = index;
+            }
+        }
+        next_ = (best + 1) % n;
+        return loops_[best];
+    }
+    case kLeastPendingBytes: {
+        size_t best = next_;
+        for(size_t i = 1; i < n; ++i) {
+            size_t index = (next_ + i) % n;
+            if(loops_[index]->pendingOutputBytes() < loops_[best]->pendingOutputBytes()) {
+                best = index;
+            }
+        }
+        next_ = (best + 1) % n;
+        return loops_[best];
+    }
+    case kPowerOfTwoChoices: {
+        EventLoop* a = loops_[nextRandom() % n];
+        EventLoop* b = loops_[nextRandom() % n];
+        if(a->numConnections() != b->numConnections()) {
+            return a->numConnections() < b->numConnections() ? a : b;
+        }
+        return a->pendingOutputBytes() <= b->pendingOutputBytes() ? a : b;
+    }
+    case kHashByPeer: {
+        // 只用ip不用端口，同一个客户端的多个连接在同一个loop
+        uint32_t ip = ntohl(peerAddr.getSockAddr()->sin_addr.s_addr);
+        return loops_[(ip * 2654435761u) % n];
+    }
+    case kRoundRobin:
+    default:
+        return getNextLoop();
+    }
+}
+
+uint32_t EventLoopThreadPool::nextRandom() {
+    uint32_t x = randomState_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState_ = x;
+    return x;
+}
+
+// 把CPU列表压缩成0-3,8这样的形式
+static std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string result;
+    for(size_t i = 0; i < cpus.size(); ) {
+        size_t j = i;
+        while(j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        if(!result.empty()) {
+            result += ',';
+        }
+        result += std::to_string(cpus[i]);
+        if(j > i) {
+            result += '-' + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return result;
+}
+
+std::string EventLoopThreadPool::layoutReport() {
+    std::string report;
+    char buf[256];
+    for(size_t i = 0; i < threads_.size(); ++i) {
+        EventLoopThread::Placement p = threads_[i]->placement();
+        snprintf(buf, sizeof buf, "%s tid=%d cpus=%s cpu=%d node=%d\n",
+                 p.name.c_str(), static_cast<int>(p.tid), formatCpuList(p.cpus).c_str(), p.cpu, p.node);
+        report += buf;
+    }
+    return report;
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops() {
     if(loops_.empty()) {
         return std::vector<EventLoop*>(1, baseLoop_);
@@ -1,40 +1,75 @@
 #pragma once
 
 #include "noncopyable.h"
+#include "EventLoop.h"
 
 #include <functional>
 #include <string>
 #include <vector>
 #include <memory>
+#include <stdint.h>
 
-class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : noncopyable {
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
+    // 自定义的subLoop选择策略
+    using LoopSelector = std::function<EventLoop*(const std::vector<EventLoop*>& loops, const InetAddress& peerAddr)>;
+
+    // 新连接选择subLoop的策略，负载统计由TcpConnection维护
+    enum LoadBalance {
+        kRoundRobin, // 轮询
+        kLeastConnections, // 连接数最少的loop
+        kLeastPendingBytes, // 发送队列积压字节数最少的loop
+        kPowerOfTwoChoices, // 随机选两个loop，取连接数少的，连接数相同时取积压字节数少的
+        kHashByPeer, // 按对端ip哈希，同一个客户端总是分到同一个loop
+    };
 
     EventLoopThreadPool(EventLoop* baseLoop, const std::string& nameArg);
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    // subLoop使用的IO复用实现，需要在start之前设置
+    void setPollerType(EventLoop::PollerType type) { pollerType_ = type; }
+    // 第i个subLoop线程绑定到cpuSets[i % cpuSets.size()]中的CPU上，需要在start之前设置
+    void setCpuAffinity(const std::vector<std::vector<int>>& cpuSets) { cpuSets_ = cpuSets; }
+    // subLoop线程的内存从本地NUMA节点分配，需要在start之前设置
+    void setNumaLocal(bool on) { numaLocal_ = on; }
+    // 每个subLoop线程的名字、tid、CPU和NUMA节点，一行一个
+    std::string layoutReport();
 
     // start()、getNextLoop()、getAllLoops() 等，用于启动事件循环线程池、获取下一个事件循环对象和获取所有事件循环对象
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
     
     // 如果工作在多线程中，baseLoop_默认以轮询的方式分配channel给subloop
     EventLoop* getNextLoop();
+    // 按setLoadBalance/setLoopSelector设置的策略为新连接选择subloop，只在baseLoop_中调用
+    EventLoop* getLoopForPeer(const InetAddress& peerAddr);
+
+    void setLoadBalance(LoadBalance policy) { loadBalance_ = policy; }
+    // 设置以后优先于setLoadBalance
+    void setLoopSelector(const LoopSelector& selector) { loopSelector_ = selector; }
 
     std::vector<EventLoop*> getAllLoops();
 
     bool started() const { return started_; }
     const std::string name() const { return name_; }
 private:
+    uint32_t nextRandom();
+
     EventLoop* baseLoop_; // EventLoop loop;
     std::string name_;
     bool started_;
     int numThreads_;
     int next_;
+    EventLoop::PollerType pollerType_;
+    std::vector<std::vector<int>> cpuSets_;
+    bool numaLocal_;
+    LoadBalance loadBalance_;
+    LoopSelector loopSelector_;
+    uint32_t randomState_; // kPowerOfTwoChoices使用的xorshift随机数状态
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     std::vector<EventLoop*> loops_;
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string.h>
+#include <string>
+
+const int kSmallBuffer = 4000;
+const int kLargeBuffer = 4000 * 1000;
+
+// 固定大小的日志缓冲区，空间不够时由调用者决定怎么处理，不会自动扩容
+template<int SIZE>
+class FixedBuffer : noncopyable {
+public:
+    FixedBuffer()
+        : cur_(data_)
+    {}
+
+    // 空间不够时返回false，调用者自己决定换一块缓冲区还是丢弃
+    bool append(const char* buf, size_t len) {
+        if(static_cast<size_t>(avail()) <= len) {
+            return false;
+        }
+        memcpy(cur_, buf, len);
+        cur_ += len;
+        return true;
+    }
+
+    const char* data() const { return data_; }
+    int length() const { return static_cast<int>(cur_ - data_); }
+
+    char* current() { return cur_; }
+    int avail() const { return static_cast<int>(end() - cur_); }
+    void add(size_t len) { cur_ += len; }
+
+    void reset() { cur_ = data_; }
+    void bzero() { ::memset(data_, 0, sizeof data_); }
+
+    std::string toString() const { return std::string(data_, length()); }
+private:
+    const char* end() const { return data_ + sizeof data_; }
+
+    char data_[SIZE];
+    char* cur_;
+};
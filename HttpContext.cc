@@ -0,0 +1,329 @@
+#include "HttpContext.h"
+#include "Buffer.h"
+
+#include <string.h>
+#include <algorithm>
+
+const size_t HttpContext::kDefaultMaxHeaderSize;
+const size_t HttpContext::kDefaultMaxBodySize;
+
+// chunk大小那一行的最大长度，包括chunk扩展
+static const size_t kMaxChunkSizeLine = 1024;
+
+static int hexValue(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+HttpContext::HttpContext(size_t maxHeaderSize, size_t maxBodySize)
+    : maxHeaderSize_(maxHeaderSize)
+    , maxBodySize_(maxBodySize)
+{
+    reset();
+}
+
+void HttpContext::reset() {
+    state_ = kExpectRequestLine;
+    parsed_ = 0;
+    contentLength_ = 0;
+    hasContentLength_ = false;
+    chunked_ = false;
+    chunkRemaining_ = 0;
+    framingBytes_ = 0;
+    methodRange_ = Range{0, 0};
+    pathRange_ = Range{0, 0};
+    queryRange_ = Range{0, 0};
+    bodyRange_ = Range{0, 0};
+    headerRanges_.clear();
+    chunkedBody_.clear();
+    errorCode_ = HttpResponse::kUnknown;
+    request_.method_ = HttpRequest::kInvalid;
+    request_.version_ = HttpRequest::kUnknown;
+    request_.headers_.clear();
+}
+
+HttpContext::ParseResult HttpContext::fail(HttpResponse::StatusCode code) {
+    errorCode_ = code;
+    return kError;
+}
+
+HttpContext::ParseResult HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime) {
+    if(errorCode_ != HttpResponse::kUnknown) {
+        return kError;
+    }
+
+    const char* base = buf->peek();
+    const char* end = buf->beginWrite();
+    while(state_ != kGotAll) {
+        const char* start = base + parsed_;
+        if(state_ == kExpectRequestLine || state_ == kExpectHeaders) {
+            const char* crlf = buf->findCRLF(start);
+            if(crlf == nullptr) {
+                if(static_cast<size_t>(end - base) > maxHeaderSize_) {
+                    return fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+                }
+                return kIncomplete;
+            }
+            if(static_cast<size_t>(crlf + 2 - base) > maxHeaderSize_) {
+                return fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+            }
+
+            if(state_ == kExpectRequestLine) {
+                if(!processRequestLine(base, start, crlf)) {
+                    return kError;
+                }
+                state_ = kExpectHeaders;
+            }
+            else if(crlf == start) { // 空行，头部结束
+                if(chunked_) {
+                    state_ = kExpectChunkSize;
+                }
+                else if(contentLength_ > 0) {
+                    state_ = kExpectBody;
+                }
+                else {
+                    state_ = kGotAll;
+                }
+            }
+            else if(!processHeader(base, start, crlf)) {
+                return kError;
+            }
+            parsed_ = crlf + 2 - base;
+            framingBytes_ = parsed_;
+        }
+        else if(state_ == kExpectBody) {
+            if(static_cast<size_t>(end - start) < contentLength_) {
+                return kIncomplete;
+            }
+            bodyRange_ = Range{parsed_, contentLength_};
+            parsed_ += contentLength_;
+            state_ = kGotAll;
+        }
+        else if(state_ == kExpectChunkSize) {
+            const char* crlf = buf->findCRLF(start);
+            if(crlf == nullptr) {
+                if(static_cast<size_t>(end - start) > kMaxChunkSizeLine
+                   || framingBytes_ + (end - start) > maxHeaderSize_) {
+                    return fail(HttpResponse::k400BadRequest);
+                }
+                return kIncomplete;
+            }
+            framingBytes_ += crlf + 2 - start;
+            if(framingBytes_ > maxHeaderSize_) {
+                return fail(HttpResponse::k400BadRequest);
+            }
+            if(!processChunkSize(start, crlf)) {
+                return kError;
+            }
+            parsed_ = crlf + 2 - base;
+        }
+        else if(state_ == kExpectChunkData) {
+            if(static_cast<size_t>(end - start) < chunkRemaining_ + 2) {
+                return kIncomplete;
+            }
+            if(start[chunkRemaining_] != '\r' || start[chunkRemaining_ + 1] != '\n') {
+                return fail(HttpResponse::k400BadRequest);
+            }
+            chunkedBody_.append(start, chunkRemaining_);
+            parsed_ += chunkRemaining_ + 2;
+            framingBytes_ += 2;
+            state_ = kExpectChunkSize;
+        }
+        else { // kExpectChunkTrailer，trailer中的字段直接忽略
+            const char* crlf = buf->findCRLF(start);
+            if(crlf == nullptr) {
+                if(framingBytes_ + (end - start) > maxHeaderSize_) {
+                    return fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+                }
+                return kIncomplete;
+            }
+            framingBytes_ += crlf + 2 - start;
+            if(framingBytes_ > maxHeaderSize_) {
+                return fail(HttpResponse::k431RequestHeaderFieldsTooLarge);
+            }
+            if(crlf == start) {
+                state_ = kGotAll;
+            }
+            parsed_ = crlf + 2 - base;
+        }
+    }
+
+    bindRequest(base, receiveTime);
+    return kGotRequest;
+}
+
+void HttpContext::retrieveRequest(Buffer* buf) {
+    buf->retrieve(parsed_);
+    reset();
+}
+
+// GET /index.html?a=1 HTTP/1.1
+bool HttpContext::processRequestLine(const char* base, const char* begin, const char* end) {
+    const char* space = std::find(begin, end, ' ');
+    if(space == begin || space == end) {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    methodRange_ = rangeOf(base, begin, space);
+    StringPiece method(begin, space - begin);
+    if(method == "GET") {
+        request_.method_ = HttpRequest::kGet;
+    }
+    else if(method == "POST") {
+        request_.method_ = HttpRequest::kPost;
+    }
+    else if(method == "HEAD") {
+        request_.method_ = HttpRequest::kHead;
+    }
+    else if(method == "PUT") {
+        request_.method_ = HttpRequest::kPut;
+    }
+    else if(method == "DELETE") {
+        request_.method_ = HttpRequest::kDelete;
+    }
+    else if(method == "OPTIONS") {
+        request_.method_ = HttpRequest::kOptions;
+    }
+    else if(method == "PATCH") {
+        request_.method_ = HttpRequest::kPatch;
+    }
+    else {
+        errorCode_ = HttpResponse::k501NotImplemented;
+        return false;
+    }
+
+    const char* target = space + 1;
+    space = std::find(target, end, ' ');
+    if(space == target || space == end) {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    const char* question = std::find(target, space, '?');
+    pathRange_ = rangeOf(base, target, question);
+    if(question != space) {
+        queryRange_ = rangeOf(base, question + 1, space);
+    }
+
+    const char* version = space + 1;
+    if(end - version != 8 || ::memcmp(version, "HTTP/1.", 7) != 0) {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    if(version[7] == '1') {
+        request_.version_ = HttpRequest::kHttp11;
+    }
+    else if(version[7] == '0') {
+        request_.version_ = HttpRequest::kHttp10;
+    }
+    else {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    return true;
+}
+
+// Field: value
+bool HttpContext::processHeader(const char* base, const char* begin, const char* end) {
+    const char* colon = std::find(begin, end, ':');
+    // 不支持obs-fold续行，字段名前后也不允许有空白
+    if(colon == end || colon == begin || *begin == ' ' || *begin == '\t' || colon[-1] == ' ' || colon[-1] == '\t') {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    const char* value = colon + 1;
+    while(value < end && (*value == ' ' || *value == '\t')) {
+        ++value;
+    }
+    const char* valueEnd = end;
+    while(valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+        --valueEnd;
+    }
+    headerRanges_.push_back(std::make_pair(rangeOf(base, begin, colon), rangeOf(base, value, valueEnd)));
+
+    StringPiece field(begin, colon - begin);
+    if(field.equalsIgnoreCase("Content-Length")) {
+        if(value == valueEnd) {
+            errorCode_ = HttpResponse::k400BadRequest;
+            return false;
+        }
+        size_t length = 0;
+        for(const char* p = value; p < valueEnd; ++p) {
+            if(*p < '0' || *p > '9') {
+                errorCode_ = HttpResponse::k400BadRequest;
+                return false;
+            }
+            length = length * 10 + (*p - '0');
+            if(length > maxBodySize_) {
+                errorCode_ = HttpResponse::k413PayloadTooLarge;
+                return false;
+            }
+        }
+        // 多个不一致的Content-Length可能是请求走私
+        if(hasContentLength_ && length != contentLength_) {
+            errorCode_ = HttpResponse::k400BadRequest;
+            return false;
+        }
+        contentLength_ = length;
+        hasContentLength_ = true;
+    }
+    else if(field.equalsIgnoreCase("Transfer-Encoding")) {
+        if(!StringPiece(value, valueEnd - value).equalsIgnoreCase("chunked")) {
+            errorCode_ = HttpResponse::k501NotImplemented;
+            return false;
+        }
+        chunked_ = true;
+    }
+
+    // 同时有Content-Length和chunked时无法确定请求的边界
+    if(chunked_ && hasContentLength_) {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    return true;
+}
+
+// 1a;name=value
+bool HttpContext::processChunkSize(const char* begin, const char* end) {
+    size_t size = 0;
+    const char* p = begin;
+    for(; p < end && hexValue(*p) >= 0; ++p) {
+        size = size * 16 + hexValue(*p);
+        if(size > maxBodySize_) {
+            errorCode_ = HttpResponse::k413PayloadTooLarge;
+            return false;
+        }
+    }
+    if(p == begin || (p < end && *p != ';' && *p != ' ' && *p != '\t')) {
+        errorCode_ = HttpResponse::k400BadRequest;
+        return false;
+    }
+    if(chunkedBody_.size() + size > maxBodySize_) {
+        errorCode_ = HttpResponse::k413PayloadTooLarge;
+        return false;
+    }
+
+    chunkRemaining_ = size;
+    state_ = size == 0 ? kExpectChunkTrailer : kExpectChunkData;
+    return true;
+}
+
+void HttpContext::bindRequest(const char* base, Timestamp receiveTime) {
+    request_.methodString_ = pieceOf(base, methodRange_);
+    request_.path_ = pieceOf(base, pathRange_);
+    request_.query_ = pieceOf(base, queryRange_);
+    request_.body_ = chunked_ ? StringPiece(chunkedBody_) : pieceOf(base, bodyRange_);
+    request_.receiveTime_ = receiveTime;
+    request_.headers_.clear();
+    for(const auto& range : headerRanges_) {
+        HttpRequest::Header header = { pieceOf(base, range.first), pieceOf(base, range.second) };
+        request_.headers_.push_back(header);
+    }
+}
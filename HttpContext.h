@@ -0,0 +1,95 @@
+#pragma once
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "Timestamp.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+class Buffer;
+
+/**
+ * 每个HTTP连接一个，增量解析接收Buffer中的请求
+ * 解析直接在buf->peek()上进行，已经解析过的部分记录为相对peek()的偏移，数据不断到达时从上次停下的位置继续，
+ * 不会重复扫描，也不拷贝；整个请求到齐以后HttpRequest的字段才指向Buffer中的数据
+ * 请求处理完调用retrieveRequest取走这个请求，同一个Buffer中流水线发送的下一个请求接着解析
+*/
+class HttpContext {
+public:
+    enum ParseResult {
+        kIncomplete, // 数据还不完整，等待更多数据
+        kGotRequest, // 解析出一个完整的请求，request()有效
+        kError, // 请求格式错误或者超出限制，应当返回errorCode()并关闭连接
+    };
+
+    static const size_t kDefaultMaxHeaderSize = 64 * 1024;
+    static const size_t kDefaultMaxBodySize = 8 * 1024 * 1024;
+
+    explicit HttpContext(size_t maxHeaderSize = kDefaultMaxHeaderSize,
+                         size_t maxBodySize = kDefaultMaxBodySize);
+
+    // 从上次停下的位置继续解析，不取走buf中的数据
+    ParseResult parseRequest(Buffer* buf, Timestamp receiveTime);
+    const HttpRequest& request() const { return request_; }
+    // 从buf中取走刚处理完的请求，准备解析下一个
+    void retrieveRequest(Buffer* buf);
+
+    HttpResponse::StatusCode errorCode() const { return errorCode_; }
+private:
+    enum State {
+        kExpectRequestLine,
+        kExpectHeaders,
+        kExpectBody,
+        kExpectChunkSize,
+        kExpectChunkData,
+        kExpectChunkTrailer,
+        kGotAll,
+    };
+
+    // 相对buf->peek()的偏移，Buffer扩容搬移数据以后仍然有效
+    struct Range {
+        size_t offset;
+        size_t length;
+    };
+
+    bool processRequestLine(const char* base, const char* begin, const char* end);
+    bool processHeader(const char* base, const char* begin, const char* end);
+    bool processChunkSize(const char* begin, const char* end);
+    ParseResult fail(HttpResponse::StatusCode code);
+    void bindRequest(const char* base, Timestamp receiveTime);
+    void reset();
+
+    static Range rangeOf(const char* base, const char* begin, const char* end) {
+        Range range = { static_cast<size_t>(begin - base), static_cast<size_t>(end - begin) };
+        return range;
+    }
+
+    static StringPiece pieceOf(const char* base, Range range) {
+        return StringPiece(base + range.offset, range.length);
+    }
+
+    const size_t maxHeaderSize_;
+    const size_t maxBodySize_;
+
+    State state_;
+    size_t parsed_; // 当前请求已经解析过的字节数
+    size_t contentLength_;
+    bool hasContentLength_;
+    bool chunked_;
+    size_t chunkRemaining_;
+    // chunk数据以外已经解析的字节数：请求行、头部、chunk大小行、chunk后面的CRLF、trailer
+    // 这些数据在请求完成之前一直留在Buffer中，总数不超过maxHeaderSize_，对端不能用很小的chunk或者无穷的trailer让Buffer无限增长
+    size_t framingBytes_;
+
+    Range methodRange_;
+    Range pathRange_;
+    Range queryRange_;
+    Range bodyRange_;
+    std::vector<std::pair<Range, Range>> headerRanges_;
+    std::string chunkedBody_; // chunked编码的body在Buffer中不连续，只有这种情况需要拷贝
+
+    HttpResponse::StatusCode errorCode_;
+    HttpRequest request_;
+};
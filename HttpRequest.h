@@ -0,0 +1,68 @@
+#pragma once
+
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <vector>
+
+class HttpContext;
+
+/**
+ * 解析得到的HTTP请求，由HttpContext填充
+ * 所有字段都直接指向连接的接收Buffer，不拷贝，只在HttpServer的回调期间有效，
+ * 需要保留到回调之后的字段要自己as_string()拷贝一份
+*/
+class HttpRequest {
+public:
+    enum Method { kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions, kPatch };
+    enum Version { kUnknown, kHttp10, kHttp11 };
+
+    struct Header {
+        StringPiece field;
+        StringPiece value;
+    };
+
+    HttpRequest()
+        : method_(kInvalid)
+        , version_(kUnknown)
+    {}
+
+    Method method() const { return method_; }
+    StringPiece methodString() const { return methodString_; }
+    Version version() const { return version_; }
+    StringPiece path() const { return path_; }
+    StringPiece query() const { return query_; } // 不包含'?'
+    StringPiece body() const { return body_; }
+    Timestamp receiveTime() const { return receiveTime_; }
+    const std::vector<Header>& headers() const { return headers_; }
+
+    // 字段名不区分大小写，没有这个字段时返回空
+    StringPiece getHeader(const StringPiece& field) const {
+        for(const Header& header : headers_) {
+            if(header.field.equalsIgnoreCase(field)) {
+                return header.value;
+            }
+        }
+        return StringPiece();
+    }
+
+    // HTTP/1.1默认保持连接，除非Connection: close；HTTP/1.0默认关闭，除非Connection: Keep-Alive
+    bool keepAlive() const {
+        StringPiece connection = getHeader("Connection");
+        if(version_ == kHttp11) {
+            return !connection.equalsIgnoreCase("close");
+        }
+        return connection.equalsIgnoreCase("keep-alive");
+    }
+
+    friend class HttpContext;
+private:
+    Method method_;
+    Version version_;
+    StringPiece methodString_;
+    StringPiece path_;
+    StringPiece query_;
+    StringPiece body_;
+    Timestamp receiveTime_;
+    std::vector<Header> headers_; // 每个请求clear后复用，预热以后不再分配内存
+};
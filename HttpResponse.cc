@@ -0,0 +1,61 @@
+#include "HttpResponse.h"
+#include "Buffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char* HttpResponse::defaultStatusMessage(int code) {
+    switch(code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+void HttpResponse::appendToBuffer(Buffer* output, bool withBody) const {
+    char buf[64];
+    int code = statusCode_ == kUnknown ? static_cast<int>(k500InternalServerError) : static_cast<int>(statusCode_);
+    int n = snprintf(buf, sizeof buf, "HTTP/1.1 %d ", code);
+    output->append(buf, n);
+    if(statusMessage_.empty()) {
+        output->append(defaultStatusMessage(code), ::strlen(defaultStatusMessage(code)));
+    }
+    else {
+        output->append(statusMessage_);
+    }
+    output->append("\r\n", 2);
+
+    if(closeConnection_) {
+        output->append("Connection: close\r\n", 19);
+    }
+    else {
+        output->append("Connection: Keep-Alive\r\n", 24);
+    }
+    // 保持连接时对端靠Content-Length找到下一个响应的开始
+    n = snprintf(buf, sizeof buf, "Content-Length: %zu\r\n", body_.size());
+    output->append(buf, n);
+
+    for(const auto& header : headers_) {
+        output->append(header.first);
+        output->append(": ", 2);
+        output->append(header.second);
+        output->append("\r\n", 2);
+    }
+
+    output->append("\r\n", 2);
+    if(withBody) {
+        output->append(body_);
+    }
+}
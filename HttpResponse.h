@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+class Buffer;
+
+// 回调中填写的HTTP响应，由HttpServer序列化到连接的发送Buffer中
+class HttpResponse {
+public:
+    enum StatusCode {
+        kUnknown,
+        k200Ok = 200,
+        k204NoContent = 204,
+        k301MovedPermanently = 301,
+        k302Found = 302,
+        k304NotModified = 304,
+        k400BadRequest = 400,
+        k403Forbidden = 403,
+        k404NotFound = 404,
+        k405MethodNotAllowed = 405,
+        k413PayloadTooLarge = 413,
+        k431RequestHeaderFieldsTooLarge = 431,
+        k500InternalServerError = 500,
+        k501NotImplemented = 501,
+        k503ServiceUnavailable = 503,
+    };
+
+    explicit HttpResponse(bool close)
+        : statusCode_(kUnknown)
+        , closeConnection_(close)
+    {}
+
+    void setStatusCode(StatusCode code) { statusCode_ = code; }
+    // 不设置时使用状态码对应的标准描述
+    void setStatusMessage(const std::string& message) { statusMessage_ = message; }
+
+    void setCloseConnection(bool on) { closeConnection_ = on; }
+    bool closeConnection() const { return closeConnection_; }
+
+    void setContentType(const std::string& contentType) { addHeader("Content-Type", contentType); }
+    void addHeader(const std::string& key, const std::string& value) {
+        headers_.push_back(std::make_pair(key, value));
+    }
+
+    void setBody(const std::string& body) { body_ = body; }
+    void setBody(std::string&& body) { body_ = std::move(body); }
+    const std::string& body() const { return body_; }
+
+    // 状态行、头部和body依次追加到output，HEAD请求时withBody为false，只保留Content-Length
+    void appendToBuffer(Buffer* output, bool withBody = true) const;
+
+    static const char* defaultStatusMessage(int code);
+private:
+    StatusCode statusCode_;
+    std::string statusMessage_;
+    bool closeConnection_;
+    std::vector<std::pair<std::string, std::string>> headers_;
+    std::string body_;
+};
@@ -0,0 +1,77 @@
+#include "HttpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "Logger.h"
+
+#include <memory>
+
+static void defaultHttpCallback(const HttpRequest&, HttpResponse* resp) {
+    resp->setStatusCode(HttpResponse::k404NotFound);
+    resp->setCloseConnection(true);
+}
+
+HttpServer::HttpServer(EventLoop* loop,
+                       const InetAddress& listenAddr,
+                       const std::string& nameArg,
+                       TcpServer::Option option)
+    : server_(loop, listenAddr, nameArg, option)
+    , httpCallback_(defaultHttpCallback)
+    , maxHeaderSize_(HttpContext::kDefaultMaxHeaderSize)
+    , maxBodySize_(HttpContext::kDefaultMaxBodySize)
+{
+    server_.setConnectionCallback(
+        std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
+    server_.setMessageCallback(
+        std::bind(&HttpServer::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+void HttpServer::start() {
+    LOG_INFO("HttpServer[%s] starts listening \n", server_.name().c_str());
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr& conn) {
+    if(conn->connected()) {
+        conn->setContext(std::make_shared<HttpContext>(maxHeaderSize_, maxBodySize_));
+    }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime) {
+    HttpContext* context = static_cast<HttpContext*>(conn->getContext().get());
+    Buffer output;
+
+    while(true) {
+        HttpContext::ParseResult result = context->parseRequest(buf, receiveTime);
+        if(result == HttpContext::kIncomplete) {
+            break;
+        }
+
+        if(result == HttpContext::kError) {
+            HttpResponse response(true);
+            response.setStatusCode(context->errorCode());
+            response.appendToBuffer(&output);
+            buf->retrieveAll();
+            conn->send(&output);
+            conn->shutdown();
+            return;
+        }
+
+        const HttpRequest& request = context->request();
+        HttpResponse response(!request.keepAlive());
+        httpCallback_(request, &response);
+        response.appendToBuffer(&output, request.method() != HttpRequest::kHead);
+        context->retrieveRequest(buf); // 回调结束以后request中的字段不再有效
+
+        if(response.closeConnection()) {
+            buf->retrieveAll(); // 后面流水线发来的请求不再处理
+            conn->send(&output);
+            conn->shutdown();
+            return;
+        }
+    }
+
+    if(output.readableBytes() > 0) {
+        conn->send(&output);
+    }
+}
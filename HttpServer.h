@@ -0,0 +1,47 @@
+#pragma once
+
+#include "TcpServer.h"
+#include "HttpContext.h"
+#include "noncopyable.h"
+
+#include <functional>
+#include <string>
+
+class HttpRequest;
+class HttpResponse;
+
+/**
+ * 基于TcpServer的HTTP/1.1服务器
+ * 支持keep-alive和流水线：一次onMessage中解析出的所有请求依次回调，
+ * 响应按顺序追加到同一个发送Buffer中，最后一次send交换给TcpConnection，不再拷贝
+*/
+class HttpServer : noncopyable {
+public:
+    using HttpCallback = std::function<void(const HttpRequest&, HttpResponse*)>;
+
+    HttpServer(EventLoop* loop,
+               const InetAddress& listenAddr,
+               const std::string& nameArg,
+               TcpServer::Option option = TcpServer::kNoReusePort);
+
+    EventLoop* getLoop() const { return server_.getLoop(); }
+    // 线程数、负载均衡、边缘触发等TcpServer的配置
+    TcpServer& tcpServer() { return server_; }
+
+    // 回调在连接所在的subLoop中执行，不设置时所有请求返回404
+    void setHttpCallback(const HttpCallback& cb) { httpCallback_ = cb; }
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+    // 请求行加头部、body的最大字节数，超过时返回431/413并关闭连接，需要在start之前设置
+    void setMaxHeaderSize(size_t size) { maxHeaderSize_ = size; }
+    void setMaxBodySize(size_t size) { maxBodySize_ = size; }
+
+    void start();
+private:
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    TcpServer server_;
+    HttpCallback httpCallback_;
+    size_t maxHeaderSize_;
+    size_t maxBodySize_;
+};
@@ -0,0 +1,348 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cstring>
+
+// channel未添加到poller中
+const int kNew = -1;
+// channel已添加到poller中
+const int kAdded = 1;
+
+// 删除poll请求本身的完成事件不需要处理
+static const uint64_t kInternalUserData = 0;
+
+static int sysIoUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                           unsigned flags, const void* arg, size_t argSize) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop)
+    , ringFd_(-1)
+    , multishotSupported_(true)
+    , sqRing_(MAP_FAILED)
+    , sqRingSize_(0)
+    , cqRing_(MAP_FAILED)
+    , cqRingSize_(0)
+    , sqes_(static_cast<io_uring_sqe*>(MAP_FAILED))
+    , sqesSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqMask_(0)
+    , sqEntries_(0)
+    , sqArray_(nullptr)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(0)
+    , cqes_(nullptr)
+    , toSubmit_(0)
+    , nextGeneration_(1)
+    , round_(0)
+{
+    if(!setupRing()) {
+        closeRing();
+    }
+}
+
+IoUringPoller::~IoUringPoller() {
+    closeRing();
+}
+
+bool IoUringPoller::setupRing() {
+    io_uring_params params;
+    ::memset(&params, 0, sizeof params);
+    // 只有loop线程使用这个ring，完成事件在下一次io_uring_enter时处理即可，不需要打断loop线程
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    ringFd_ = sysIoUringSetup(kRingEntries, &params);
+    if(ringFd_ < 0 && errno == EINVAL) { // 老内核不认识这些标志
+        ::memset(&params, 0, sizeof params);
+        ringFd_ = sysIoUringSetup(kRingEntries, &params);
+    }
+    if(ringFd_ < 0) {
+        LOG_ERROR("io_uring_setup error:%d \n", errno);
+        return false;
+    }
+
+    // 需要EXT_ARG实现带超时的等待，NODROP保证完成事件不会因为CQ满了被丢掉
+    const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if((params.features & required) != required) {
+        LOG_ERROR("io_uring features 0x%x not supported \n", params.features);
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqRingSize_ = std::max(sqRingSize_, cqRingSize_); // SINGLE_MMAP：SQ和CQ在同一块内存中
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if(sqRing_ == MAP_FAILED) {
+        LOG_ERROR("io_uring mmap sq ring error:%d \n", errno);
+        return false;
+    }
+    cqRing_ = sqRing_;
+    cqRingSize_ = 0;
+
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+    if(sqes_ == MAP_FAILED) {
+        LOG_ERROR("io_uring mmap sqes error:%d \n", errno);
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void IoUringPoller::closeRing() {
+    if(sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sqesSize_);
+        sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    }
+    if(sqRing_ != MAP_FAILED) {
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = MAP_FAILED;
+        cqRing_ = MAP_FAILED;
+    }
+    if(ringFd_ >= 0) {
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels) {
+    LOG_DEBUG("func=%s => fd total count:%lu \n", __FUNCTION__, channels_.size());
+    rearmPending();
+
+    // CQ中已经有完成事件时不用等待，只把注册变化提交上去
+    int ret = 0;
+    if(completionReady()) {
+        if(toSubmit_ > 0) {
+            ++ctlCalls_;
+            ret = enter(toSubmit_, 0, 0);
+        }
+    }
+    else {
+        ++pollCalls_;
+        ret = enter(toSubmit_, 1, timeoutMs);
+    }
+    int saveErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if(ret < 0 && saveErrno != ETIME && saveErrno != EINTR && saveErrno != EBUSY) {
+        errno = saveErrno;
+        LOG_ERROR("IoUringPoller::poll() err!");
+    }
+    reapCompletions(activeChannels);
+    return now;
+}
+
+// 和EpollPoller一样，channel的事件变化通过updateChannel/removeChannel通知poller
+// 这里只是把POLL_ADD/POLL_REMOVE放进SQ，下一次poll时和等待一起提交
+void IoUringPoller::updateChannel(Channel* channel) {
+    const int fd = channel->fd();
+    LOG_DEBUG("func=%s => fd=%d events=%d index=%d \n", __FUNCTION__, fd, channel->events(), channel->index());
+
+    if(static_cast<size_t>(fd) >= registrations_.size()) {
+        Registration empty = { nullptr, 0, false, false, 0 };
+        registrations_.resize(std::max<size_t>(fd + 1, registrations_.size() * 2), empty);
+    }
+    Registration& reg = registrations_[fd];
+
+    if(channel->index() == kNew) {
+        channels_[fd] = channel;
+        reg.channel = channel;
+        reg.round = 0;
+        channel->set_index(kAdded);
+    }
+
+    if(reg.armed) {
+        queuePollRemove(reg);
+    }
+    reg.generation = nextGeneration_++; // 之前注册产生的完成事件全部作废
+    if(!channel->isNoneEvent()) {
+        queuePollAdd(fd, reg);
+    }
+}
+
+void IoUringPoller::removeChannel(Channel* channel) {
+    const int fd = channel->fd();
+    channels_.erase(fd);
+
+    LOG_DEBUG("func=%s => fd=%d\n", __FUNCTION__, fd);
+
+    if(static_cast<size_t>(fd) < registrations_.size()) {
+        Registration& reg = registrations_[fd];
+        if(reg.armed) {
+            queuePollRemove(reg);
+        }
+        reg.channel = nullptr;
+        reg.generation = 0; // generation从1开始，0不会和任何完成事件匹配
+    }
+    channel->set_index(kNew);
+}
+
+io_uring_sqe* IoUringPoller::getSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail_;
+    if(tail - head >= sqEntries_) {
+        // SQ满了，先把已有的请求提交掉
+        ++ctlCalls_;
+        enter(toSubmit_, 0, 0);
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if(tail - head >= sqEntries_) {
+            LOG_FATAL("io_uring submission queue full \n");
+        }
+    }
+
+    unsigned index = tail & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    ::memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    return sqe;
+}
+
+void IoUringPoller::queuePollAdd(int fd, Registration& reg) {
+    reg.multishot = reg.channel->isEdgeTriggered() && multishotSupported_;
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    // Channel的事件使用EPOLLIN/EPOLLOUT等，取值和POLLIN/POLLOUT相同，EPOLLET由multishot代替
+    sqe->poll32_events = static_cast<uint32_t>(reg.channel->events());
+    sqe->len = reg.multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = (static_cast<uint64_t>(reg.generation) << 32) | static_cast<uint32_t>(fd);
+    reg.armed = true;
+}
+
+void IoUringPoller::queuePollRemove(Registration& reg) {
+    const int fd = reg.channel->fd();
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (static_cast<uint64_t>(reg.generation) << 32) | static_cast<uint32_t>(fd);
+    sqe->user_data = kInternalUserData;
+    reg.armed = false;
+}
+
+// 单次poll触发以后，channel的事件处理完了，重新注册
+void IoUringPoller::rearmPending() {
+    for(int fd : rearmFds_) {
+        Registration& reg = registrations_[fd];
+        if(reg.channel != nullptr && !reg.armed && !reg.channel->isNoneEvent()) {
+            reg.generation = nextGeneration_++;
+            queuePollAdd(fd, reg);
+        }
+    }
+    rearmFds_.clear();
+}
+
+int IoUringPoller::enter(unsigned toSubmit, unsigned minComplete, int timeoutMs) {
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    ::memset(&arg, 0, sizeof arg);
+    if(minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if(timeoutMs >= 0) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+
+    int ret = sysIoUringEnter(ringFd_, toSubmit, minComplete, flags,
+                              minComplete > 0 ? &arg : nullptr, minComplete > 0 ? sizeof arg : 0);
+    if(ret >= 0) {
+        toSubmit_ -= std::min(toSubmit_, static_cast<unsigned>(ret));
+    }
+    return ret;
+}
+
+bool IoUringPoller::completionReady() const {
+    return *cqHead_ != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+}
+
+// 把完成事件转换成channel的revents，同一个channel在一轮中的多个事件合并
+void IoUringPoller::reapCompletions(ChannelList* activeChannels) {
+    ++round_;
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    int numEvents = 0;
+
+    for(; head != tail; ++head) {
+        const io_uring_cqe* cqe = &cqes_[head & cqMask_];
+        if(cqe->user_data == kInternalUserData) {
+            continue;
+        }
+        const int fd = static_cast<int>(cqe->user_data & 0xffffffff);
+        const uint32_t generation = static_cast<uint32_t>(cqe->user_data >> 32);
+        if(static_cast<size_t>(fd) >= registrations_.size()) {
+            continue;
+        }
+        Registration& reg = registrations_[fd];
+        if(reg.channel == nullptr || reg.generation != generation) {
+            continue; // 已经删除或者重新注册过的poll请求
+        }
+
+        if(!(cqe->flags & IORING_CQE_F_MORE)) {
+            // 单次poll已经触发，或者multishot被内核终止了，都需要重新注册
+            reg.armed = false;
+            if(cqe->res == -EINVAL && reg.multishot) {
+                multishotSupported_ = false; // 内核不支持multishot poll，以后都用单次poll
+                rearmFds_.push_back(fd);
+                continue;
+            }
+            if(cqe->res >= 0 || cqe->res == -ECANCELED) {
+                rearmFds_.push_back(fd);
+            }
+        }
+        if(cqe->res < 0) {
+            if(cqe->res != -ECANCELED) {
+                LOG_ERROR("io_uring poll fd=%d error:%d \n", fd, -cqe->res);
+            }
+            continue;
+        }
+
+        Channel* channel = reg.channel;
+        if(reg.round != round_) {
+            reg.round = round_;
+            channel->set_revent(cqe->res);
+            activeChannels->push_back(channel);
+            ++numEvents;
+        }
+        else {
+            channel->set_revent(channel->revents() | cqe->res);
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+    if(numEvents > 0) {
+        LOG_DEBUG("%d events happened \n", numEvents);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <vector>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+class Channel;
+
+/*
+ * io_uring的使用，直接调用系统调用，不依赖liburing
+ * io_uring_setup  创建ring，mmap提交队列SQ和完成队列CQ
+ * IORING_OP_POLL_ADD/IORING_OP_POLL_REMOVE  注册/删除fd感兴趣的事件，先放在SQ中
+ * io_uring_enter  一次系统调用提交SQ中所有的注册变化，同时等待完成事件
+ *
+ * 水平触发的channel使用单次poll，事件处理完以后在下一次poll时重新注册，重新注册时内核会立即检查fd的状态
+ * 边缘触发的channel使用multishot poll，注册一次一直有效
+*/
+class IoUringPoller : public Poller {
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    // 内核不支持io_uring或者缺少需要的特性时返回false，由newDefaultPoller回退到epoll
+    bool valid() const { return ringFd_ >= 0; }
+
+    // 重写基类Poller的抽象方法
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+private:
+    static const unsigned kRingEntries = 256;
+
+    // 每个fd一项，user_data = generation << 32 | fd，generation不一致的完成事件是已经失效的注册产生的
+    struct Registration {
+        Channel* channel;
+        uint32_t generation;
+        bool armed; // 内核中是否还有这个fd的poll请求
+        bool multishot; // 当前的poll请求是否是multishot
+        uint64_t round; // 最近一次被放进activeChannels的poll轮次，同一轮的多个事件合并
+    };
+
+    bool setupRing();
+    void closeRing();
+
+    io_uring_sqe* getSqe();
+    void queuePollAdd(int fd, Registration& reg);
+    void queuePollRemove(Registration& reg);
+    void rearmPending();
+    int enter(unsigned toSubmit, unsigned minComplete, int timeoutMs);
+    bool completionReady() const;
+    void reapCompletions(ChannelList* activeChannels);
+
+    int ringFd_;
+    bool multishotSupported_;
+
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* sqArray_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    unsigned toSubmit_; // SQ中还没有提交给内核的请求数
+
+    std::vector<Registration> registrations_; // 下标是fd
+    std::vector<int> rearmFds_; // 单次poll已经触发，需要重新注册的fd
+    uint32_t nextGeneration_;
+    uint64_t round_;
+};
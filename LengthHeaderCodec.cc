@@ -0,0 +1,53 @@
+#include "LengthHeaderCodec.h"
+#include "TcpConnection.h"
+#include "Buffer.h"
+#include "Logger.h"
+
+#include <stdint.h>
+#include <algorithm>
+
+const size_t LengthHeaderCodec::kHeaderLen;
+const size_t LengthHeaderCodec::kDefaultMaxFrameSize;
+
+LengthHeaderCodec::LengthHeaderCodec(const FrameCallback& cb, size_t maxFrameSize)
+    : frameCallback_(cb)
+    , maxFrameSize_(std::min(maxFrameSize, static_cast<size_t>(INT32_MAX)))
+{
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime) {
+    // 一次可能收到多帧，也可能不到一帧
+    while(buf->readableBytes() >= kHeaderLen) {
+        const int32_t len = buf->peekInt32();
+        if(len < 0 || static_cast<size_t>(len) > maxFrameSize_) {
+            LOG_ERROR("LengthHeaderCodec invalid frame length %d from %s, max %lu \n",
+                len, conn->name().c_str(), maxFrameSize_);
+            buf->retrieveAll();
+            conn->forceClose();
+            break;
+        }
+        if(buf->readableBytes() < kHeaderLen + len) {
+            break;
+        }
+        frameCallback_(conn, StringPiece(buf->peek() + kHeaderLen, len), receiveTime);
+        buf->retrieve(kHeaderLen + len);
+    }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, const StringPiece& frame) const {
+    Buffer buf(frame.size());
+    buf.append(frame.data(), frame.size());
+    send(conn, &buf);
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, Buffer* buf) const {
+    size_t len = buf->readableBytes();
+    if(len > maxFrameSize_) {
+        LOG_ERROR("LengthHeaderCodec frame of %lu bytes to %s exceeds max %lu, dropped \n",
+            len, conn->name().c_str(), maxFrameSize_);
+        buf->retrieveAll();
+        return;
+    }
+    buf->prependInt32(static_cast<int32_t>(len));
+    conn->send(buf);
+}
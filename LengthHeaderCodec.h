@@ -0,0 +1,42 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <functional>
+#include <stdint.h>
+
+class Buffer;
+
+/**
+ * 4字节网络字节序长度头 + 消息体的分帧编解码
+ * 接收：帧完整以后直接把接收Buffer中的消息体交给回调，不拷贝，回调返回以后再取走
+ * 发送：调用者把消息体写进Buffer，send时在kCheapPrepend预留的空间里原地写入长度头，
+ *       再整体交换给TcpConnection，消息体不拷贝
+ * 长度超过maxFrameSize或者为负数时认为对端出错，直接关闭连接，防止对端让接收Buffer无限增长
+*/
+class LengthHeaderCodec : noncopyable {
+public:
+    // frame指向接收Buffer中的消息体，只在回调期间有效
+    using FrameCallback = std::function<void(const TcpConnectionPtr&, StringPiece frame, Timestamp)>;
+
+    static const size_t kHeaderLen = sizeof(int32_t);
+    static const size_t kDefaultMaxFrameSize = 16 * 1024 * 1024;
+
+    explicit LengthHeaderCodec(const FrameCallback& cb, size_t maxFrameSize = kDefaultMaxFrameSize);
+
+    size_t maxFrameSize() const { return maxFrameSize_; }
+
+    // 作为TcpServer/TcpClient的MessageCallback
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    // 拷贝一次frame，加上长度头发送
+    void send(const TcpConnectionPtr& conn, const StringPiece& frame) const;
+    // buf中的可读数据作为一帧，原地加上长度头后发送，调用后buf为空
+    void send(const TcpConnectionPtr& conn, Buffer* buf) const;
+private:
+    FrameCallback frameCallback_;
+    const size_t maxFrameSize_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * 滚动日志文件，由AsyncLogging的outputMutex_保护，自身不加锁
+ * 文件写满rollSize字节或者跨天时，新建一个日志文件
+ * 文件名：basename.20230607-101010.pid.log
+*/
+class LogFile : noncopyable {
+public:
+    LogFile(const std::string& basename,
+            off_t rollSize,
+            int flushInterval = 3,
+            int checkEveryN = 1024);
+    ~LogFile();
+
+    void append(const char* logline, size_t len);
+    void flush();
+    bool rollFile();
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int flushInterval_;
+    const int checkEveryN_;
+
+    int count_; // 距离上一次检查时间写入的次数
+    FILE* fp_;
+    off_t writtenBytes_;
+    time_t startOfPeriod_; // 当前日志文件所属的那一天的开始时间
+    time_t lastRoll_;
+    time_t lastFlush_;
+    char buffer_[64 * 1024]; // fwrite使用的用户态缓冲区
+
+    static const int kRollPerSeconds_ = 60 * 60 * 24;
+};
@@ -0,0 +1,186 @@
+#include "LogStream.h"
+#include "FixedBuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+
+// 每个线程一块，平时只有一行日志在里面，嵌套时按栈的方式往后排
+__thread char t_buffer[kSmallBuffer];
+__thread char* t_cur = nullptr;
+
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+const char kHexDigits[] = "0123456789abcdef";
+
+}
+
+LogStream::LogStream(LogLevel level)
+    : level_(level)
+    , cur_(&t_cur)
+    , end_(t_buffer + sizeof t_buffer - 1) // 最后一个字节留给换行
+    , begin_(nullptr)
+{
+    if(*cur_ == nullptr) {
+        *cur_ = t_buffer;
+    }
+    if(static_cast<size_t>(end_ - *cur_) >= Logger::kPrefixSize) {
+        begin_ = *cur_;
+        *cur_ += Logger::formatPrefix(level, begin_);
+    }
+}
+
+LogStream::~LogStream() {
+    if(begin_ != nullptr) {
+        char* cur = *cur_;
+        *cur++ = '\n';
+        *cur_ = cur; // 输出期间如果又写了日志，接在这一行后面
+        Logger::instance().write(level_, begin_, cur - begin_);
+        *cur_ = begin_;
+    }
+    if(level_ == FATAL) {
+        exit(-1);
+    }
+}
+
+void LogStream::append(const char* data, size_t len) {
+    if(begin_ != nullptr) {
+        char* cur = *cur_;
+        size_t n = std::min(len, static_cast<size_t>(end_ - cur));
+        memcpy(cur, data, n);
+        *cur_ = cur + n;
+    }
+}
+
+// 从低位开始每次转换两位，写到临时缓冲区的末尾，最后一次拷贝
+template<typename T>
+void LogStream::formatInteger(T v) {
+    using U = typename std::make_unsigned<T>::type;
+    char buf[32];
+    char* end = buf + sizeof buf;
+    char* p = end;
+    const bool negative = v < 0;
+    U u = negative ? static_cast<U>(0) - static_cast<U>(v) : static_cast<U>(v);
+    while(u >= 100) {
+        unsigned idx = static_cast<unsigned>(u % 100) * 2;
+        u /= 100;
+        *--p = kDigitPairs[idx + 1];
+        *--p = kDigitPairs[idx];
+    }
+    if(u < 10) {
+        *--p = static_cast<char>('0' + u);
+    }
+    else {
+        unsigned idx = static_cast<unsigned>(u) * 2;
+        *--p = kDigitPairs[idx + 1];
+        *--p = kDigitPairs[idx];
+    }
+    if(negative) {
+        *--p = '-';
+    }
+    append(p, end - p);
+}
+
+LogStream& LogStream::operator<<(bool v) {
+    if(v) {
+        append("true", 4);
+    }
+    else {
+        append("false", 5);
+    }
+    return *this;
+}
+
+LogStream& LogStream::operator<<(char v) {
+    append(&v, 1);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(short v) {
+    formatInteger(static_cast<int>(v));
+    return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned short v) {
+    formatInteger(static_cast<unsigned int>(v));
+    return *this;
+}
+
+LogStream& LogStream::operator<<(int v) {
+    formatInteger(v);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned int v) {
+    formatInteger(v);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(long v) {
+    formatInteger(v);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned long v) {
+    formatInteger(v);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(long long v) {
+    formatInteger(v);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(unsigned long long v) {
+    formatInteger(v);
+    return *this;
+}
+
+// 浮点数不常用，直接用snprintf
+LogStream& LogStream::operator<<(double v) {
+    char buf[32];
+    int n = ::snprintf(buf, sizeof buf, "%.12g", v);
+    if(n > 0) {
+        append(buf, std::min(static_cast<size_t>(n), sizeof buf - 1));
+    }
+    return *this;
+}
+
+LogStream& LogStream::operator<<(const void* p) {
+    uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    char buf[2 + sizeof(uintptr_t) * 2];
+    char* end = buf + sizeof buf;
+    char* q = end;
+    do {
+        *--q = kHexDigits[v & 0xf];
+        v >>= 4;
+    } while(v != 0);
+    *--q = 'x';
+    *--q = '0';
+    append(q, end - q);
+    return *this;
+}
+
+LogStream& LogStream::operator<<(const char* str) {
+    if(str != nullptr) {
+        append(str, strlen(str));
+    }
+    else {
+        append("(null)", 6);
+    }
+    return *this;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Logger.h"
+#include "StringPiece.h"
+#include "noncopyable.h"
+
+#include <string>
+#include <stddef.h>
+
+/**
+ * 流式的日志前端：LOG_STREAM(INFO) << "fd=" << fd << " bytes=" << n;
+ * 整行直接写在线程局部的固定缓冲区中，不分配内存，不清零；整数每次转换两位数字，不经过snprintf
+ * 语句结束时LogStream析构，整行一次交给Logger的output_，FATAL在输出后结束进程
+ * <<的参数里又写了日志时，内层从外层当前写到的位置之后接着写，写完退回去，两条日志互不影响
+ * 一行超出缓冲区的部分被截断
+*/
+class LogStream : noncopyable {
+public:
+    explicit LogStream(LogLevel level);
+    ~LogStream();
+
+    LogStream& operator<<(bool v);
+    LogStream& operator<<(char v);
+    LogStream& operator<<(short v);
+    LogStream& operator<<(unsigned short v);
+    LogStream& operator<<(int v);
+    LogStream& operator<<(unsigned int v);
+    LogStream& operator<<(long v);
+    LogStream& operator<<(unsigned long v);
+    LogStream& operator<<(long long v);
+    LogStream& operator<<(unsigned long long v);
+    LogStream& operator<<(double v);
+    LogStream& operator<<(float v) { return *this << static_cast<double>(v); }
+    LogStream& operator<<(const void* p); // 0x开头的十六进制
+    LogStream& operator<<(const char* str);
+    LogStream& operator<<(const std::string& str) { append(str.data(), str.size()); return *this; }
+    LogStream& operator<<(StringPiece str) { append(str.data(), str.size()); return *this; }
+
+    void append(const char* data, size_t len);
+private:
+    template<typename T>
+    void formatInteger(T v);
+
+    LogLevel level_;
+    // 动态库中每次访问线程局部变量都要调用__tls_get_addr，构造时取一次地址，之后都通过指针访问
+    char** cur_; // 线程缓冲区的写位置，嵌套的LogStream共用
+    char* end_;
+    char* begin_; // 本行在线程缓冲区中的起始位置，缓冲区被外层日志占满时为nullptr，本行丢弃
+};
+
+// 被过滤掉的级别连<<右边的表达式都不求值，低于MUDUO_MIN_LOG_LEVEL的在编译优化时整条删掉
+#define LOG_STREAM(level) if(!Logger::enabled(level)) {} else LogStream(level)
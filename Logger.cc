@@ -1,37 +1,110 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <iostream>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+
+// 常量初始化，其它编译单元的静态对象构造时写日志也能读到INFO
+std::atomic<int> Logger::logLevel_(INFO);
+
+static const char* const kLevelNames[NUM_LOG_LEVELS] = {
+    "[DEBUG]",
+    "[INFO]",
+    "[ERROR]",
+    "[FATAL]",
+};
+
+static const size_t kLevelNameLengths[NUM_LOG_LEVELS] = { 7, 6, 7, 7 };
+
+// 进程启动时读取环境变量MUDUO_LOG_LEVEL
+class InitLogLevel {
+public:
+    InitLogLevel() {
+        const char* env = ::getenv("MUDUO_LOG_LEVEL");
+        if(env == nullptr) {
+            return;
+        }
+        for(int level = DEBUG; level < NUM_LOG_LEVELS; ++level) {
+            // 名字去掉两边的方括号再比较
+            if(::strlen(env) == kLevelNameLengths[level] - 2
+               && ::strncasecmp(env, kLevelNames[level] + 1, kLevelNameLengths[level] - 2) == 0) {
+                Logger::setLogLevel(static_cast<LogLevel>(level));
+            }
+        }
+    }
+};
+InitLogLevel initLogLevelObj;
+
+static void defaultOutput(const char* msg, size_t len) {
+    ::fwrite(msg, 1, len, stdout);
+}
+
+static void defaultFlush() {
+    ::fflush(stdout);
+}
+
+Logger::Logger()
+    : output_(defaultOutput)
+    , flush_(defaultFlush)
+{
+}
 
 // 使用单例模式创建唯一对象
 Logger& Logger::instance() {
     static Logger instance_;
     return instance_;
 }
-// 设置日志级别
-void Logger::setLogLevel(int Level) {
-    logLevel_ = Level;
+
+// [级别信息]time:
+// 时间戳使用线程缓存的日期格式，只需要memcpy再填微秒
+size_t Logger::formatPrefix(LogLevel level, char* buf) {
+    size_t n = kLevelNameLengths[level];
+    memcpy(buf, kLevelNames[level], n);
+    n += Timestamp::now().format(buf + n);
+    buf[n++] = ':';
+    return n;
+}
+
+// 前缀和消息直接格式化到栈上的缓冲区，不清零，也不构造std::string，整行一次交给output_
+void Logger::logf(LogLevel level, const char* fmt, ...) {
+    char buf[1280];
+    size_t n = formatPrefix(level, buf);
+    va_list args;
+    va_start(args, fmt);
+    int len = ::vsnprintf(buf + n, sizeof(buf) - n - 1, fmt, args); // 留一个字节给换行
+    va_end(args);
+    if(len > 0) {
+        n += std::min(static_cast<size_t>(len), sizeof(buf) - n - 2); // 截断时vsnprintf最后写的是'\0'
+    }
+    buf[n++] = '\n';
+    write(level, buf, n);
 }
+
 // 写日志 [级别信息] time : msg
-void Logger::log(std::string msg) {
-    switch (logLevel_)
-    {
-    case INFO:
-        std::cout << "[INFO]";
-        break;
-    case ERROR:
-        std::cout << "[ERROR]";
-        break;
-    case FATAL:
-        std::cout << "[FATAL]";
-        break;
-    case DEBUG:
-        std::cout << "[DEBUG]";
-        break;
-    default:
-        break;
+void Logger::log(LogLevel level, const char* msg, size_t len) {
+    char buf[1280];
+    size_t n = formatPrefix(level, buf);
+    size_t msgLen = std::min(len, sizeof(buf) - n - 1);
+    memcpy(buf + n, msg, msgLen);
+    n += msgLen;
+    buf[n++] = '\n';
+    write(level, buf, n);
+}
+
+void Logger::write(LogLevel level, const char* line, size_t len) {
+    output_(line, len);
+    if(level == FATAL) {
+        flush_(); // LOG_FATAL接下来会exit，先把日志刷出去
     }
+}
 
-    // 打印时间和msg
-    std::cout << Timestamp::now().tostring() << ":" << msg << std::endl;
-}
\ No newline at end of file
+void Logger::setOutput(OutputFunc out) {
+    output_ = std::move(out);
+}
+
+void Logger::setFlush(FlushFunc flush) {
+    flush_ = std::move(flush);
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <functional>
+#include <atomic>
+#include <stddef.h>
+#include <stdlib.h>
 
 #include "noncopyable.h"
 /* 程序调用类中方法只有两种方式，
@@ -8,57 +12,60 @@
  *②使用类名直接调用类中方法，格式“类名::方法名()”
 */
 
+// 日志级别从低到高排列，低于阈值的日志不输出
+enum LogLevel {
+    DEBUG, //调试信息 0
+    INFO, // 普通信息 1
+    ERROR, // 错误信息 2
+    FATAL, // 崩溃信息core 3
+    NUM_LOG_LEVELS,
+};
+
+// 编译期的最低级别，低于它的日志语句直接被预处理器删掉，参数也不会求值
+// 可以用-DMUDUO_MIN_LOG_LEVEL=2只保留ERROR和FATAL；定义了MUDEBUG时默认保留DEBUG，和以前一样
+// FATAL总是保留，因为它要结束进程
+#ifndef MUDUO_MIN_LOG_LEVEL
+#ifdef MUDEBUG
+#define MUDUO_MIN_LOG_LEVEL 0
+#else
+#define MUDUO_MIN_LOG_LEVEL 1
+#endif
+#endif
+
 // LOG_INFO("%s %d", arg1, arg2)
-// 这段代码是一个宏定义，它实现了在程序中方便地输出日志信息的功能。
-// 在代码中调用 LOG_INFO(format, ...) 时，执行的实际操作包括设置日志级别、格式化日志消息和将日志消息写入日志文件等步骤。
-#define LOG_INFO(logmsgFormat, ...) \
+// 先用一次relaxed的原子读比较运行时阈值，被过滤掉的日志不格式化、不取时间；
+// 级别作为参数传给logf，不再修改Logger中共享的状态，多个loop线程同时写日志没有数据竞争
+#define MUDUO_LOG_PRINTF(level, logmsgFormat, ...) \
     do { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(INFO); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        if(Logger::enabled(level)) { \
+            Logger::instance().logf(level, logmsgFormat, ##__VA_ARGS__); \
+        } \
     } while(0)
 
-#define LOG_ERROR(logmsgFormat, ...) \
-do { \
-    Logger &logger = Logger::instance(); \
-    logger.setLogLevel(ERROR); \
-    char buf[1024] = {0}; \
-    snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-    logger.log(buf); \
-} while(0)
+#if MUDUO_MIN_LOG_LEVEL <= 1
+#define LOG_INFO(logmsgFormat, ...) MUDUO_LOG_PRINTF(INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...) do {} while(0)
+#endif
+
+#if MUDUO_MIN_LOG_LEVEL <= 2
+#define LOG_ERROR(logmsgFormat, ...) MUDUO_LOG_PRINTF(ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...) do {} while(0)
+#endif
 
 #define LOG_FATAL(logmsgFormat, ...) \
     do { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(FATAL); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        Logger::instance().logf(FATAL, logmsgFormat, ##__VA_ARGS__); \
         exit(-1); \
     } while(0)
 
-#ifdef MUDEBUG // debug输出信息太多，需要时再使用
-#define LOG_DEBUG(logmsgFormat, ...) \
-    do { \
-        Logger &logger = Logger::instance(); \
-        logger.setLogLevel(DEBUG); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0)
+#if MUDUO_MIN_LOG_LEVEL <= 0 // debug输出信息太多，需要时再使用
+#define LOG_DEBUG(logmsgFormat, ...) MUDUO_LOG_PRINTF(DEBUG, logmsgFormat, ##__VA_ARGS__)
 #else
-    #define LOG_DEBUG(LogmsgFormat, ...)
+#define LOG_DEBUG(logmsgFormat, ...) do {} while(0)
 #endif
 
-enum LogLevel {
-    INFO, // 普通信息 0
-    ERROR, // 错误信息 1
-    FATAL, // 崩溃信息core 2
-    DEBUG, //调试信息 3
-};
-
 class Logger : noncopyable {
 public:
     /*static Logger& instance() 是一个静态成员函数，用于创建并返回 Logger 类型的静态对象的引用。
@@ -66,12 +73,39 @@ public:
     */
     // 使用单例模式创建唯一对象
     static Logger& instance();
-    // 设置日志级别
-    void setLogLevel(int Level);
-    // 写日志
-    void log(std::string msg);
+
+    // 运行时阈值，低于它的日志不输出，可以在任意线程中随时修改
+    // 初始值取自环境变量MUDUO_LOG_LEVEL(DEBUG/INFO/ERROR/FATAL)，没有设置时为INFO
+    static void setLogLevel(LogLevel level) { logLevel_.store(level, std::memory_order_relaxed); }
+    static LogLevel logLevel() { return static_cast<LogLevel>(logLevel_.load(std::memory_order_relaxed)); }
+    // 编译期的比较在优化时直接折叠掉
+    static bool enabled(LogLevel level) {
+        return level == FATAL || (level >= MUDUO_MIN_LOG_LEVEL && level >= logLevel());
+    }
+
+    // 格式化并写一条日志：[级别]时间:msg
+    void logf(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+    // msg已经格式化好，加上级别和时间前缀输出
+    void log(LogLevel level, const char* msg, size_t len);
+    // line是带前缀和换行的完整一行，直接交给output_，LogStream使用
+    void write(LogLevel level, const char* line, size_t len);
+
+    // 日志的输出位置，默认写到stdout，可以设置为AsyncLogging::append交给后端线程写文件
+    // 需要在其它线程开始写日志之前设置
+    // 使用AsyncLogging时同时setFlush(std::bind(&AsyncLogging::flush, &log))，否则FATAL日志会留在缓冲区中丢失
+    using OutputFunc = std::function<void(const char* msg, size_t len)>;
+    using FlushFunc = std::function<void()>;
+    void setOutput(OutputFunc out);
+    void setFlush(FlushFunc flush);
+
+    // 写[级别]时间:前缀，buf至少kPrefixSize字节，返回写入的长度
+    static size_t formatPrefix(LogLevel level, char* buf);
+    static const size_t kPrefixSize = 48;
 private:
     // 单例模式将构造函数私有化，禁止其他程序创建该类的对象，因此自己要创建一个供程序使用
-    Logger() {}
-    int logLevel_;
-};
\ No newline at end of file
+    Logger();
+
+    static std::atomic<int> logLevel_;
+    OutputFunc output_;
+    FlushFunc flush_; // FATAL日志在进程退出前调用
+};
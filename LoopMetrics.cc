@@ -0,0 +1,236 @@
+#include "LoopMetrics.h"
+#include "CurrentThread.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/prctl.h>
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+// 存活的LoopMetrics，只在EventLoop构造、析构和导出时加锁，不在loop的热路径上
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<const LoopMetrics*>& registry() {
+    static std::vector<const LoopMetrics*> metrics;
+    return metrics;
+}
+
+void appendFormat(std::string* out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+void appendFormat(std::string* out, const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = ::vsnprintf(buf, sizeof buf, fmt, args);
+    va_end(args);
+    if(n > 0) {
+        out->append(buf, std::min(static_cast<size_t>(n), sizeof buf - 1));
+    }
+}
+
+void appendHeader(std::string* out, const char* name, const char* type, const char* help) {
+    appendFormat(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// 线程名可能包含任意字符，按Prometheus的要求转义label值
+std::string labelsOf(const LoopMetrics::Snapshot& snap) {
+    std::string labels = "loop=\"" + std::to_string(snap.tid) + "\",thread=\"";
+    for(char c : snap.name) {
+        if(c == '\\' || c == '"') {
+            labels += '\\';
+            labels += c;
+        }
+        else if(c == '\n') {
+            labels += "\\n";
+        }
+        else {
+            labels += c;
+        }
+    }
+    labels += '"';
+    return labels;
+}
+
+void appendValue(std::string* out, const char* name, const std::string& labels, double value) {
+    appendFormat(out, "%s{%s} %.15g\n", name, labels.c_str(), value);
+}
+
+// scale把记录的单位换算成导出的单位，比如微秒换成秒
+void appendHistogram(std::string* out, const char* name, const std::string& labels,
+                     const LoopMetrics::Histogram::Snapshot& hist, double scale) {
+    uint64_t cumulative = 0;
+    for(int i = 0; i < LoopMetrics::Histogram::kBuckets - 1; ++i) {
+        cumulative += hist.buckets[i];
+        appendFormat(out, "%s_bucket{%s,le=\"%.15g\"} %lu\n", name, labels.c_str(),
+                     LoopMetrics::Histogram::upperBound(i) * scale, static_cast<unsigned long>(cumulative));
+    }
+    appendFormat(out, "%s_bucket{%s,le=\"+Inf\"} %lu\n", name, labels.c_str(), static_cast<unsigned long>(hist.count));
+    appendFormat(out, "%s_sum{%s} %.15g\n", name, labels.c_str(), hist.sum * scale);
+    appendFormat(out, "%s_count{%s} %lu\n", name, labels.c_str(), static_cast<unsigned long>(hist.count));
+}
+
+struct CounterDesc {
+    const char* name;
+    const char* type;
+    const char* help;
+    double (*value)(const LoopMetrics::Snapshot&);
+};
+
+const CounterDesc kCounters[] = {
+    { "mymuduo_loop_iterations_total", "counter", "Event loop iterations.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.iterations); } },
+    { "mymuduo_loop_poll_seconds_total", "counter", "Time blocked in the poller.",
+      [](const LoopMetrics::Snapshot& s) { return s.pollNanos / 1e9; } },
+    { "mymuduo_loop_event_seconds_total", "counter", "Time spent in IO event callbacks.",
+      [](const LoopMetrics::Snapshot& s) { return s.eventNanos / 1e9; } },
+    { "mymuduo_loop_functor_seconds_total", "counter", "Time spent running queued functors.",
+      [](const LoopMetrics::Snapshot& s) { return s.functorNanos / 1e9; } },
+    { "mymuduo_loop_functors_total", "counter", "Queued functors executed.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.functors); } },
+    { "mymuduo_loop_wakeups_total", "counter", "Wakeups through the loop eventfd.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.wakeups); } },
+    { "mymuduo_loop_read_bytes_total", "counter", "Bytes read from connections.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.bytesRead); } },
+    { "mymuduo_loop_written_bytes_total", "counter", "Bytes written to connections.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.bytesWritten); } },
+    { "mymuduo_loop_connections_opened_total", "counter", "Connections established on the loop.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.connectionsOpened); } },
+    { "mymuduo_loop_connections_closed_total", "counter", "Connections destroyed on the loop.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.connectionsClosed); } },
+    { "mymuduo_loop_connections", "gauge", "Connections currently on the loop.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.connections); } },
+    { "mymuduo_loop_pending_output_bytes", "gauge", "Bytes queued for sending on the loop.",
+      [](const LoopMetrics::Snapshot& s) { return static_cast<double>(s.pendingOutputBytes); } },
+};
+
+struct HistogramDesc {
+    const char* name;
+    const char* help;
+    const LoopMetrics::Histogram::Snapshot LoopMetrics::Snapshot::*member;
+    double scale;
+};
+
+const HistogramDesc kHistograms[] = {
+    { "mymuduo_loop_active_channels", "Active channels returned by each poll.",
+      &LoopMetrics::Snapshot::activeChannels, 1.0 },
+    { "mymuduo_loop_pending_functors", "Queued functors run per loop iteration.",
+      &LoopMetrics::Snapshot::pendingFunctors, 1.0 },
+    { "mymuduo_loop_poll_wait_seconds", "Time blocked in each poll.",
+      &LoopMetrics::Snapshot::pollMicros, 1e-6 },
+    { "mymuduo_loop_functor_run_seconds", "Time running queued functors per loop iteration.",
+      &LoopMetrics::Snapshot::functorMicros, 1e-6 },
+};
+
+}
+
+LoopMetrics::Histogram::Histogram()
+    : count_(0)
+    , sum_(0)
+{
+    for(int i = 0; i < kBuckets; ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LoopMetrics::Histogram::snapshot(Snapshot* snap) const {
+    for(int i = 0; i < kBuckets; ++i) {
+        snap->buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    snap->sum = sum_.load(std::memory_order_relaxed);
+    // count用各桶之和，保证导出的+Inf桶和前面的累计值一致
+    snap->count = 0;
+    for(int i = 0; i < kBuckets; ++i) {
+        snap->count += snap->buckets[i];
+    }
+}
+
+// 在loop线程中构造，线程名已经由Thread设置好
+LoopMetrics::LoopMetrics(const std::atomic<int64_t>* connections,
+                         const std::atomic<int64_t>* pendingOutputBytes)
+    : tid_(CurrentThread::tid())
+    , connections_(connections)
+    , pendingOutputBytes_(pendingOutputBytes)
+    , iterations_(0)
+    , pollNanos_(0)
+    , eventNanos_(0)
+    , functorNanos_(0)
+    , functors_(0)
+    , wakeups_(0)
+    , bytesRead_(0)
+    , bytesWritten_(0)
+    , connectionsOpened_(0)
+    , connectionsClosed_(0)
+{
+    char name[16] = { 0 };
+    ::prctl(PR_GET_NAME, name);
+    name_ = name;
+
+    std::unique_lock<std::mutex> lock(registryMutex());
+    registry().push_back(this);
+}
+
+LoopMetrics::~LoopMetrics() {
+    std::unique_lock<std::mutex> lock(registryMutex());
+    std::vector<const LoopMetrics*>& metrics = registry();
+    metrics.erase(std::remove(metrics.begin(), metrics.end(), this), metrics.end());
+}
+
+void LoopMetrics::snapshot(Snapshot* snap) const {
+    snap->name = name_;
+    snap->tid = tid_;
+    snap->iterations = iterations_.load(std::memory_order_relaxed);
+    snap->pollNanos = pollNanos_.load(std::memory_order_relaxed);
+    snap->eventNanos = eventNanos_.load(std::memory_order_relaxed);
+    snap->functorNanos = functorNanos_.load(std::memory_order_relaxed);
+    snap->functors = functors_.load(std::memory_order_relaxed);
+    snap->wakeups = wakeups_.load(std::memory_order_relaxed);
+    snap->bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    snap->bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    snap->connectionsOpened = connectionsOpened_.load(std::memory_order_relaxed);
+    snap->connectionsClosed = connectionsClosed_.load(std::memory_order_relaxed);
+    snap->connections = connections_->load(std::memory_order_relaxed);
+    snap->pendingOutputBytes = pendingOutputBytes_->load(std::memory_order_relaxed);
+    activeChannels_.snapshot(&snap->activeChannels);
+    pendingFunctors_.snapshot(&snap->pendingFunctors);
+    pollMicros_.snapshot(&snap->pollMicros);
+    functorMicros_.snapshot(&snap->functorMicros);
+}
+
+std::vector<LoopMetrics::Snapshot> LoopMetrics::snapshotAll() {
+    std::unique_lock<std::mutex> lock(registryMutex());
+    const std::vector<const LoopMetrics*>& metrics = registry();
+    std::vector<Snapshot> snaps(metrics.size());
+    for(size_t i = 0; i < metrics.size(); ++i) {
+        metrics[i]->snapshot(&snaps[i]);
+    }
+    return snaps;
+}
+
+std::string LoopMetrics::prometheusText() {
+    std::vector<Snapshot> snaps = snapshotAll();
+    std::vector<std::string> labels;
+    for(const Snapshot& snap : snaps) {
+        labels.push_back(labelsOf(snap));
+    }
+
+    std::string out;
+    out.reserve(4096 + snaps.size() * 12 * 1024);
+    for(const CounterDesc& desc : kCounters) {
+        appendHeader(&out, desc.name, desc.type, desc.help);
+        for(size_t i = 0; i < snaps.size(); ++i) {
+            appendValue(&out, desc.name, labels[i], desc.value(snaps[i]));
+        }
+    }
+    for(const HistogramDesc& desc : kHistograms) {
+        appendHeader(&out, desc.name, "histogram", desc.help);
+        for(size_t i = 0; i < snaps.size(); ++i) {
+            appendHistogram(&out, desc.name, labels[i], snaps[i].*desc.member, desc.scale);
+        }
+    }
+    return out;
+}
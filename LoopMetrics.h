@@ -0,0 +1,135 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * 每个EventLoop一份的运行时统计
+ * 所有计数只在loop线程中修改，用relaxed的load+store累加，不需要lock前缀的原子加法，也不加锁；
+ * 其它线程随时可以读取，snapshot()得到的各项之间不是严格一致的，对监控来说足够
+ * 所有存活的LoopMetrics登记在一个全局列表中，prometheusText()按需汇总成Prometheus文本格式
+*/
+class LoopMetrics : noncopyable {
+public:
+    // 以2为底的对数分桶：桶0统计0，桶1统计1，桶i(i>=2)统计(2^(i-2), 2^(i-1)]，上界就是upperBound(i)；最后一个桶统计超出范围的值
+    class Histogram : noncopyable {
+    public:
+        static const int kBuckets = 26;
+
+        Histogram();
+        // 只能在loop线程中调用
+        void observe(uint64_t value) {
+            int i = value == 0 ? 0 : (value == 1 ? 1 : 65 - __builtin_clzll(value - 1));
+            if(i >= kBuckets) {
+                i = kBuckets - 1;
+            }
+            add(&buckets_[i], 1);
+            add(&count_, 1);
+            add(&sum_, value);
+        }
+
+        // 桶i的上界，最后一个桶是+Inf
+        static uint64_t upperBound(int i) { return i == 0 ? 0 : static_cast<uint64_t>(1) << (i - 1); }
+
+        struct Snapshot {
+            uint64_t buckets[kBuckets]; // 不是累计值
+            uint64_t count;
+            uint64_t sum;
+        };
+        void snapshot(Snapshot* snap) const;
+    private:
+        std::atomic<uint64_t> buckets_[kBuckets];
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+    };
+
+    struct Snapshot {
+        std::string name; // 线程名
+        pid_t tid;
+        uint64_t iterations;
+        uint64_t pollNanos; // 阻塞在poll中的总时间
+        uint64_t eventNanos; // 处理IO事件回调的总时间
+        uint64_t functorNanos; // 执行queueInLoop回调的总时间
+        uint64_t functors;
+        uint64_t wakeups;
+        uint64_t bytesRead;
+        uint64_t bytesWritten;
+        uint64_t connectionsOpened;
+        uint64_t connectionsClosed;
+        int64_t connections;
+        int64_t pendingOutputBytes;
+        Histogram::Snapshot activeChannels; // 每次poll返回的活跃channel数
+        Histogram::Snapshot pendingFunctors; // 每轮执行的回调个数，即队列深度
+        Histogram::Snapshot pollMicros; // 每次poll阻塞的微秒数
+        Histogram::Snapshot functorMicros; // 每轮执行回调花费的微秒数
+    };
+
+    explicit LoopMetrics(const std::atomic<int64_t>* connections,
+                         const std::atomic<int64_t>* pendingOutputBytes);
+    ~LoopMetrics();
+
+    // 以下只能在loop线程中调用
+    void onPoll(uint64_t pollNanos, size_t activeChannels) {
+        add(&iterations_, 1);
+        add(&pollNanos_, pollNanos);
+        activeChannels_.observe(activeChannels);
+        pollMicros_.observe(pollNanos / 1000);
+    }
+    void onEvents(uint64_t nanos) { add(&eventNanos_, nanos); }
+    void onFunctors(size_t count, uint64_t nanos) {
+        add(&functors_, count);
+        add(&functorNanos_, nanos);
+        pendingFunctors_.observe(count);
+        functorMicros_.observe(nanos / 1000);
+    }
+    void onWakeup() { add(&wakeups_, 1); }
+    void addBytesRead(size_t n) { add(&bytesRead_, n); }
+    void addBytesWritten(size_t n) { add(&bytesWritten_, n); }
+    void onConnectionOpened() { add(&connectionsOpened_, 1); }
+    void onConnectionClosed() { add(&connectionsClosed_, 1); }
+
+    // 可以在任意线程中调用
+    void snapshot(Snapshot* snap) const;
+
+    // 所有存活的EventLoop的统计
+    static std::vector<Snapshot> snapshotAll();
+    // Prometheus文本格式(text/plain; version=0.0.4)，每个loop一组，用loop和thread两个label区分
+    static std::string prometheusText();
+
+    static uint64_t nowNanos() {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+private:
+    // 只有loop线程写，不需要原子加法
+    static void add(std::atomic<uint64_t>* counter, uint64_t n) {
+        counter->store(counter->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::string name_;
+    const pid_t tid_;
+    const std::atomic<int64_t>* connections_; // EventLoop中的负载统计，这里只读
+    const std::atomic<int64_t>* pendingOutputBytes_;
+
+    std::atomic<uint64_t> iterations_;
+    std::atomic<uint64_t> pollNanos_;
+    std::atomic<uint64_t> eventNanos_;
+    std::atomic<uint64_t> functorNanos_;
+    std::atomic<uint64_t> functors_;
+    std::atomic<uint64_t> wakeups_;
+    std::atomic<uint64_t> bytesRead_;
+    std::atomic<uint64_t> bytesWritten_;
+    std::atomic<uint64_t> connectionsOpened_;
+    std::atomic<uint64_t> connectionsClosed_;
+    Histogram activeChannels_;
+    Histogram pendingFunctors_;
+    Histogram pollMicros_;
+    Histogram functorMicros_;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <utility>
+
+/**
+ * 多生产者单消费者的无锁队列（Dmitry Vyukov的MPSC算法），节点循环使用
+ * 生产者：从空闲栈取一个节点，一次exchange加一次store，不需要加锁，也不会被其它生产者阻塞
+ * 消费者：只能在一个线程中调用consume，EventLoop里就是loop所在的线程
+ *
+ * 队列中始终有一个stub节点，tail_指向的节点的值已经被取走，tail_->next才是第一个有效元素
+ * 生产者exchange了head_但还没有链接prev->next时，消费者会暂时看不到后面的元素，
+ * 此时consume直接返回，该生产者完成链接后会负责唤醒消费者
+ *
+ * 消费者用完的节点压回空闲栈，生产者从空闲栈弹出，稳定状态下push不再new/delete，生产者和loop线程之间没有跨线程的malloc/free
+ * 空闲栈的栈顶是带版本号的指针（高16位是版本号），防止ABA；节点和TimerQueue的Timer一样只在队列析构时释放，
+ * 所以生产者读到已经被别人弹出的节点的next也是安全的，占用的内存等于队列曾经达到的最大长度
+*/
+template<typename T>
+class MpscQueue : noncopyable {
+public:
+    MpscQueue()
+        : head_(new Node)
+        , tail_(head_.load(std::memory_order_relaxed))
+        , freeNodes_(0)
+    {}
+
+    ~MpscQueue() {
+        deleteList(tail_);
+        deleteList(pointerOf(freeNodes_.load(std::memory_order_relaxed)));
+    }
+
+    // 可以在任意线程中调用
+    void push(T value) {
+        Node* node = allocNode();
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(node);
+        prev->next.store(node);
+    }
+
+    // 只能在消费者线程中调用，取出调用时已经在队列中的元素，f执行过程中新加入的元素留给下一次
+    template<typename F>
+    size_t consume(F&& f) {
+        Node* last = head_.load();
+        size_t count = 0;
+        while(tail_ != last) {
+            Node* next = tail_->next.load();
+            if(next == nullptr) {
+                break; // 有生产者还没有完成链接
+            }
+            T value(std::move(next->value));
+            next->value = T(); // 尽早释放捕获的资源，节点要等下次复用才会覆盖
+            freeNode(tail_);
+            tail_ = next; // next成为新的stub节点
+            f(value);
+            ++count;
+        }
+        return count;
+    }
+
+    // 只能在消费者线程中调用
+    bool empty() const {
+        return tail_->next.load() == nullptr;
+    }
+private:
+    struct Node {
+        Node() : next(nullptr) {}
+
+        T value;
+        std::atomic<Node*> next; // 在队列中是下一个元素，在空闲栈中是下一个空闲节点
+    };
+
+    // 用户态地址只有低48位，高16位放版本号
+    static const int kTagShift = 48;
+    static const uint64_t kPointerMask = (1ULL << kTagShift) - 1;
+
+    static Node* pointerOf(uint64_t top) { return reinterpret_cast<Node*>(top & kPointerMask); }
+    static uint64_t pack(Node* node, uint64_t top) {
+        return reinterpret_cast<uint64_t>(node) | (((top >> kTagShift) + 1) << kTagShift);
+    }
+
+    static void deleteList(Node* node) {
+        while(node != nullptr) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    // 生产者线程
+    Node* allocNode() {
+        uint64_t top = freeNodes_.load(std::memory_order_acquire);
+        while(pointerOf(top) != nullptr) {
+            Node* node = pointerOf(top);
+            Node* next = node->next.load(std::memory_order_relaxed);
+            if(freeNodes_.compare_exchange_weak(top, pack(next, top),
+                                                std::memory_order_acquire, std::memory_order_acquire)) {
+                return node;
+            }
+        }
+        return new Node;
+    }
+
+    // 消费者线程
+    void freeNode(Node* node) {
+        uint64_t top = freeNodes_.load(std::memory_order_relaxed);
+        do {
+            node->next.store(pointerOf(top), std::memory_order_relaxed);
+        } while(!freeNodes_.compare_exchange_weak(top, pack(node, top),
+                                                  std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::atomic<Node*> head_; // 生产者在这一端插入
+    Node* tail_; // 消费者在这一端取出，只有消费者线程访问
+    std::atomic<uint64_t> freeNodes_; // 空闲节点栈，带版本号的栈顶指针
+};
@@ -0,0 +1,242 @@
+#include "OutputChain.h"
+#include "BufferPool.h"
+#include "Buffer.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t OutputChain::kCopyChunkSize;
+
+const char* OutputChain::Slice::data() const {
+    switch(type) {
+    case kCopied:
+        return chunk + pos;
+    case kShared:
+        return shared->data() + pos;
+    default:
+        return owned.data() + pos;
+    }
+}
+
+size_t OutputChain::Slice::readable() const {
+    switch(type) {
+    case kCopied:
+        return size - pos;
+    case kShared:
+        return shared->size() - pos;
+    default:
+        return owned.size() - pos;
+    }
+}
+
+OutputChain::OutputChain(BufferPool* pool)
+    : pool_(pool)
+    , memoryBytes_(0)
+    , fileBytes_(0)
+{}
+
+OutputChain::~OutputChain() {
+    clear();
+}
+
+void OutputChain::clear() {
+    while(!slices_.empty()) {
+        popFront();
+    }
+    memoryBytes_ = 0;
+    fileBytes_ = 0;
+}
+
+void OutputChain::popFront() {
+    Slice& slice = slices_.front();
+    if(slice.type == kCopied) {
+        if(slice.chunkPool != nullptr) {
+            slice.chunkPool->deallocate(slice.chunk, slice.capacity);
+        }
+        else {
+            ::free(slice.chunk);
+        }
+    }
+    slices_.pop_front(); // 引用计数减一，共享数据块在最后一个连接发送完时释放
+}
+
+void OutputChain::append(const char* data, size_t len) {
+    if(len == 0) {
+        return;
+    }
+    memoryBytes_ += len;
+
+    // 链尾的拷贝片段还有剩余容量就直接追加，已经写入数据的内存块不会重新分配
+    if(!slices_.empty() && slices_.back().type == kCopied) {
+        Slice& tail = slices_.back();
+        if(tail.capacity - tail.size >= len) {
+            ::memcpy(tail.chunk + tail.size, data, len);
+            tail.size += len;
+            return;
+        }
+    }
+
+    slices_.push_back(Slice());
+    Slice& slice = slices_.back();
+    slice.type = kCopied;
+    slice.chunkPool = pool_;
+    size_t size = std::max(len, kCopyChunkSize);
+    if(pool_ != nullptr) {
+        slice.chunk = pool_->allocate(size, &slice.capacity);
+    }
+    else {
+        slice.chunk = static_cast<char*>(::malloc(size));
+        slice.capacity = size;
+    }
+    ::memcpy(slice.chunk, data, len);
+    slice.size = len;
+    slice.pos = 0;
+}
+
+void OutputChain::append(Buffer* buf) {
+    size_t len = buf->readableBytes();
+    if(len == 0) {
+        buf->retrieveAll();
+        return;
+    }
+    if(!slices_.empty() && slices_.back().type == kCopied
+       && slices_.back().capacity - slices_.back().size >= len) {
+        append(buf->peek(), len);
+        buf->retrieveAll();
+        return;
+    }
+
+    memoryBytes_ += len;
+    slices_.push_back(Slice());
+    Slice& slice = slices_.back();
+    slice.type = kCopied;
+    slice.chunkPool = buf->pool();
+    slice.chunk = buf->detachStorage(&slice.capacity, &slice.pos, &slice.size);
+}
+
+void OutputChain::append(std::string&& str, size_t offset) {
+    if(offset >= str.size()) {
+        return;
+    }
+    memoryBytes_ += str.size() - offset;
+
+    slices_.push_back(Slice());
+    Slice& slice = slices_.back();
+    slice.type = kOwned;
+    slice.owned.swap(str);
+    slice.pos = offset;
+}
+
+void OutputChain::append(const SharedBlock& block, size_t offset) {
+    if(!block || offset >= block->size()) {
+        return;
+    }
+    memoryBytes_ += block->size() - offset;
+
+    slices_.push_back(Slice());
+    Slice& slice = slices_.back();
+    slice.type = kShared;
+    slice.shared = block;
+    slice.pos = offset;
+}
+
+void OutputChain::appendFile(int fd, off_t offset, size_t length) {
+    if(length == 0) {
+        return;
+    }
+    fileBytes_ += length;
+
+    slices_.push_back(Slice());
+    Slice& slice = slices_.back();
+    slice.type = kFile;
+    slice.pos = 0;
+    slice.fd = fd;
+    slice.offset = offset;
+    slice.remaining = length;
+}
+
+ssize_t OutputChain::writeFd(int fd, int* savedErrno) {
+    ssize_t total = 0;
+    bool complete = true;
+    while(!slices_.empty() && complete) {
+        ssize_t n = slices_.front().type == kFile
+                  ? writeFile(fd, savedErrno, &complete)
+                  : writeMemory(fd, savedErrno, &complete);
+        if(n < 0) {
+            return total > 0 ? total : -1;
+        }
+        total += n;
+    }
+    return total;
+}
+
+ssize_t OutputChain::writeMemory(int fd, int* savedErrno, bool* complete) {
+    struct iovec vec[IOV_MAX];
+    int iovcnt = 0;
+    size_t requested = 0;
+    for(const Slice& slice : slices_) {
+        if(slice.type == kFile || iovcnt == IOV_MAX) {
+            break;
+        }
+        vec[iovcnt].iov_base = const_cast<char*>(slice.data());
+        vec[iovcnt].iov_len = slice.readable();
+        requested += vec[iovcnt].iov_len;
+        ++iovcnt;
+    }
+
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if(n < 0) {
+        *savedErrno = errno;
+        *complete = false;
+        return -1;
+    }
+    retrieve(n);
+    *complete = static_cast<size_t>(n) == requested;
+    return n;
+}
+
+ssize_t OutputChain::writeFile(int fd, int* savedErrno, bool* complete) {
+    Slice& slice = slices_.front();
+    ssize_t n = ::sendfile(fd, slice.fd, &slice.offset, slice.remaining); // offset由内核向后移动
+    if(n < 0) {
+        *savedErrno = errno;
+        *complete = false;
+        return -1;
+    }
+
+    if(n == 0) {
+        // 文件比指定的长度短，对端按长度解析时会一直等剩下的数据，当作EIO错误由TcpConnection关闭连接
+        LOG_ERROR("OutputChain::writeFile reached EOF, %lu bytes unsent \n", slice.remaining);
+        *savedErrno = EIO;
+        *complete = false;
+        return -1;
+    }
+
+    slice.remaining -= n;
+    fileBytes_ -= n;
+    *complete = slice.remaining == 0;
+    if(*complete) {
+        popFront();
+    }
+    return n;
+}
+
+void OutputChain::retrieve(size_t n) {
+    memoryBytes_ -= n;
+    while(n > 0) {
+        Slice& slice = slices_.front();
+        size_t readable = slice.readable();
+        if(n < readable) {
+            slice.pos += n;
+            break;
+        }
+        n -= readable;
+        popFront();
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+// 共享的不可变数据块，多个连接可以同时发送同一块数据，不需要各自拷贝一份
+using SharedBlock = std::shared_ptr<const std::string>;
+
+class Buffer;
+class BufferPool;
+
+/**
+ * TcpConnection的发送队列，由一串片段(Slice)组成：
+ *   kCopied  拷贝进来的小块数据，相邻的小数据合并到同一个内存块中，内存块来自loop的BufferPool；
+ *            append(Buffer*)接管的Buffer内存块也是这种片段，归还到Buffer原来的内存池
+ *   kOwned   移交进来的std::string，不拷贝
+ *   kShared  引用计数的共享数据块，不拷贝
+ *   kFile    文件区域，用sendfile发送
+ * 连续的内存片段用writev一次写出（每次最多IOV_MAX个），部分写出时只移动片段的读位置，
+ * 不会像连续的Buffer那样resize或者memmove整个积压的数据
+*/
+class OutputChain : noncopyable {
+public:
+    // pool为空时拷贝片段使用malloc/free
+    explicit OutputChain(BufferPool* pool = nullptr);
+    ~OutputChain();
+
+    // 拷贝[data, data + len)到链尾
+    void append(const char* data, size_t len);
+    // 接管buf的底层内存块，不拷贝，调用后buf为空；能放进链尾内存块剩余空间的小数据直接拷贝
+    void append(Buffer* buf);
+    // 接管str的内存，跳过前面offset个已经发送的字节
+    void append(std::string&& str, size_t offset = 0);
+    // 引用共享数据块，跳过前面offset个已经发送的字节
+    void append(const SharedBlock& block, size_t offset = 0);
+    // 文件fd中[offset, offset + length)的内容，fd由调用者管理
+    void appendFile(int fd, off_t offset, size_t length);
+
+    // 待发送的内存数据字节数，高水位就是按这个值计算的，文件区域不占内存，不计算在内
+    size_t readableBytes() const { return memoryBytes_; }
+    // 待发送的文件字节数
+    size_t fileBytes() const { return fileBytes_; }
+    bool empty() const { return slices_.empty(); }
+
+    /**
+     * 按顺序发送，直到链为空或者内核发送缓冲区满了（发生了部分写）
+     * 返回写出的总字节数，第一次系统调用就失败时返回-1，错误码保存在savedErrno中
+     * 文件区域还没发完就读到文件末尾时返回EIO，片段留在链头
+    */
+    ssize_t writeFd(int fd, int* savedErrno);
+
+    // 丢弃所有待发送的数据，内存块还给内存池，TcpConnection在loop线程中销毁连接时调用
+    void clear();
+private:
+    enum SliceType { kCopied, kOwned, kShared, kFile };
+
+    struct Slice {
+        SliceType type;
+        char* chunk; // kCopied的内存块
+        size_t capacity;
+        BufferPool* chunkPool; // chunk归还到这个内存池，为空时free
+        size_t size;
+        std::string owned; // kOwned的数据
+        SharedBlock shared; // kShared的数据
+        size_t pos; // 内存片段中已经发送的字节数
+        int fd; // kFile
+        off_t offset;
+        size_t remaining;
+
+        const char* data() const;
+        size_t readable() const;
+    };
+
+    // 从链头丢弃n个已经发送的内存字节
+    void retrieve(size_t n);
+    // 删除链头的片段，拷贝片段的内存块还给内存池
+    void popFront();
+    // 发送链头连续的内存片段，返回值同writeFd，complete表示这次writev是否全部写出
+    ssize_t writeMemory(int fd, int* savedErrno, bool* complete);
+    ssize_t writeFile(int fd, int* savedErrno, bool* complete);
+
+    static const size_t kCopyChunkSize = 4096; // 拷贝片段的最小容量
+
+    BufferPool* pool_;
+    std::deque<Slice> slices_;
+    size_t memoryBytes_;
+    size_t fileBytes_;
+};
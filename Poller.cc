@@ -3,6 +3,8 @@
 
 Poller::Poller(EventLoop* loop) 
     : ownerLoop_(loop)
+    , pollCalls_(0)
+    , ctlCalls_(0)
 {
 }
 
@@ -24,6 +24,10 @@ public:
     // 判断参数channel是否在当前Poller当中
     bool hasChannel(Channel* channel) const;
 
+    // 系统调用次数统计，只在loop线程中读
+    uint64_t pollCalls() const { return pollCalls_; }
+    uint64_t ctlCalls() const { return ctlCalls_; }
+
     // EventLoop可以通过该接口获取默认的IO复用的具体实现
     static Poller* newDefaultPoller(EventLoop* loop);
 private:
@@ -31,5 +35,7 @@ private:
 protected:
     // map的key: sockfd   value: sockfd所属的channel通道类型
     using ChannelMap = std::unordered_map<int, Channel*>;
+    uint64_t pollCalls_; // epoll_wait/poll的调用次数
+    uint64_t ctlCalls_; // epoll_ctl的调用次数
     ChannelMap channels_; // 负责记录 文件描述符 ---> Channel的映射，也帮忙保管所有注册在你这个Poller上的Channel,添加到epoll树，channel中有事件发生，则填写活跃连接
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+/**
+ * 指向一段不属于自己的内存的只读视图，不拷贝数据
+ * HttpRequest中的字段都直接指向接收Buffer中的数据，只在回调期间有效
+*/
+class StringPiece {
+public:
+    StringPiece()
+        : ptr_(nullptr)
+        , length_(0)
+    {}
+
+    StringPiece(const char* str)
+        : ptr_(str)
+        , length_(::strlen(str))
+    {}
+
+    StringPiece(const char* ptr, size_t len)
+        : ptr_(ptr)
+        , length_(len)
+    {}
+
+    StringPiece(const std::string& str)
+        : ptr_(str.data())
+        , length_(str.size())
+    {}
+
+    const char* data() const { return ptr_; }
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    const char* begin() const { return ptr_; }
+    const char* end() const { return ptr_ + length_; }
+    char operator[](size_t i) const { return ptr_[i]; }
+
+    std::string as_string() const { return std::string(ptr_, length_); }
+
+    bool equalsIgnoreCase(const StringPiece& rhs) const {
+        return length_ == rhs.length_ && (length_ == 0 || ::strncasecmp(ptr_, rhs.ptr_, length_) == 0);
+    }
+
+    bool operator==(const StringPiece& rhs) const {
+        return length_ == rhs.length_ && (length_ == 0 || ::memcmp(ptr_, rhs.ptr_, length_) == 0);
+    }
+
+    bool operator!=(const StringPiece& rhs) const {
+        return !(*this == rhs);
+    }
+private:
+    const char* ptr_;
+    size_t length_;
+};
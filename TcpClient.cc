@@ -0,0 +1,137 @@
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "BlockPool.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+
+// TcpClient析构以后连接可能还没有关闭，关闭时不能再回调TcpClient::removeConnection
+static void removeConnection(EventLoop* loop, const TcpConnectionPtr& conn) {
+    loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+static void defaultConnectionCallback(const TcpConnectionPtr& conn) {
+    LOG_INFO("TcpClient connection %s -> %s is %s \n",
+        conn->localAddress().toIpPort().c_str(),
+        conn->peerAddress().toIpPort().c_str(),
+        conn->connected() ? "UP" : "DOWN");
+}
+
+static void defaultMessageCallback(const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+    buf->retrieveAll();
+}
+
+TcpClient::TcpClient(EventLoop* loop,
+                     const InetAddress& serverAddr,
+                     const std::string& nameArg)
+    : loop_(loop)
+    , connector_(new Connector(loop, serverAddr))
+    , name_(nameArg)
+    , connectionCallback_(defaultConnectionCallback)
+    , messageCallback_(defaultMessageCallback)
+    , retry_(false)
+    , connect_(false)
+    , edgeTriggered_(false)
+    , nextConnId_(1)
+{
+    connector_->setNewConnectionCallback(
+        std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+    LOG_INFO("TcpClient::TcpClient[%s] - connector %p \n", name_.c_str(), connector_.get());
+}
+
+TcpClient::~TcpClient() {
+    LOG_INFO("TcpClient::~TcpClient[%s] - connector %p \n", name_.c_str(), connector_.get());
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        unique = connection_.unique();
+        conn = connection_;
+    }
+    if(conn) {
+        // 连接的closeCallback_绑定了this，换成不依赖TcpClient的版本
+        CloseCallback cb = std::bind(&::removeConnection, loop_, std::placeholders::_1);
+        loop_->runInLoop(std::bind(&TcpConnection::setCloseCallback, conn, cb));
+        if(unique) {
+            conn->forceClose(); // 用户没有持有这条连接，直接关闭
+        }
+    }
+    // Connector的回调都持有它自己的shared_ptr，stop之后正在进行的connect和重试定时器在loop中清理
+    connector_->stop();
+}
+
+void TcpClient::connect() {
+    LOG_INFO("TcpClient::connect[%s] - connecting to %s \n",
+        name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect() {
+    connect_ = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(connection_) {
+        connection_->shutdown();
+    }
+}
+
+void TcpClient::stop() {
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd) {
+    sockaddr_in peer;
+    sockaddr_in local;
+    ::bzero(&peer, sizeof(peer));
+    ::bzero(&local, sizeof(local));
+    socklen_t addrlen = sizeof(peer);
+    if(::getpeername(sockfd, (sockaddr*)&peer, &addrlen) < 0) {
+        LOG_ERROR("TcpClient::newConnection getpeername error:%d \n", errno);
+    }
+    addrlen = sizeof(local);
+    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0) {
+        LOG_ERROR("TcpClient::newConnection getsockname error:%d \n", errno);
+    }
+    InetAddress peerAddr(peer);
+    InetAddress localAddr(local);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
+    ++nextConnId_;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(PoolAllocator<TcpConnection>(loop_->blockPool()),
+                          loop_, connName, sockfd, localAddr, peerAddr));
+    conn->setConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setCloseCallback(
+        std::bind(&TcpClient::removeConnection, this, std::placeholders::_1)
+    );
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr& conn) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(connection_ == conn) {
+            connection_.reset();
+        }
+    }
+
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    if(retry_ && connect_) {
+        LOG_INFO("TcpClient::removeConnection[%s] - reconnecting to %s \n",
+            name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
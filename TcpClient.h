@@ -0,0 +1,75 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+#include "TcpConnection.h"
+#include "Connector.h"
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+class EventLoop;
+
+/**
+ * 对外的客户端编程使用的类，一个TcpClient管理一条到服务端的连接
+ * 连接和TcpServer接受的连接一样是TcpConnection，运行在用户传入的loop上，
+ * 代理、扇出类的服务可以把上游连接放在处理下游连接的同一个subLoop中，不需要跨线程
+ * Connector => 连接成功 => TcpClient::newConnection => TcpConnection
+*/
+class TcpClient : noncopyable {
+public:
+    TcpClient(EventLoop* loop,
+              const InetAddress& serverAddr,
+              const std::string& nameArg);
+    ~TcpClient(); // 必须在loop线程中析构，或者loop已经不再运行
+
+    void connect();
+    void disconnect(); // 发送队列中的数据发送完以后关闭写端
+    void stop(); // 停止正在进行的connect和重试
+
+    TcpConnectionPtr connection() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const { return loop_; }
+    const std::string& name() const { return name_; }
+
+    // 连接建立以后断开时，是否重新连接
+    bool retry() const { return retry_; }
+    void enableRetry() { retry_ = true; }
+
+    // 单次connect的超时时间和重试间隔，见Connector，需要在connect之前设置
+    void setConnectTimeout(double seconds) { connector_->setConnectTimeout(seconds); }
+    void setRetryDelay(int initMs, int maxMs) { connector_->setRetryDelay(initMs, maxMs); }
+
+    // 使用EPOLLET边缘触发，需要在connect之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    // 以下回调都不是线程安全的，需要在connect之前设置
+    void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
+    void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
+    void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+private:
+    void newConnection(int sockfd); // 在loop线程中由Connector回调
+    void removeConnection(const TcpConnectionPtr& conn); // 在loop线程中由TcpConnection回调
+
+    EventLoop* loop_;
+    ConnectorPtr connector_;
+    const std::string name_;
+
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+
+    std::atomic_bool retry_;
+    std::atomic_bool connect_;
+    bool edgeTriggered_;
+    int nextConnId_; // 只在loop线程中使用
+
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_; // 由mutex_保护
+};
@@ -4,14 +4,19 @@
 #include "Logger.h"
 #include "Buffer.h"
 #include "EventLoop.h"
+#include "LoopMetrics.h"
+#include "ConnectionRegistry.h"
 
 #include <string.h>
 #include <string>
+#include <algorithm>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <strings.h>
 #include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <errno.h>
 
 static EventLoop* CheckNotNULL(EventLoop* loop) {
     if(loop == nullptr) {
@@ -20,52 +25,149 @@ static EventLoop* CheckNotNULL(EventLoop* loop) {
     return loop;
 }
 
+// 还没有设置回调的连接共用这一份，设置时再拷贝
+static const ConnectionCallbacksPtr& emptyCallbacks() {
+    static const ConnectionCallbacksPtr callbacks(std::make_shared<ConnectionCallbacks>());
+    return callbacks;
+}
+
 TcpConnection::TcpConnection(EventLoop* loop, 
                   const std::string& nameAge,
                   int sockfd,
                   const InetAddress& localAddr, // 主机ip和端口
                   const InetAddress& peerAddr) // 客户端ip和端口
+    : TcpConnection(loop, 0, nullptr, sockfd, peerAddr)
+{
+    name_ = nameAge;
+    localAddr_ = localAddr;
+    localAddrKnown_ = true;
+}
+
+TcpConnection::TcpConnection(EventLoop* loop,
+                  ConnectionId id,
+                  const std::shared_ptr<const std::string>& namePrefix,
+                  int sockfd,
+                  const InetAddress& peerAddr)
     : loop_(CheckNotNULL(loop))
-    , name_(nameAge)
+    , id_(id)
+    , namePrefix_(namePrefix)
     , state_(kConnecting)
     , reading_(true)
-    , socket_(new Socket(sockfd))
-    , channel_(new Channel(loop, sockfd))
-    , localAddr_(localAddr)
+    , socket_(sockfd)
+    , channel_(loop, sockfd)
+    , localAddr_(sockaddr_in())
+    , localAddrKnown_(false)
     , peerAddr_(peerAddr)
+    , callbacks_(emptyCallbacks())
+    , ownsCallbacks_(false)
     , highWaterMark_(64*1024*1024) // 64M
+    , inputBuffer_(Buffer::kInitialSize, loop->bufferPool()) // 缓冲区内存从loop的内存池中按需申请
+    , outputChain_(loop->bufferPool())
+    , reportedPendingBytes_(0)
+    , backpressureHighWaterMark_(0)
+    , backpressureLowWaterMark_(0)
+    , backpressured_(false)
 {
-    // 下面给channel设置相应的回调函数，poller给channel通知感兴趣的事件发生了，channel会回调相应的操作函数
-    channel_->setReadCallback(
-        std::bind(&TcpConnection::handleRead, this, std::placeholders::_1)
-    );
-    channel_->setWriteCallback(
-        std::bind(&TcpConnection::handleWrite, this)
-    );
-    channel_->setCloseCallback(
-        std::bind(&TcpConnection::handleClose, this)
-    );
-    channel_->setErrorCallback(
-        std::bind(&TcpConnection::handleError, this)
-    );
+    // poller给channel通知感兴趣的事件发生了，channel直接调用本对象的handleRead等函数
+    channel_.setHandler(this);
     
-    LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
-    socket_->setKeepAlive(true); // 启动TcpConnect的保活机制   
+    LOG_DEBUG("TcpConnection::ctor at fd=%d\n", sockfd);
+    socket_.setKeepAlive(true); // 启动TcpConnect的保活机制   
 }
 
 TcpConnection::~TcpConnection() {
-    LOG_INFO("TcpConnection::dtor[%s] at fd = %d state = %d\n", name_.c_str(), channel_->fd(), (int)state_);
+    LOG_DEBUG("TcpConnection::dtor[%s] at fd = %d state = %d\n", name().c_str(), channel_.fd(), (int)state_);
+}
+
+ConnectionCallbacks* TcpConnection::ownCallbacks() {
+    if(!ownsCallbacks_) {
+        callbacks_ = std::make_shared<ConnectionCallbacks>(*callbacks_);
+        ownsCallbacks_ = true;
+    }
+    return callbacks_.get();
+}
+
+// 写完成回调放到本轮事件处理之后执行，用户在回调中继续send也不会递归
+void TcpConnection::queueWriteComplete() {
+    ConnectionCallbacksPtr callbacks(callbacks_);
+    TcpConnectionPtr conn(shared_from_this());
+    loop_->queueInLoop([callbacks, conn]() {
+        callbacks->writeComplete(conn);
+    });
 }
 
-// 发送数据
+std::string TcpConnection::name() const {
+    if(namePrefix_) {
+        return *namePrefix_ + std::to_string(ConnectionRegistry::sequenceOf(id_));
+    }
+    return name_;
+}
+
+InetAddress TcpConnection::localAddress() const {
+    if(localAddrKnown_) {
+        return localAddr_;
+    }
+    sockaddr_in local;
+    ::bzero(&local, sizeof(local));
+    socklen_t addrlen = sizeof(local);
+    if(::getsockname(channel_.fd(), (sockaddr*)&local, &addrlen) < 0) {
+        LOG_ERROR("TcpConnection::localAddress getsockname error:%d \n", errno);
+    }
+    return InetAddress(local);
+}
+
+// 发送数据，在其它线程中调用时拷贝一份数据交给loop线程，调用返回后buf就可以释放了
 void TcpConnection::send(const std::string& buf) {
     if(state_ == kConnected) {
         if(loop_->isInLoopThread()) {
             sendInLoop(buf.c_str(), buf.size());
         }
+        else {
+            send(std::string(buf));
+        }
+    }
+}
+
+// 接管buf的内存，跨线程时只是把string移动到回调里，没写完的部分直接挂到发送队列上
+void TcpConnection::send(std::string&& buf) {
+    if(state_ == kConnected) {
+        if(loop_->isInLoopThread()) {
+            sendStringInLoop(buf);
+        }
         else {
             loop_->runInLoop(
-                std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size())
+                std::bind(&TcpConnection::sendStringInLoop, shared_from_this(), std::move(buf))
+            );
+        }
+    }
+}
+
+// 发送buf中所有可读的数据，调用后buf为空；没写完的部分连同底层内存块一起挂到发送队列上，不拷贝
+void TcpConnection::send(Buffer* buf) {
+    if(state_ == kConnected) {
+        if(loop_->isInLoopThread()) {
+            sendBufferInLoop(buf);
+        }
+        else {
+            // 交换底层内存，不拷贝数据，buf换回一个同一内存池的空Buffer
+            std::shared_ptr<Buffer> owned(new Buffer(0, buf->pool()));
+            owned->swap(*buf);
+            loop_->runInLoop(
+                std::bind(&TcpConnection::sendOwnedBufferInLoop, shared_from_this(), owned)
+            );
+        }
+    }
+}
+
+// 共享数据块，发送队列中只保存引用
+void TcpConnection::send(const SharedBlock& block) {
+    if(state_ == kConnected) {
+        if(loop_->isInLoopThread()) {
+            sendBlockInLoop(block);
+        }
+        else {
+            loop_->runInLoop(
+                std::bind(&TcpConnection::sendBlockInLoop, shared_from_this(), block)
             );
         }
     }
@@ -75,58 +177,163 @@ void TcpConnection::send(const std::string& buf) {
  * 发送数据  应用写的快， 而内核发送数据慢， 需要把待发送数据写入缓冲区， 而且设置了水位回调
  */
 void TcpConnection::sendInLoop(const void* data, size_t len) {
-    ssize_t nwrote = 0;
-    size_t remaining = len;
-    bool faultError = false; // 是否产生错误
+    size_t nwrote = 0;
+    if(!writeDirectly(data, len, &nwrote)) {
+        return;
+    }
+    if(nwrote < len) {
+        size_t oldLen = outputChain_.readableBytes();
+        outputChain_.append(static_cast<const char*>(data) + nwrote, len - nwrote);
+        queuedOutput(oldLen);
+    }
+}
+
+void TcpConnection::sendStringInLoop(std::string& buf) {
+    size_t nwrote = 0;
+    if(!writeDirectly(buf.data(), buf.size(), &nwrote)) {
+        return;
+    }
+    if(nwrote < buf.size()) {
+        size_t oldLen = outputChain_.readableBytes();
+        outputChain_.append(std::move(buf), nwrote); // 不拷贝，跳过已经写出的部分
+        queuedOutput(oldLen);
+    }
+}
+
+void TcpConnection::sendBufferInLoop(Buffer* buf) {
+    size_t nwrote = 0;
+    if(!writeDirectly(buf->peek(), buf->readableBytes(), &nwrote)) {
+        buf->retrieveAll();
+        return;
+    }
+    buf->retrieve(nwrote);
+    if(buf->readableBytes() > 0) {
+        size_t oldLen = outputChain_.readableBytes();
+        outputChain_.append(buf); // 接管内存块，跳过已经写出的部分
+        queuedOutput(oldLen);
+    }
+}
+
+void TcpConnection::sendOwnedBufferInLoop(const std::shared_ptr<Buffer>& buf) {
+    sendBufferInLoop(buf.get());
+}
+
+void TcpConnection::sendBlockInLoop(const SharedBlock& block) {
+    size_t nwrote = 0;
+    if(!block || !writeDirectly(block->data(), block->size(), &nwrote)) {
+        return;
+    }
+    if(nwrote < block->size()) {
+        size_t oldLen = outputChain_.readableBytes();
+        outputChain_.append(block, nwrote);
+        queuedOutput(oldLen);
+    }
+}
+
+// 发送队列为空时直接write，nwrote返回写出的字节数；连接已经断开或者出错时返回false，剩下的数据也不用再发送了
+bool TcpConnection::writeDirectly(const void* data, size_t len, size_t* nwrote) {
+    *nwrote = 0;
 
     // 之前调用过该connection的shutdown，不能再进行发送了
     if(state_ == kDisconnected) {
         LOG_ERROR("disconnected, give up writing!");
-        return;
+        return false;
     }
 
     // 表示channel_第一次开始写数据，而且缓冲区没有待发送数据
-    if(channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        nwrote = ::write(channel_->fd(), data, len);
-        if(nwrote >= 0) {
-            remaining = len - nwrote;
-            if(remaining == 0 && writeCompleteCallback_) {
+    if(!outputPending()) {
+        ssize_t n = ::write(channel_.fd(), data, len);
+        if(n >= 0) {
+            *nwrote = n;
+            loop_->metrics()->addBytesWritten(n);
+            if(*nwrote == len && callbacks_->writeComplete) {
                 // 既然在这里数据全部发送完成，就不用再给channel设置epollout事件了
-                loop_->queueInLoop(
-                    std::bind(writeCompleteCallback_, shared_from_this())
-                );
+                queueWriteComplete();
             }
         }
-        else { // nwrote < 0
-            nwrote = 0;
-            if(errno != EWOULDBLOCK) { // EWOULDBLOCK表示正常错误
-                LOG_ERROR("TcpConnection::sendInLoop");
-                if(errno == EPIPE || errno == ECONNRESET) { // SIGPIPE RESET
-                    faultError = true;
-                }
-            }
+        else if(errno != EWOULDBLOCK) { // EWOULDBLOCK表示正常错误
+            // EPIPE、ECONNRESET等错误之后这个连接上再也写不出数据，剩下的数据不能再排队，关闭连接
+            LOG_ERROR("TcpConnection::sendInLoop fd=%d errno=%d \n", channel_.fd(), errno);
+            discardOutput();
+            forceClose();
+            return false;
         }
     }
+    return true;
+}
+
+// 说明当前这一次write，并没有把数据全部发送出去，剩余的数据已经保存到发送队列当中，然后给channel
+// 注册epollout事件，poller发现tcp的发送缓冲区有空间，会通知相应的sock-channel，调用handleWrite
+// 也就是调用TcpConnection::handleWrite方法，把发送队列中的数据全部发送完成
+void TcpConnection::queuedOutput(size_t oldLen) {
+    updatePendingBytes();
 
-    // 说明当前这一次write，并没有把数据全部发送出去，剩余的数据需要保存到缓冲区当中，然后给channel
-    // 注册epollout事件，poller发现tcp的发送缓冲区有空间，会通知相应的sock-channel，调用writeCallback_回调方法
-    // 也就是调用TcpConnection::handleWrite方法，把发送缓冲区中的数据全部发送完成
-    if(!faultError && remaining > 0) {
-        // 目前发送缓冲区剩余的待发送数据的长度
-        size_t oldLen = outputBuffer_.readableBytes();
-        if(oldLen + remaining >= highWaterMark_
-           && oldLen < highWaterMark_
-           && highWaterMarkCallback_) 
-        {
-            loop_->queueInLoop(
-                std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining)
+    // 目前发送队列剩余的待发送数据的长度
+    size_t newLen = outputChain_.readableBytes();
+    if(newLen >= highWaterMark_
+       && oldLen < highWaterMark_
+       && highWaterMarkCallback_) 
+    {
+        loop_->queueInLoop(
+            std::bind(highWaterMarkCallback_, shared_from_this(), newLen)
+        );
+    }
+    if (!channel_.isWriting())
+    {
+        channel_.enableWriting(); // 这里一定要注册channel的写事件，否则poller不会给channel通知epollout
+    }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length) {
+    if(state_ == kConnected) {
+        if(loop_->isInLoopThread()) {
+            sendFileInLoop(fd, offset, length);
+        }
+        else {
+            loop_->runInLoop(
+                std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), fd, offset, length)
             );
         }
-        outputBuffer_.append((char*)data + nwrote, remaining);
-        if (!channel_->isWriting())
-        {
-            channel_->enableWriting(); // 这里一定要注册channel的写事件，否则poller不会给channel通知epollout
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length) {
+    if(state_ == kDisconnected) {
+        LOG_ERROR("disconnected, give up sending file!");
+        return;
+    }
+
+    // 前面没有待发送的数据，直接sendfile，数据不经过用户态
+    if(!outputPending()) {
+        ssize_t n = ::sendfile(channel_.fd(), fd, &offset, length); // offset由内核向后移动
+        if(n == 0 && length > 0) {
+            errno = EIO; // 文件比length短，和OutputChain::writeFile一样当作错误
+            n = -1;
         }
+        if(n >= 0) {
+            loop_->metrics()->addBytesWritten(n);
+            length -= n;
+            if(length == 0) {
+                if(callbacks_->writeComplete) {
+                    queueWriteComplete();
+                }
+                return;
+            }
+        }
+        else if(errno != EWOULDBLOCK) {
+            // 除了socket的错误，fd已经关闭(EBADF)、读文件出错(EIO)、不支持sendfile(EINVAL)也会走到这里
+            LOG_ERROR("TcpConnection::sendFileInLoop fd=%d file=%d errno=%d \n", channel_.fd(), fd, errno);
+            discardOutput();
+            forceClose();
+            return;
+        }
+    }
+
+    // 剩余部分交给handleWrite，在EPOLLOUT时继续发送
+    outputChain_.appendFile(fd, offset, length);
+    updatePendingBytes();
+    if(!channel_.isWriting()) {
+        channel_.enableWriting();
     }
 }
 
@@ -141,37 +348,170 @@ void TcpConnection::shutdown() {
 }
 
 void TcpConnection::shutdownInLoop() {
-    if(!channel_->isWriting()) { // 说明outputBuffer中的数据已经全部发送完成
-        socket_->shutdownWrite(); // 关闭写端
+    if(!outputPending()) { // 说明发送队列中的数据已经全部发送完成
+        socket_.shutdownWrite(); // 关闭写端
+    }
+}
+
+void TcpConnection::setTcpNoDelay(bool on) {
+    socket_.setTcpNoDelay(on);
+}
+
+void TcpConnection::forceClose() {
+    if(state_ == kConnected || state_ == kDisconnecting) {
+        setState(kDisconnecting);
+        loop_->queueInLoop(
+            std::bind(&TcpConnection::forceCloseInLoop, shared_from_this())
+        );
+    }
+}
+
+void TcpConnection::forceCloseInLoop() {
+    if(state_ == kConnected || state_ == kDisconnecting) {
+        handleClose(); // 和对端关闭一样，通知用户并从TcpServer/TcpClient中删除
     }
 }
 
 // 连接建立
 void TcpConnection::connectEstablished() {
     setState(kConnected);
-    channel_->tie(shared_from_this());
-    channel_->enableReading(); // // 向poller注册channel的epollin事件
+    loop_->addConnections(1);
+    loop_->metrics()->onConnectionOpened();
+    // channel不需要tie：channel注册在poller中期间，TcpServer/TcpClient/连接池一直持有连接，
+    // 直到connectDestroyed把channel从poller中删除以后才放掉；会调用用户回调的handleRead和handleClose
+    // 自己先取一个shared_ptr，回调中放掉最后一个引用也不会析构，每个事件少一次weak_ptr::lock
+    if(channel_.isEdgeTriggered()) {
+        channel_.enableWriting(); // 边缘触发模式下EPOLLOUT一直注册着，不再来回修改
+    }
+    if(reading_) { // 建立之前可能已经调用过stopRead
+        channel_.enableReading(); // // 向poller注册channel的epollin事件
+    }
 
     // 新连接建立，执行回调
-    connectionCallback_(shared_from_this()); 
+    callbacks_->connection(shared_from_this()); 
 }
 
 // 连接销毁
 void TcpConnection::connectDestroyed() {
     if(state_ == kConnected) {
         setState(kDisconnected);
-        channel_->disableAll(); // 把channel的所有感兴趣的事件，从poller中del掉
-        connectionCallback_(shared_from_this());
+        channel_.disableAll(); // 把channel的所有感兴趣的事件，从poller中del掉
+        callbacks_->connection(shared_from_this());
+    }
+    channel_.remove(); // 把channel从poller中删除掉
+
+    // 在loop线程中把缓冲区内存还给内存池，TcpConnection对象可能在其它线程中析构
+    inputBuffer_.releaseStorage();
+    outputChain_.clear();
+    updatePendingBytes();
+    loop_->addConnections(-1);
+    loop_->metrics()->onConnectionClosed();
+}
+
+void TcpConnection::discardOutput() {
+    outputChain_.clear();
+    updatePendingBytes();
+    if(!channel_.isEdgeTriggered() && channel_.isWriting()) {
+        channel_.disableWriting();
+    }
+}
+
+// 把发送队列长度的变化同步到loop的负载统计，长度没变时不写原子变量
+void TcpConnection::updatePendingBytes() {
+    size_t pending = outputChain_.readableBytes() + outputChain_.fileBytes();
+    if(pending != reportedPendingBytes_) {
+        loop_->addPendingOutputBytes(static_cast<int64_t>(pending) - static_cast<int64_t>(reportedPendingBytes_));
+        reportedPendingBytes_ = pending;
+        updateBackpressure(pending);
+    }
+}
+
+// 发送队列长度变化时检查是否越过高低水位，连接销毁时队列清空，被暂停的source也会恢复
+void TcpConnection::updateBackpressure(size_t pending) {
+    if(backpressureHighWaterMark_ == 0) {
+        return;
+    }
+    if(!backpressured_ && pending >= backpressureHighWaterMark_) {
+        TcpConnectionPtr source(backpressureSource_.lock());
+        if(source) {
+            backpressured_ = true;
+            source->stopRead();
+        }
+    }
+    else if(backpressured_ && pending <= backpressureLowWaterMark_) {
+        backpressured_ = false;
+        TcpConnectionPtr source(backpressureSource_.lock());
+        if(source) {
+            source->startRead();
+        }
+    }
+}
+
+void TcpConnection::setBackpressure(const TcpConnectionPtr& source, size_t highWaterMark, size_t lowWaterMark) {
+    if(backpressured_) { // 换掉之前的source，先恢复它的读取
+        TcpConnectionPtr old(backpressureSource_.lock());
+        if(old) {
+            old->startRead();
+        }
+        backpressured_ = false;
     }
-    channel_->remove(); // 把channel从poller中删除掉
+    backpressureSource_ = source;
+    backpressureHighWaterMark_ = source ? std::max<size_t>(highWaterMark, 1) : 0;
+    backpressureLowWaterMark_ = std::min(lowWaterMark, backpressureHighWaterMark_);
+    updateBackpressure(reportedPendingBytes_);
+}
+
+void TcpConnection::startRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop() {
+    if(!reading_) {
+        reading_ = true;
+        if(state_ == kConnected || state_ == kDisconnecting) {
+            // 重新注册EPOLLIN时epoll会重新检查就绪状态，边缘触发下暂停期间到达的数据也会再通知一次
+            channel_.enableReading();
+        }
+    }
+}
+
+void TcpConnection::stopRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop() {
+    if(reading_) {
+        reading_ = false;
+        if(channel_.isReading()) {
+            channel_.disableReading();
+        }
+    }
+}
+
+void TcpConnection::setEdgeTriggered(bool on) {
+    channel_.setEdgeTriggered(on);
+}
+
+// 是否还有数据等着EPOLLOUT发送，边缘触发模式下EPOLLOUT一直注册着，只看发送队列
+bool TcpConnection::outputPending() const {
+    return !outputChain_.empty() || (!channel_.isEdgeTriggered() && channel_.isWriting());
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime) {
+    if(!reading_) {
+        return; // 同一轮poll中前面的回调刚刚暂停了读取，数据留在内核中，startRead重新注册EPOLLIN时会再通知
+    }
+    TcpConnectionPtr guard(shared_from_this()); // 整个事件处理期间保证连接不析构，也直接传给用户回调
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    ssize_t n = inputBuffer_.readFd(channel_.fd(), &savedErrno);
+    if(channel_.isEdgeTriggered()) {
+        handleReadEdgeTriggered(guard, n, savedErrno, receiveTime);
+        return;
+    }
     if(n > 0) {
+        loop_->metrics()->addBytesRead(n);
         // 已建立连接的用户，有可读事件发生了，调用用户传入的回调操作onMessage
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        callbacks_->message(guard, &inputBuffer_, receiveTime);
     }
     else if(n == 0) {
         handleClose();
@@ -183,56 +523,98 @@ void TcpConnection::handleRead(Timestamp receiveTime) {
     }
 }
 
+// 边缘触发时同一次就绪只通知一次，一直读到EAGAIN为止
+// 每读一次就交给message回调处理，对端持续发送时inputBuffer_也不会无限增长
+void TcpConnection::handleReadEdgeTriggered(const TcpConnectionPtr& guard, ssize_t n, int savedErrno, Timestamp receiveTime) {
+    while(n > 0) {
+        loop_->metrics()->addBytesRead(n);
+        callbacks_->message(guard, &inputBuffer_, receiveTime);
+        if(state_ == kDisconnected || !reading_) {
+            return; // 回调中暂停了读取，剩下的数据等startRead以后再通知
+        }
+        n = inputBuffer_.readFd(channel_.fd(), &savedErrno);
+    }
+
+    if(n == 0) {
+        handleClose();
+    }
+    else if(savedErrno != EWOULDBLOCK) {
+        errno = savedErrno;
+        LOG_ERROR("TcpConnection::handleRead");
+        handleError();
+    }
+}
+
 void TcpConnection::handleWrite() {
-    if(channel_->isWriting()) {
+    if(channel_.isWriting()) {
+        const bool edgeTriggered = channel_.isEdgeTriggered();
+        if(edgeTriggered && outputChain_.empty()) {
+            return; // EPOLLOUT一直注册着，可读事件也会带上EPOLLOUT，没有数据要发送
+        }
+
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        // 用writev/sendfile按顺序发送，直到全部发完或者内核发送缓冲区满了
+        ssize_t n = outputChain_.writeFd(channel_.fd(), &savedErrno);
         if(n > 0) {
-            outputBuffer_.retrieve(n);
-            if(outputBuffer_.readableBytes() == 0) {
-                channel_->disableWriting();
-                if(writeCompleteCallback_) {
-                    // 唤醒loop_对应的thread线程，执行回调
-                    loop_->queueInLoop(
-                        std::bind(writeCompleteCallback_, shared_from_this())
-                    );
-                }
-                if(state_ == kDisconnecting) {
-                    shutdownInLoop();
-                }
+            loop_->metrics()->addBytesWritten(n);
+        }
+        // 边缘触发要写到EAGAIN为止，否则内核可能不会再通知EPOLLOUT
+        while(edgeTriggered && n > 0 && !outputChain_.empty()) {
+            n = outputChain_.writeFd(channel_.fd(), &savedErrno);
+            if(n > 0) {
+                loop_->metrics()->addBytesWritten(n);
             }
         }
-        else {
-            LOG_ERROR("TcpConnection::handleWrite");
+        if(n < 0 && savedErrno != EWOULDBLOCK) {
+            // 出错的片段还在链头，不关闭的话LT模式下EPOLLOUT一直就绪，loop会空转
+            errno = savedErrno;
+            LOG_ERROR("TcpConnection::handleWrite fd=%d errno=%d \n", channel_.fd(), savedErrno);
+            discardOutput();
+            handleClose();
+            return;
+        }
+        updatePendingBytes();
+
+        if(outputChain_.empty()) {
+            if(!edgeTriggered) {
+                channel_.disableWriting();
+            }
+            if(callbacks_->writeComplete) {
+                // 唤醒loop_对应的thread线程，执行回调
+                queueWriteComplete();
+            }
+            if(state_ == kDisconnecting) {
+                shutdownInLoop();
+            }
         }
     }
-    else {
-        LOG_ERROR("TcpConnection fd=%d is down, no more writing \n", channel_->fd());
+    else if(state_ != kDisconnected) { // 边缘触发时，关闭连接的那次事件里也会带着EPOLLOUT
+        LOG_ERROR("TcpConnection fd=%d is down, no more writing \n", channel_.fd());
     }
 }
 
 // poller => channel::closeCallback => TcpConnection::handleClose
 void TcpConnection::handleClose() {
-    LOG_INFO("TcpConnection::handleClose fd=%d state=%d \n", channel_->fd(), (int)state_);
+    LOG_DEBUG("TcpConnection::handleClose fd=%d state=%d \n", channel_.fd(), (int)state_);
     setState(kDisconnected);
-    channel_->disableAll();
+    channel_.disableAll();
 
     // TcpConnectionPtr connPtr(shared_from_this()) 是通过 shared_from_this() 函数获取当前对象TcpConnection的shared_ptr指针对象，
     // 然后再将其转化为TcpConnectionPtr类型的智能指针。这样做的目的是为了确保对象在回调函数执行期间不会被销毁，避免出现访问已经销毁的对象的问题。
     TcpConnectionPtr connPtr(shared_from_this());
-    connectionCallback_(connPtr); // 执行连接关闭的回调
-    closeCallback_(connPtr); // 关闭连接的回调  执行的是TcpServer::removeConnection回调方法
+    callbacks_->connection(connPtr); // 执行连接关闭的回调
+    callbacks_->close(connPtr); // 关闭连接的回调  执行的是TcpServer::removeConnection回调方法
 }
 
 void TcpConnection::handleError() {
     int optval;
     socklen_t optlen = sizeof(optval);
     int err = 0;
-    if(::getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+    if(::getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
         err = errno;
     }
     else {
         err = optval;
     }
-    LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name_.c_str(), err);
+    LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name().c_str(), err);
 }
@@ -1,18 +1,20 @@
 #pragma once
 
 #include "noncopyable.h"
+#include "Channel.h"
+#include "Socket.h"
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "Buffer.h"
+#include "OutputChain.h"
 #include "Timestamp.h"
 
 #include <memory>
 #include <string>
 #include <atomic>
+#include <sys/types.h>
 
 class EventLoop;
-class Channel;
-class Socket;
 
 /**
  * TcpConnction打包成功连接客户端的通信链路
@@ -22,37 +24,82 @@ class Socket;
 
 // std::enable_shared_from_this<TcpConnection>能够返回一个shared_ptr指针，由于shared_ptr是可自动释放内存的智能指针，它会管理TcpConnection对象的生命周期，
 // 保证在TcpConnection对象不再被使用时及时释放。同时，返回的shared_ptr指针可以延长TcpConnection对象的生命周期，防止被提前释放掉。
-class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnection> {
+// Channel的事件直接交给TcpConnection处理（ChannelHandler），不经过std::function
+class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnection>, private ChannelHandler {
 public:
     TcpConnection(EventLoop* loop, 
                   const std::string& nameAge,
                   int sockfd,
                   const InetAddress& localAddr, // 主机ip和端口
                   const InetAddress& peerAddr); // 客户端ip和端口
+    // TcpServer使用：名字是namePrefix加上id中的序号，本机地址用到时再通过getsockname获取，
+    // 建立连接时不格式化字符串，也不多一次系统调用
+    TcpConnection(EventLoop* loop,
+                  ConnectionId id,
+                  const std::shared_ptr<const std::string>& namePrefix,
+                  int sockfd,
+                  const InetAddress& peerAddr);
     ~TcpConnection();
 
     EventLoop* getLoop() const { return loop_; }
-    const std::string& name() const { return name_; } // 只读函数，不能修改变量成员
-    const InetAddress& localAddress() const { return localAddr_; }
+    ConnectionId id() const { return id_; }
+    // 返回值而不是引用，TcpServer建立的连接每次调用时才拼接名字，只在日志等少数地方使用
+    std::string name() const;
+    InetAddress localAddress() const;
     const InetAddress& peerAddress() const { return peerAddr_; }
 
     bool connected() const { return state_ == kConnected; }
 
-    // 发送数据
-    void send(const std::string& buf);
+    // 发送数据，都可以在其它线程中调用
+    void send(const std::string& buf); // 跨线程时拷贝一份
+    void send(std::string&& buf); // 接管buf，不拷贝
+    void send(Buffer* buf); // 交换走buf中的数据，不拷贝，调用后buf为空
+    void send(const SharedBlock& block); // 多个连接共享同一块不可变数据
+    // 使用sendfile零拷贝发送文件fd中[offset, offset + length)的内容，和send()的数据按调用顺序发送
+    // 整个区域发送完成后才回调writeCompleteCallback_，fd由调用者管理，发送完成之前不能关闭
+    void sendFile(int fd, off_t offset, size_t length);
     // 关闭连接
     void shutdown();
+    // 不等待发送队列，直接关闭连接，可以在其它线程中调用
+    void forceClose();
+
+    // 暂停/恢复读取，都可以在其它线程中调用
+    // 暂停期间不注册EPOLLIN，对端继续发送的数据留在内核接收缓冲区中，填满以后由TCP流量控制让对端停下来
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; }
+
+    // 自动背压，在本连接的loop线程中设置：本连接发送队列的长度达到highWaterMark时暂停source的读取，
+    // 降到lowWaterMark及以下时恢复，代理转发时source是数据来源的那一端，echo类服务传入自身即可
+    // 和手动的startRead/stopRead操作的是同一个开关；source传空指针时取消
+    void setBackpressure(const TcpConnectionPtr& source, size_t highWaterMark, size_t lowWaterMark);
+
+    // 使用EPOLLET边缘触发，必须在connectEstablished之前设置
+    void setEdgeTriggered(bool on);
+    // 关闭Nagle算法，小消息立即发送
+    void setTcpNoDelay(bool on);
+
+    // 上层协议保存在连接上的状态，比如HttpServer的解析器，只在loop线程中访问
+    void setContext(const std::shared_ptr<void>& context) { context_ = context; }
+    const std::shared_ptr<void>& getContext() const { return context_; }
+
+    // 使用共享的一组回调，TcpServer为所有连接设置同一份
+    void setCallbacks(const ConnectionCallbacksPtr& callbacks) {
+        callbacks_ = callbacks;
+        ownsCallbacks_ = false;
+    }
 
+    // 单独修改某个回调时，第一次先拷贝一份本连接自己的，以后直接修改，不影响共用这组回调的其它连接
     void setConnectionCallback(const ConnectionCallback& cb) {
-        connectionCallback_ = cb;
+        ownCallbacks()->connection = cb;
     }
 
     void setMessageCallback(const MessageCallback& cb) {
-        messageCallback_ = cb;
+        ownCallbacks()->message = cb;
     }
 
     void setWriteCompleteCallback(const WriteCompleteCallback& cb) {
-        writeCompleteCallback_ = cb;
+        ownCallbacks()->writeComplete = cb;
     }
 
     void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark) {
@@ -61,7 +108,7 @@ public:
     }
 
     void setCloseCallback(const CloseCallback& cb) {
-        closeCallback_ = cb;
+        ownCallbacks()->close = cb;
     }
 
     // 连接建立
@@ -72,33 +119,63 @@ private:
     enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
     void setState(StateE state) { state_ = state; }
 
-    void handleRead(Timestamp receiveTime);
-    void handleWrite();
-    void handleClose();
-    void handleError();
+    // ChannelHandler
+    void handleRead(Timestamp receiveTime) override;
+    void handleWrite() override;
+    void handleClose() override;
+    void handleError() override;
+
+    void handleReadEdgeTriggered(const TcpConnectionPtr& guard, ssize_t n, int savedErrno, Timestamp receiveTime);
+    ConnectionCallbacks* ownCallbacks();
+    void queueWriteComplete();
 
     void sendInLoop(const void* message, size_t len);
+    void sendStringInLoop(std::string& buf);
+    void sendBufferInLoop(Buffer* buf);
+    void sendOwnedBufferInLoop(const std::shared_ptr<Buffer>& buf);
+    void sendBlockInLoop(const SharedBlock& block);
+    bool writeDirectly(const void* data, size_t len, size_t* nwrote);
+    void queuedOutput(size_t oldLen);
+    void sendFileInLoop(int fd, off_t offset, size_t length);
     void shutdownInLoop();
+    void forceCloseInLoop();
+    void startReadInLoop();
+    void stopReadInLoop();
+    void updateBackpressure(size_t pending);
+    bool outputPending() const;
+    void updatePendingBytes();
+    // write/writev/sendfile出现EAGAIN以外的错误，丢弃发送队列并停止监听EPOLLOUT
+    void discardOutput();
 
     EventLoop* loop_; // 此处不是baseLoop，因为TcpConnection都是在subLoop里面管理的
-    const std::string name_;
+    const ConnectionId id_;
+    const std::shared_ptr<const std::string> namePrefix_; // TcpServer的连接共用，其它连接为空
+    std::string name_; // 不是TcpServer建立的连接，名字在构造时给出
     std::atomic_int state_;
-    bool reading_;
+    bool reading_; // 只在loop线程中修改
 
     // 这里和Acceptor类似   Acceptor=》mainLoop    TcpConenction=》subLoop
-    std::unique_ptr<Socket> socket_;
-    std::unique_ptr<Channel> channel_;
+    // 直接内嵌，和TcpConnection、shared_ptr的控制块在同一次分配中，见BlockPool
+    Socket socket_;
+    Channel channel_;
 
-    const InetAddress localAddr_;
+    InetAddress localAddr_;
+    bool localAddrKnown_; // 构造时给出了本机地址，否则localAddress()每次调用getsockname
     const InetAddress peerAddr_;
 
-    ConnectionCallback connectionCallback_; // 有新连接时的回调
-    MessageCallback messageCallback_; // 有读写消息时的回调
-    WriteCompleteCallback writeCompleteCallback_; // 消息发送完成以后的回调
+    // 有新连接时的回调、有读写消息时的回调、消息发送完成以后的回调、关闭连接的回调
+    ConnectionCallbacksPtr callbacks_;
+    bool ownsCallbacks_; // callbacks_是本连接自己的拷贝，可以直接修改
     HighWaterMarkCallback highWaterMarkCallback_;
-    CloseCallback closeCallback_;
     size_t highWaterMark_;
 
     Buffer inputBuffer_; // 接收缓冲区
-    Buffer outputBuffer_; // 发送缓冲区
+    OutputChain outputChain_; // 发送队列，内存片段和文件区域按调用顺序排列
+    size_t reportedPendingBytes_; // 已经计入loop_->pendingOutputBytes()的发送队列长度
+
+    std::weak_ptr<TcpConnection> backpressureSource_; // 不延长对端的生命周期，两端互相设置时也不会循环引用
+    size_t backpressureHighWaterMark_;
+    size_t backpressureLowWaterMark_;
+    bool backpressured_; // 已经暂停了source的读取
+    std::shared_ptr<void> context_;
 };
\ No newline at end of file
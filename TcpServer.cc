@@ -1,9 +1,10 @@
 #include "TcpServer.h"
 #include "Logger.h"
 #include "TcpConnection.h"
+#include "BlockPool.h"
 
-#include <strings.h>
 #include <functional>
+#include <future>
 
 static EventLoop* CheckNotNULL(EventLoop* loop) {
     if(loop == nullptr) {
@@ -17,25 +18,48 @@ TcpServer::TcpServer(EventLoop* loop,
               const std::string& nameArg,
               Option option)
     : loop_(CheckNotNULL(loop))
+    , listenAddr_(listenAddr)
     , ipPort_(listenAddr.toIpPort())
     , name_(nameArg)
-    , acceptor_(new Acceptor(loop, listenAddr, option == kReusePort))
+    , connNamePrefix_(std::make_shared<const std::string>(name_ + "-" + ipPort_ + "#"))
+    , option_(option)
+    , acceptor_(new Acceptor(loop, listenAddr, option != kNoReusePort))
+    , acceptBatch_(Acceptor::kDefaultAcceptBatch)
     , threadPool_(new EventLoopThreadPool(loop, name_))
-    , connectionCallback_()
-    , messageCallback_()
-    , nextConnId_(1)
+    , edgeTriggered_(false)
+    , perLoopAccept_(false)
     , started_(0)
+    , callbacks_(std::make_shared<ConnectionCallbacks>())
 {
+    // 设置了如何关闭连接的回调   conn->shutDown()
+    callbacks_->close = std::bind(&TcpServer::removeConnection, this, std::placeholders::_1);
+
     // 当有新用户连接时，会执行TcpServer::newConnection回调
     acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this,
                 std::placeholders::_1, std::placeholders::_2));
 }
 
 TcpServer::~TcpServer() {
-    for(auto& item : connections_) {
+    // subLoop的Acceptor要在它自己的loop线程中从poller删除，等它析构完成
+    for(auto& acceptor : loopAcceptors_) {
+        std::shared_ptr<std::promise<void>> done(new std::promise<void>());
+        Acceptor* raw = acceptor.release();
+        raw->getLoop()->runInLoop([raw, done]() {
+            delete raw;
+            done->set_value();
+        });
+        done->get_future().wait();
+    }
+
+    std::vector<TcpConnectionPtr> connections;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        connections_.takeAll(&connections);
+    }
+    for(auto& item : connections) {
         // 这个局部的shared_ptr智能指针对象，出右括号，可以自动释放new出来的TcpConnection对象资源了
-        TcpConnectionPtr conn(item.second);
-        conn.reset();
+        TcpConnectionPtr conn(item);
+        item.reset(); // vector中不再持有连接，由局部的conn保证connectDestroyed执行之前连接不会析构
 
         // 销毁连接
         conn->getLoop()->runInLoop(
@@ -44,6 +68,45 @@ TcpServer::~TcpServer() {
     }
 }
 
+void TcpServer::setAcceptBatch(int batch) {
+    acceptBatch_ = batch;
+    acceptor_->setAcceptBatch(batch);
+}
+
+Acceptor::Stats TcpServer::acceptStats() const {
+    Acceptor::Stats total = acceptor_->stats();
+    for(const auto& acceptor : loopAcceptors_) {
+        if(acceptor) {
+            Acceptor::Stats stats = acceptor->stats();
+            total.wakeups += stats.wakeups;
+            total.accepted += stats.accepted;
+            total.shed += stats.shed;
+            total.fdExhausted += stats.fdExhausted;
+        }
+    }
+    return total;
+}
+
+ConnectionCallbacks* TcpServer::copyCallbacks() {
+    callbacks_ = std::make_shared<ConnectionCallbacks>(*callbacks_);
+    return callbacks_.get();
+}
+
+void TcpServer::setConnectionCallback(const ConnectionCallback &cb) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    copyCallbacks()->connection = cb;
+}
+
+void TcpServer::setMessageCallback(const MessageCallback &cb) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    copyCallbacks()->message = cb;
+}
+
+void TcpServer::setWriteCompleteCallback(const WriteCompleteCallback &cb) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    copyCallbacks()->writeComplete = cb;
+}
+
 // 设置底层subLoop的个数
 void TcpServer::setThreadNum(int numThreads) {
     threadPool_->setThreadNum(numThreads);
@@ -53,67 +116,97 @@ void TcpServer::setThreadNum(int numThreads) {
 void TcpServer::start() {
     if(started_++ == 0) { // 防止一个TcpServer对象被start多次
         threadPool_->start(threadInitCallback_); // 启动底层的loop线程池
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+
+        std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+        if(option_ == kReusePortPerLoop && loops[0] != loop_) {
+            // 每个subLoop监听自己的reuseport socket，accept之后直接在本loop建立连接，不经过mainLoop
+            // mainLoop的acceptor_只是bind，不listen，不会分到连接
+            // 先建好所有Acceptor再让它们listen，subLoop开始accept以后loopAcceptors_不再变化
+            perLoopAccept_ = true;
+            for(EventLoop* ioLoop : loops) {
+                Acceptor* acceptor = new Acceptor(ioLoop, listenAddr_, true);
+                acceptor->setAcceptBatch(acceptBatch_);
+                acceptor->setNewConnectionCallback(std::bind(&TcpServer::createConnection, this,
+                    ioLoop, std::placeholders::_1, std::placeholders::_2));
+                loopAcceptors_.push_back(std::unique_ptr<Acceptor>(acceptor));
+            }
+            for(const std::unique_ptr<Acceptor>& acceptor : loopAcceptors_) {
+                acceptor->getLoop()->runInLoop(std::bind(&Acceptor::listen, acceptor.get()));
+            }
+        }
+        else {
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
 
+TcpConnectionPtr TcpServer::findConnection(ConnectionId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return connections_.find(id);
+}
+
 // 有一个新的客户端的连接，acceptor会执行这个回调操作
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr) {
-    // 轮询算法，选择一个subLoop，来管理channel
-    EventLoop* ioLoop = threadPool_->getNextLoop();
-    char buf[64] = {0};
-    snprintf(buf, sizeof(buf), "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
-    std::string connName = name_ + buf; // 组织连接后的名称
-
-    LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
-        name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
-    
-    // 通过sockfd获取其绑定的本机的ip地址和端口信息
-    sockaddr_in local;
-    ::bzero(&local, sizeof(local));
-    // 在64位机下，size_t（32bits）和int（64 bits）的长度是不一样的,socket编程中的accept函数
-    // 的第三个参数的长度必须和int的长度相同。于是便有了socklen_t类型。
-    socklen_t addrlen = sizeof(local);
-    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0) // getsockname函数用于获取与某个套接字关联的本地协议地址
-    { // local为传出参数保存本地的ip和端口号
-        LOG_ERROR("sockets::getLocalAddr");
+    // 按负载均衡策略（默认轮询）选择一个subLoop，来管理channel
+    EventLoop* ioLoop = threadPool_->getLoopForPeer(peerAddr);
+    createConnection(ioLoop, sockfd, peerAddr);
+}
+
+// 在ioLoop上建立连接，kReusePortPerLoop时由ioLoop自己的Acceptor直接调用
+void TcpServer::createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr) {
+    ConnectionId id = 0;
+    ConnectionCallbacksPtr callbacks;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        id = connections_.allocate();
+        callbacks = callbacks_;
     }
-    InetAddress localAddr(local);
-    
+
     // 根据连接成功的sockfd，创建TcpConnection连接对象
-    TcpConnectionPtr conn(new TcpConnection(
+    // 连接的名字和本机地址都在用到时才生成，见TcpConnection::name()和localAddress()
+    // 控制块和TcpConnection一次分配，内存取自当前accept所在loop的BlockPool，连接在subLoop中析构后再还回来
+    EventLoop* acceptLoop = perLoopAccept_ ? ioLoop : loop_;
+    TcpConnectionPtr conn(std::allocate_shared<TcpConnection>(
+                          PoolAllocator<TcpConnection>(acceptLoop->blockPool()),
                           ioLoop,
-                          connName,
+                          id,
+                          connNamePrefix_,
                           sockfd, // Sockfd Channel
-                          localAddr,
                           peerAddr));
-    connections_[connName] = conn;
+    LOG_DEBUG("TcpServer::newConnection [%s] - new connection [%s] from %s \n",
+        name_.c_str(), conn->name().c_str(), peerAddr.toIpPort().c_str());
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        connections_.set(id, conn);
+    }
     // 下面的回调都是用户设置给TcpServer=>TcpConnection=>Channel=>Poller=>notify channel调用回调
-    conn->setConnectionCallback(connectionCallback_);
-    conn->setMessageCallback(messageCallback_);
-    conn->setWriteCompleteCallback(writeCompleteCallback_);
-
-    // 设置了如何关闭连接的回调   conn->shutDown()
-    conn->setCloseCallback(
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)
-    );
+    // 所有连接共用同一份，不为每个连接拷贝std::function
+    conn->setCallbacks(callbacks);
+    conn->setEdgeTriggered(edgeTriggered_);
 
     // 直接调用TcpConnection::connectionEstablished
     ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn) {
-    loop_->runInLoop(
-        std::bind(&TcpServer::removeConnectionInLoop, this, conn)
-    );
+    if(perLoopAccept_) {
+        removeConnectionInLoop(conn); // 连接在哪个loop建立就在哪个loop删除，不经过mainLoop
+    }
+    else {
+        loop_->runInLoop(
+            std::bind(&TcpServer::removeConnectionInLoop, this, conn)
+        );
+    }
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn) {
-    LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s\n", 
+    LOG_DEBUG("TcpServer::removeConnectionInLoop [%s] - connection %s\n", 
         name_.c_str(), conn->name().c_str());
     
-    connections_.erase(conn->name());
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        connections_.remove(conn->id());
+    }
     EventLoop* ioLoop = conn->getLoop();
     ioLoop->queueInLoop(
         std::bind(&TcpConnection::connectDestroyed, conn)
@@ -8,12 +8,14 @@
 #include "Callbacks.h"
 #include "TcpConnection.h"
 #include "Buffer.h"
+#include "ConnectionRegistry.h"
 
 #include <functional>
 #include <string>
 #include <memory>
 #include <atomic>
-#include <unordered_map>
+#include <vector>
+#include <mutex>
 
 
 // 对外的服务器编程使用的类
@@ -24,6 +26,7 @@ public:
     enum Option { // 是否重用端口
         kNoReusePort,
         kReusePort,
+        kReusePortPerLoop, // 每个subLoop有自己的reuseport监听socket和Acceptor，由内核把新连接分给各个loop
     };
 
     TcpServer(EventLoop* loop,
@@ -32,40 +35,81 @@ public:
               Option option = kNoReusePort);
     ~TcpServer();
 
+    EventLoop* getLoop() const { return loop_; }
+    const std::string& name() const { return name_; }
+    const std::string& ipPort() const { return ipPort_; }
+
     void setThreadInitcallback(const ThreadInitCallback &cb) { threadInitCallback_ = cb; }
-    void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
-    void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
-    void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+    // 所有连接共用一份回调；start之后再设置只影响之后建立的连接
+    void setConnectionCallback(const ConnectionCallback &cb);
+    void setMessageCallback(const MessageCallback &cb);
+    void setWriteCompleteCallback(const WriteCompleteCallback &cb);
+
+    // 新连接使用EPOLLET边缘触发，需要在start之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    // subLoop使用的IO复用实现，需要在start之前设置；baseLoop由用户自己创建
+    void setPollerType(EventLoop::PollerType type) { threadPool_->setPollerType(type); }
+
+    // 每次listenfd可读时最多accept的连接数，需要在start之前设置
+    void setAcceptBatch(int batch);
+    // 所有Acceptor的统计信息之和
+    Acceptor::Stats acceptStats() const;
+
+    // 新连接分配subLoop的策略，kReusePortPerLoop模式下由内核分配，不使用这里的策略
+    void setLoadBalance(EventLoopThreadPool::LoadBalance policy) { threadPool_->setLoadBalance(policy); }
+    void setLoopSelector(const EventLoopThreadPool::LoopSelector& selector) { threadPool_->setLoopSelector(selector); }
+
+    // subLoop线程的放置，需要在start之前设置，见EventLoopThreadPool
+    void setCpuAffinity(const std::vector<std::vector<int>>& cpuSets) { threadPool_->setCpuAffinity(cpuSets); }
+    void setNumaLocal(bool on) { threadPool_->setNumaLocal(on); }
+    std::string layoutReport() { return threadPool_->layoutReport(); }
 
     // 设置底层subLoop的个数
     void setThreadNum(int numThreads);
+    // start之后可以通过getAllLoops()拿到所有subLoop，比如为每个loop建立上游连接池
+    EventLoopThreadPool* threadPool() const { return threadPool_.get(); }
 
     // 开启服务器的监听
     void start();
+
+    // 按ID查找连接，连接已经关闭时返回空指针，可以在任意线程中调用
+    TcpConnectionPtr findConnection(ConnectionId id);
 private:
     void newConnection(int sockfd, const InetAddress& peerAddr);
+    void createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
-
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    ConnectionCallbacks* copyCallbacks();
 
     EventLoop* loop_; // baseLoop 用户定义的loop
 
+    const InetAddress listenAddr_;
     const std::string ipPort_;
     const std::string name_;
+    const std::shared_ptr<const std::string> connNamePrefix_; // name_-ipPort_#，所有连接共用
+    const Option option_;
     
     std::unique_ptr<Acceptor> acceptor_; // 运行在mainLoop中，监听新连接事件
+    // kReusePortPerLoop时每个subLoop一个Acceptor，在各自的loop中监听和accept，也要在各自的loop中析构
+    std::vector<std::unique_ptr<Acceptor>> loopAcceptors_;
+    int acceptBatch_;
 
     std::unique_ptr<EventLoopThreadPool> threadPool_; // one loop per thread
 
-    ConnectionCallback connectionCallback_; // 有新连接时的回调
-    MessageCallback messageCallback_; // 有读写消息时的回调
-    WriteCompleteCallback writeCompleteCallback_; // 消息发送完成以后的回调
     
     ThreadInitCallback threadInitCallback_; // Loop线程初始化的回调
 
+    bool edgeTriggered_; // 连接是否使用边缘触发
+    // 是否由subLoop各自accept，start中在任何Acceptor开始listen之前确定，之后只读
+    // subLoop线程中的createConnection/removeConnection读这个标志，不读start中还在修改的loopAcceptors_
+    bool perLoopAccept_;
+
     std::atomic_int started_;
 
-    int nextConnId_;
-    ConnectionMap connections_; // 保存所有连接
+    std::mutex mutex_; // kReusePortPerLoop时多个subLoop会同时创建、删除连接
+    ConnectionRegistry connections_; // 保存所有连接
+    // 有新连接时的回调、有读写消息时的回调、消息发送完成以后的回调，以及关闭连接时的removeConnection
+    // 已经建立的连接持有旧的一份，修改时拷贝一份新的
+    ConnectionCallbacksPtr callbacks_;
 };
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "Thread.h"
 #include "CurrentThread.h"
 
+#include "Logger.h"
+
 #include "semaphore.h"
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 std::atomic_int Thread::numCreated_(0);
 
@@ -11,6 +19,7 @@ Thread::Thread(ThreadFunc func, const std::string& name)
     , tid_(0)
     , func_(std::move(func)) // 右值引用
     , name_(name)
+    , numaLocal_(false)
 {
     setDefaultName();
 }
@@ -36,6 +45,7 @@ void Thread::start() { // 一个Thread对象，记录的就是一个新线程的
     thread_ = std::shared_ptr<std::thread>(new std::thread([&] () {
         // 获取线程的tid值, 并通过调用 sem_post 使主线程可以继续往下执行；
         tid_ = CurrentThread::tid();
+        applyPlacement(); // 在执行线程函数之前绑核，线程函数中分配的内存（比如EventLoop）就在本地节点上
         sem_post(&sem); // sem_post() 函数会将指定的信号量的值加 1，并唤醒因等待该信号量而被阻塞的线程。应该在调用 sem_init() 函数成功初始化信号量之后使用。在多线程编程中，
                         // 通常需要使用 sem_post() 函数来保证对共享资源的访问和修改的互斥性和同步性，从而避免竞态条件、死锁等问题。
         // 开启一个新线程， 专门执行该线程函数
@@ -51,6 +61,32 @@ void Thread::join() {
     thread_->join(); 
 }
 
+void Thread::applyPlacement() {
+    // 线程名最多15个字符，top -H、perf等工具中可以看到
+    std::string shortName = name_.substr(0, 15);
+    ::pthread_setname_np(::pthread_self(), shortName.c_str());
+
+    if(!cpus_.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int cpu : cpus_) {
+            if(cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        int err = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+        if(err != 0) {
+            LOG_ERROR("Thread %s setaffinity error:%d \n", name_.c_str(), err);
+        }
+    }
+
+    if(numaLocal_) {
+        if(::syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) < 0) {
+            LOG_ERROR("Thread %s set_mempolicy error:%d \n", name_.c_str(), errno);
+        }
+    }
+}
+
 void Thread::setDefaultName() {
     int num = ++numCreated_; // 按照创建的序号，起默认的名字
     if(name_.empty()) {
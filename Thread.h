@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <atomic>
+#include <vector>
 
 class Thread : noncopyable {
 public:
@@ -15,6 +16,12 @@ public:
     explicit Thread(ThreadFunc, const std::string& name = std::string());
     ~Thread();
 
+    // 线程放置，需要在start之前设置，在新线程执行线程函数之前生效
+    // 绑定到cpus中的CPU上，为空时不限制
+    void setCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+    // 线程中的内存从当前CPU所在的NUMA节点分配（MPOL_LOCAL），一般和setCpuAffinity一起使用
+    void setNumaLocal(bool on) { numaLocal_ = on; }
+
     // start()、join()、tid()，用于启动线程、等待线程结束和获取线程 ID
     void start();
     void join();
@@ -26,6 +33,7 @@ public:
     static int numCreated() { return numCreated_; }
 private:
     void setDefaultName();
+    void applyPlacement(); // 在新线程中调用
 
     bool started_;
     bool joined_;
@@ -33,6 +41,8 @@ private:
     pid_t tid_;
     ThreadFunc func_; // 存储线程函数
     std::string name_;
+    std::vector<int> cpus_;
+    bool numaLocal_;
 
     // 用于原子操作一个整数类型的变量。它提供了一组接口，使得对于该变量的读写操作是原子的，即不会被中断或其他线程干扰，保证了多线程编程时的正确性和可靠性。
     static std::atomic_int numCreated_; // 记录产生线程的个数
@@ -0,0 +1,20 @@
+#include "Timer.h"
+
+std::atomic<int64_t> Timer::s_numCreated_(0);
+
+void Timer::reset(TimerCallback cb, Timestamp when, double interval) {
+    callback_ = std::move(cb);
+    expiration_ = when;
+    interval_ = interval;
+    repeat_ = interval > 0.0;
+    sequence_.store(++s_numCreated_, std::memory_order_release);
+}
+
+void Timer::restart(Timestamp now) {
+    if(repeat_) {
+        expiration_ = addTime(now, interval_);
+    }
+    else {
+        expiration_ = Timestamp();
+    }
+}
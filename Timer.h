@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+
+#include <atomic>
+
+/**
+ * 定时器对象，保存到期时间、回调以及重复间隔
+ * prev_/next_是时间轮槽位链表的侵入式指针，插入和删除都是O(1)，不需要额外分配链表节点
+*/
+class Timer : noncopyable {
+public:
+    Timer()
+        : interval_(0.0)
+        , repeat_(false)
+        , sequence_(0)
+        , pprev_(nullptr)
+        , next_(nullptr)
+        , slot_(-1)
+    {}
+
+    // 对象池中的Timer被复用时重新初始化，每次复用都会分配新的序号
+    // when是CLOCK_MONOTONIC时间，由TimerQueue从调用者传入的系统时间换算得到
+    void reset(TimerCallback cb, Timestamp when, double interval);
+
+    void run() const { callback_(); }
+
+    Timestamp expiration() const { return expiration_; }
+    bool repeat() const { return repeat_; }
+    // 调用者线程复用Timer时会写序号，loop线程同时可能用过期的TimerId来比较，所以序号是原子变量
+    int64_t sequence() const { return sequence_.load(std::memory_order_acquire); }
+
+    // 重复定时器到期后，以now为起点计算下一次到期时间
+    void restart(Timestamp now);
+
+    static int64_t numCreated() { return s_numCreated_; }
+private:
+    friend class TimerQueue;
+
+    TimerCallback callback_;
+    Timestamp expiration_; // CLOCK_MONOTONIC时间
+    double interval_;
+    bool repeat_;
+    std::atomic<int64_t> sequence_;
+
+    Timer** pprev_; // 指向前一个节点的next_（或槽位头指针），删除时不需要知道前驱节点
+    Timer* next_;
+    int slot_; // 所在的时间轮槽位，-1表示不在时间轮中
+
+    static std::atomic<int64_t> s_numCreated_;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+class Timer;
+
+/**
+ * 定时器的句柄，用户通过它取消定时器
+ * Timer对象由TimerQueue的对象池管理，内存不会归还给系统，所以即使定时器已经到期被回收，
+ * 通过sequence_比对也能安全地判断该句柄是否仍然有效
+*/
+class TimerId {
+public:
+    TimerId()
+        : timer_(nullptr)
+        , sequence_(0)
+    {}
+
+    TimerId(Timer* timer, int64_t seq)
+        : timer_(timer)
+        , sequence_(seq)
+    {}
+
+    friend class TimerQueue;
+private:
+    Timer* timer_;
+    int64_t sequence_;
+};
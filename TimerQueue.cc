@@ -0,0 +1,288 @@
+#include "TimerQueue.h"
+#include "Timer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+// 创建timerfd，使用CLOCK_MONOTONIC，不受系统时间调整的影响
+static int createTimerfd() {
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(timerfd < 0) {
+        LOG_FATAL("timerfd_create error:%d \n", errno);
+    }
+    return timerfd;
+}
+
+// CLOCK_MONOTONIC的当前时间，时间轮的tick和timerfd都以它为基准，修改系统时间不会让定时器提前或推迟触发
+static Timestamp monotonicNow() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+}
+
+// 到期时间向上取整到tick，保证定时器不会提前触发
+static int64_t tickOf(Timestamp when, int64_t tickMicroSeconds) {
+    return (when.microSecondsSinceEpoch() + tickMicroSeconds - 1) / tickMicroSeconds;
+}
+
+TimerQueue::TimerQueue(EventLoop* loop)
+    : loop_(loop)
+    , timerfd_(createTimerfd())
+    , timerfdChannel_(loop, timerfd_)
+    , wheel_(kNumSlots, nullptr)
+    , currentTick_(monotonicNow().microSecondsSinceEpoch() / kTickMicroSeconds)
+    , armedTick_(-1)
+    , numTimers_(0)
+    , runningTimer_(nullptr)
+    , runningTimerCanceled_(false)
+    , freeList_(nullptr)
+{
+    ::memset(rootBitmap_, 0, sizeof(rootBitmap_));
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    // 和wakeupChannel_一样，每个loop都监听timerfd的EPOLLIN读事件
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue() {
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+    // Timer对象都在chunks_中，随chunks_一起释放
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, Timestamp when, double interval) {
+    // 调用者给的是系统时间，换算成距现在多久之后的CLOCK_MONOTONIC时间
+    int64_t delay = when.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
+    Timestamp expiration(monotonicNow().microSecondsSinceEpoch() + delay);
+
+    Timer* timer = allocTimer();
+    timer->reset(std::move(cb), expiration, interval);
+    TimerId timerId(timer, timer->sequence());
+    loop_->runInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
+    return timerId;
+}
+
+void TimerQueue::cancel(TimerId timerId) {
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+void TimerQueue::addTimerInLoop(Timer* timer) {
+    link(timer);
+
+    // 只有新定时器比timerfd当前的到期时间更早时，才需要调用timerfd_settime
+    int64_t tick = std::max(tickOf(timer->expiration(), kTickMicroSeconds), currentTick_);
+    if(armedTick_ < 0 || tick < armedTick_) {
+        resetTimerfd(tick);
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId) {
+    Timer* timer = timerId.timer_;
+    if(timer == nullptr || timer->sequence() != timerId.sequence_) {
+        return; // 定时器已经被回收并复用了
+    }
+
+    if(timer->slot_ >= 0) {
+        unlink(timer);
+        freeTimer(timer);
+    }
+    else if(timer == runningTimer_) {
+        // 重复定时器在自己的回调中取消自己，回调结束后不再重新插入
+        runningTimerCanceled_ = true;
+    }
+    // 取消时不重新设置timerfd，到期后发现没有定时器需要处理，再设置下一次的到期时间即可
+}
+
+void TimerQueue::handleRead() {
+    uint64_t howmany = 0;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    if(n != sizeof howmany) {
+        LOG_ERROR("TimerQueue::handleRead() reads %ld bytes instead of 8 \n", n);
+    }
+
+    Timestamp now(monotonicNow());
+    armedTick_ = -1;
+    expireUntil(now.microSecondsSinceEpoch() / kTickMicroSeconds, now);
+
+    if(numTimers_ > 0) {
+        resetTimerfd(nextRootTick());
+    }
+}
+
+// 把定时器挂到对应的槽位上，和Linux内核internal_add_timer的算法一致
+void TimerQueue::link(Timer* timer) {
+    int64_t expires = std::max(tickOf(timer->expiration(), kTickMicroSeconds), currentTick_);
+    int64_t delta = expires - currentTick_;
+    int slot = 0;
+
+    if(delta < kRootSize) {
+        slot = static_cast<int>(expires & (kRootSize - 1));
+    }
+    else {
+        const int64_t kMaxDelta = (1LL << (kRootBits + kNumLevels * kLevelBits)) - 1;
+        if(delta > kMaxDelta) { // 超出时间轮范围的定时器先放在最高层，级联时会重新计算
+            expires = currentTick_ + kMaxDelta;
+            delta = kMaxDelta;
+        }
+        for(int level = 1; level <= kNumLevels; ++level) {
+            if(delta < (1LL << (kRootBits + level * kLevelBits))) {
+                int shift = kRootBits + (level - 1) * kLevelBits;
+                slot = kRootSize + (level - 1) * kLevelSize
+                     + static_cast<int>((expires >> shift) & (kLevelSize - 1));
+                break;
+            }
+        }
+    }
+
+    Timer*& head = wheel_[slot];
+    timer->next_ = head;
+    if(head != nullptr) {
+        head->pprev_ = &timer->next_;
+    }
+    head = timer;
+    timer->pprev_ = &head;
+    timer->slot_ = slot;
+
+    if(slot < kRootSize) {
+        rootBitmap_[slot / 64] |= (1ULL << (slot % 64));
+    }
+    ++numTimers_;
+}
+
+void TimerQueue::unlink(Timer* timer) {
+    *timer->pprev_ = timer->next_;
+    if(timer->next_ != nullptr) {
+        timer->next_->pprev_ = timer->pprev_;
+    }
+
+    int slot = timer->slot_;
+    if(slot < kRootSize && wheel_[slot] == nullptr) {
+        rootBitmap_[slot / 64] &= ~(1ULL << (slot % 64));
+    }
+
+    timer->pprev_ = nullptr;
+    timer->next_ = nullptr;
+    timer->slot_ = -1;
+    --numTimers_;
+}
+
+// 把高层的一个槽位中的所有定时器重新插入时间轮，它们会落到更低的层
+int TimerQueue::cascade(int level, int index) {
+    Timer* list = wheel_[kRootSize + (level - 1) * kLevelSize + index];
+    while(list != nullptr) {
+        Timer* timer = list;
+        list = timer->next_;
+        unlink(timer);
+        link(timer);
+    }
+    return index;
+}
+
+// 处理[currentTick_, tick]之间所有到期的定时器
+void TimerQueue::expireUntil(int64_t tick, Timestamp now) {
+    while(currentTick_ <= tick) {
+        int index = static_cast<int>(currentTick_ & (kRootSize - 1));
+        if(index == 0) { // 第0层转完一圈，从上一层级联下来一个槽位
+            for(int level = 1; level <= kNumLevels; ++level) {
+                int shift = kRootBits + (level - 1) * kLevelBits;
+                if(cascade(level, static_cast<int>((currentTick_ >> shift) & (kLevelSize - 1))) != 0) {
+                    break;
+                }
+            }
+        }
+
+        if(wheel_[index] == nullptr) {
+            // 空槽位直接跳到下一个非空槽位或者第0层的下一圈
+            currentTick_ = std::min(nextRootTick(), tick + 1);
+            continue;
+        }
+
+        // 把整个槽位摘下来再执行回调，回调中添加的定时器会落到后面的tick上
+        Timer* expired = wheel_[index];
+        wheel_[index] = nullptr;
+        expired->pprev_ = &expired;
+        rootBitmap_[index / 64] &= ~(1ULL << (index % 64));
+        ++currentTick_;
+
+        while(expired != nullptr) {
+            Timer* timer = expired;
+            unlink(timer);
+
+            runningTimer_ = timer;
+            runningTimerCanceled_ = false;
+            timer->run();
+            runningTimer_ = nullptr;
+
+            if(timer->repeat() && !runningTimerCanceled_) {
+                timer->restart(now);
+                link(timer);
+            }
+            else {
+                freeTimer(timer);
+            }
+        }
+    }
+}
+
+// 下一个需要处理的tick：第0层本圈内第一个非空槽位，没有的话就是第0层下一圈开始（需要级联）
+int64_t TimerQueue::nextRootTick() const {
+    int index = static_cast<int>(currentTick_ & (kRootSize - 1));
+    for(int word = index / 64; word < kRootSize / 64; ++word) {
+        uint64_t bits = rootBitmap_[word];
+        if(word == index / 64) {
+            bits &= ~0ULL << (index % 64);
+        }
+        if(bits != 0) {
+            int slot = word * 64 + __builtin_ctzll(bits);
+            return currentTick_ + (slot - index);
+        }
+    }
+    return currentTick_ + (kRootSize - index);
+}
+
+void TimerQueue::resetTimerfd(int64_t tick) {
+    int64_t microSeconds = tick * kTickMicroSeconds - monotonicNow().microSecondsSinceEpoch();
+    if(microSeconds < 100) {
+        microSeconds = 100;
+    }
+
+    struct itimerspec newValue;
+    ::memset(&newValue, 0, sizeof newValue);
+    newValue.it_value.tv_sec = static_cast<time_t>(microSeconds / Timestamp::kMicroSecondsPerSecond);
+    newValue.it_value.tv_nsec = static_cast<long>((microSeconds % Timestamp::kMicroSecondsPerSecond) * 1000);
+    if(::timerfd_settime(timerfd_, 0, &newValue, nullptr) < 0) {
+        LOG_ERROR("timerfd_settime error:%d \n", errno);
+    }
+    armedTick_ = tick;
+}
+
+Timer* TimerQueue::allocTimer() {
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    if(freeList_ == nullptr) {
+        // 一次分配一整块，串到空闲链表上
+        Timer* chunk = new Timer[kTimersPerChunk];
+        chunks_.push_back(std::unique_ptr<Timer[]>(chunk));
+        for(int i = 0; i < kTimersPerChunk; ++i) {
+            chunk[i].next_ = freeList_;
+            freeList_ = &chunk[i];
+        }
+    }
+    Timer* timer = freeList_;
+    freeList_ = timer->next_;
+    timer->next_ = nullptr;
+    return timer;
+}
+
+void TimerQueue::freeTimer(Timer* timer) {
+    timer->callback_ = nullptr; // 尽早释放回调中捕获的资源，比如TcpConnectionPtr
+
+    std::unique_lock<std::mutex> lock(poolMutex_);
+    timer->next_ = freeList_;
+    freeList_ = timer;
+}
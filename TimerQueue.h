@@ -0,0 +1,82 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+#include "TimerId.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+class EventLoop;
+class Timer;
+
+/**
+ * 每个EventLoop一个定时器队列，timerfd作为一个Channel注册到Poller上，和wakeupChannel_一样
+ * 内部使用分层时间轮（和早期Linux内核的定时器实现相同）：
+ *   第0层256个槽，每个槽一个tick(1ms)
+ *   第1~4层每层64个槽，每个槽覆盖上一层的一整圈
+ * 插入和取消都是O(1)，每次连接收到消息时取消旧定时器再添加新定时器几乎没有开销
+ * timerfd只在最早的到期时间提前时才重新设置，避免每次添加定时器都产生系统调用
+ * tick和timerfd都基于CLOCK_MONOTONIC，addTimer把调用者给的系统时间换算成相对现在的延迟，修改系统时间不影响已经添加的定时器
+*/
+class TimerQueue : noncopyable {
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    // 可以在其它线程中调用，实际的插入操作在loop线程中执行
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+    void cancel(TimerId timerId);
+
+    // 当前在时间轮中的定时器个数，只能在loop线程中调用
+    size_t size() const { return numTimers_; }
+private:
+    static const int64_t kTickMicroSeconds = 1000;
+    static const int kRootBits = 8;
+    static const int kRootSize = 1 << kRootBits;
+    static const int kLevelBits = 6;
+    static const int kLevelSize = 1 << kLevelBits;
+    static const int kNumLevels = 4;
+    static const int kNumSlots = kRootSize + kNumLevels * kLevelSize;
+    static const int kTimersPerChunk = 1024;
+
+    void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
+    // timerfd可读，处理所有到期的定时器
+    void handleRead();
+
+    // 时间轮的基本操作
+    void link(Timer* timer);
+    void unlink(Timer* timer);
+    int cascade(int level, int index);
+    void expireUntil(int64_t tick, Timestamp now);
+    int64_t nextRootTick() const;
+
+    // 设置timerfd在tick时刻到期
+    void resetTimerfd(int64_t tick);
+
+    // Timer对象池，内存只在TimerQueue析构时释放
+    Timer* allocTimer();
+    void freeTimer(Timer* timer);
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    std::vector<Timer*> wheel_; // 所有槽位的链表头，前kRootSize个是第0层
+    uint64_t rootBitmap_[kRootSize / 64]; // 第0层非空槽位的位图，用来快速找到下一个到期的tick
+    int64_t currentTick_; // 下一个待处理的tick，之前的tick都已经处理完成
+    int64_t armedTick_; // timerfd当前设置的到期tick，-1表示没有设置
+    size_t numTimers_;
+
+    Timer* runningTimer_; // 正在执行回调的定时器
+    bool runningTimerCanceled_; // 回调中取消了自己
+
+    std::mutex poolMutex_; // addTimer可能在其它线程中调用，需要保护对象池
+    std::vector<std::unique_ptr<Timer[]>> chunks_;
+    Timer* freeList_;
+};
@@ -1,29 +1,68 @@
 #include "Timestamp.h"
 
 #include "time.h"
+#include <string.h>
+
+// 每个线程缓存上一次格式化的秒，同一秒内的日志只需要memcpy
+__thread time_t t_lastSecond = -1;
+__thread char t_timeCache[Timestamp::kFormattedSize];
+__thread int t_timeCacheLength = 0;
 
 Timestamp::Timestamp() : microSecondsSinceEpoch_(0) {}
 Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
     : microSecondsSinceEpoch_(microSecondsSinceEpoch)
     {}
 Timestamp Timestamp::now() {
-    return Timestamp(time(NULL)); // 返回值是从1900年1月1日至今所经历的时间（以秒为单位）
+    // clock_gettime走vDSO，不会陷入内核
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+}
+Timestamp Timestamp::nowCoarse() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
 }
 std::string Timestamp::tostring() const {
-    char buf[128] = {0};
-    tm* tm_time = localtime(&microSecondsSinceEpoch_);
-    snprintf(buf, sizeof(buf), "%4d-%02d-%02d %02d:%02d:%02d",
-            tm_time->tm_year + 1900,
-            tm_time->tm_mon + 1,
-            tm_time->tm_mday,
-            tm_time->tm_hour,
-            tm_time->tm_min,
-            tm_time->tm_sec);
-    return buf;
+    return toFormattedString(false);
+}
+std::string Timestamp::toFormattedString(bool showMicroseconds) const {
+    char buf[kFormattedSize];
+    int len = format(buf, showMicroseconds);
+    return std::string(buf, len);
+}
+int Timestamp::format(char* buf, bool showMicroseconds) const {
+    time_t seconds = secondsSinceEpoch();
+    if(seconds != t_lastSecond) {
+        struct tm tm_time;
+        localtime_r(&seconds, &tm_time); // localtime返回静态变量，线程不安全
+        t_timeCacheLength = snprintf(t_timeCache, sizeof(t_timeCache), "%4d-%02d-%02d %02d:%02d:%02d",
+            tm_time.tm_year + 1900,
+            tm_time.tm_mon + 1,
+            tm_time.tm_mday,
+            tm_time.tm_hour,
+            tm_time.tm_min,
+            tm_time.tm_sec);
+        t_lastSecond = seconds;
+    }
+
+    memcpy(buf, t_timeCache, t_timeCacheLength);
+    int len = t_timeCacheLength;
+    if(showMicroseconds) {
+        int microseconds = static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
+        buf[len++] = '.';
+        for(int i = 5; i >= 0; --i) {
+            buf[len + i] = static_cast<char>('0' + microseconds % 10);
+            microseconds /= 10;
+        }
+        len += 6;
+    }
+    buf[len] = '\0';
+    return len;
 }
 
 // #include <iostream>
 // int main() {
 //     std::cout << Timestamp::now().tostring() << std::endl;
 //     return 0;
-// }
\ No newline at end of file
+// }
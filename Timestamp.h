@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <string>
+#include <stdint.h>
+#include <time.h>
 
 class Timestamp {
 public:
@@ -11,8 +13,46 @@ public:
     *意思是隐藏的,类构造函数默认情况下即声明为implicit(隐式).
     */
     explicit Timestamp(int64_t microSecondsSinceEpoch);
+    // clock_gettime(CLOCK_REALTIME)，微秒精度
     static Timestamp now();
+    // CLOCK_REALTIME_COARSE，精度只有一个时钟节拍(1~4ms)，但比now()便宜，适合热路径上不需要高精度的地方
+    static Timestamp nowCoarse();
+
     std::string tostring() const; // 被声明为 const，表示函数不会修改类成员变量
+    // 2023-06-07 10:10:10.123456
+    std::string toFormattedString(bool showMicroseconds = true) const;
+    // 格式化到调用者提供的缓冲区，buf至少kFormattedSize字节，返回写入的长度，不包含'\0'
+    // 同一线程同一秒内的日期和时间部分只格式化一次，之后只是memcpy再填几位微秒
+    int format(char* buf, bool showMicroseconds = true) const;
+
+    int64_t microSecondsSinceEpoch() const { return microSecondsSinceEpoch_; }
+    time_t secondsSinceEpoch() const {
+        return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
+    }
+    bool valid() const { return microSecondsSinceEpoch_ > 0; }
+
+    static const int kMicroSecondsPerSecond = 1000 * 1000;
+    static const int kFormattedSize = 32;
 private:
     int64_t microSecondsSinceEpoch_;
-};
\ No newline at end of file
+};
+
+inline bool operator<(Timestamp lhs, Timestamp rhs) {
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(Timestamp lhs, Timestamp rhs) {
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+// 两个时间点之间相差的秒数，high - low
+inline double timeDifference(Timestamp high, Timestamp low) {
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+// timestamp加上seconds秒之后的时间点
+inline Timestamp addTime(Timestamp timestamp, double seconds) {
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
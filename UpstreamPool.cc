@@ -0,0 +1,67 @@
+#include "UpstreamPool.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <future>
+
+UpstreamPool::UpstreamPool(const std::vector<EventLoop*>& loops,
+                           const InetAddress& serverAddr,
+                           const std::string& nameArg,
+                           const ConnectionPool::Options& options)
+    : name_(nameArg)
+{
+    for(size_t i = 0; i < loops.size(); ++i) {
+        EventLoop* loop = loops[i];
+        if(pools_.count(loop)) {
+            continue;
+        }
+        std::string poolName = name_ + "-" + std::to_string(i);
+        pools_[loop].reset(new ConnectionPool(loop, serverAddr, poolName, options));
+    }
+}
+
+UpstreamPool::~UpstreamPool() {
+    for(auto& item : pools_) {
+        std::shared_ptr<std::promise<void>> done(new std::promise<void>());
+        ConnectionPool* raw = item.second.release();
+        item.first->runInLoop([raw, done]() {
+            delete raw;
+            done->set_value();
+        });
+        done->get_future().wait();
+    }
+}
+
+void UpstreamPool::setConnectionCallback(const ConnectionCallback& cb) {
+    for(auto& item : pools_) {
+        item.second->setConnectionCallback(cb);
+    }
+}
+
+void UpstreamPool::setHealthCheck(const ConnectionPool::HealthCheckCallback& cb) {
+    for(auto& item : pools_) {
+        item.second->setHealthCheck(cb);
+    }
+}
+
+ConnectionPool* UpstreamPool::getPool(EventLoop* loop) const {
+    auto it = pools_.find(loop);
+    return it == pools_.end() ? nullptr : it->second.get();
+}
+
+void UpstreamPool::acquire(EventLoop* loop, const ConnectionPool::AcquireCallback& cb) {
+    ConnectionPool* pool = getPool(loop);
+    if(pool == nullptr) {
+        LOG_ERROR("UpstreamPool[%s] - loop %p has no connection pool \n", name_.c_str(), loop);
+        cb(TcpConnectionPtr());
+        return;
+    }
+    pool->acquire(cb);
+}
+
+void UpstreamPool::release(const TcpConnectionPtr& conn) {
+    ConnectionPool* pool = getPool(conn->getLoop());
+    if(pool != nullptr) {
+        pool->release(conn);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "ConnectionPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class EventLoop;
+
+/**
+ * 到同一个上游地址的一组连接池，每个loop一个ConnectionPool
+ * 处理下游请求的subLoop从自己的连接池中借连接，请求和上游连接始终在同一个线程中
+ * 例如 UpstreamPool upstream(server.threadPool()->getAllLoops(), backendAddr, "backend");
+ *      upstream.acquire(conn->getLoop(), cb);
+*/
+class UpstreamPool : noncopyable {
+public:
+    UpstreamPool(const std::vector<EventLoop*>& loops,
+                 const InetAddress& serverAddr,
+                 const std::string& nameArg,
+                 const ConnectionPool::Options& options = ConnectionPool::Options());
+    ~UpstreamPool(); // 各个ConnectionPool在自己的loop线程中析构，这些loop必须还在运行
+
+    // 需要在使用之前设置，设置到所有loop的连接池上
+    void setConnectionCallback(const ConnectionCallback& cb);
+    void setHealthCheck(const ConnectionPool::HealthCheckCallback& cb);
+
+    // loop不属于这个UpstreamPool时返回nullptr
+    ConnectionPool* getPool(EventLoop* loop) const;
+
+    // 从loop的连接池中借连接，只能在loop线程中调用
+    void acquire(EventLoop* loop, const ConnectionPool::AcquireCallback& cb);
+    void release(const TcpConnectionPtr& conn);
+private:
+    const std::string name_;
+    std::unordered_map<EventLoop*, std::unique_ptr<ConnectionPool>> pools_; // 构造以后不再修改，可以在多个线程中读
+};
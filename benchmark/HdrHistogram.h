@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+/**
+ * HDR风格的延迟直方图，对数-线性分桶：值在[2^k, 2^(k+1))之间时等分成64个桶，
+ * 相对误差不超过1/64，记录是O(1)的数组下标运算，不分配内存，单位由调用者决定（这里都用纳秒）
+ * 每个线程各自记录，最后merge到一起再计算分位数
+*/
+class HdrHistogram {
+public:
+    static const int kSubBucketBits = 6;
+    static const int64_t kSubBucketCount = 1 << kSubBucketBits; // 64
+    static const int kMaxShift = 40; // 最大可以记录2^46左右，纳秒时约19小时
+
+    HdrHistogram()
+        : counts_((kMaxShift + 2) * kSubBucketCount, 0)
+        , total_(0)
+        , min_(INT64_MAX)
+        , max_(0)
+        , sum_(0)
+    {}
+
+    void record(int64_t value) {
+        recordCount(value, 1);
+    }
+
+    // 闭环测量时补偿协调遗漏(coordinated omission)：一次耗时value的请求挡住了本应按expectedInterval发出的请求，
+    // 按HdrHistogram的recordCorrectedValue补上这些请求本应测到的延迟
+    void recordCorrected(int64_t value, int64_t expectedInterval) {
+        record(value);
+        if(expectedInterval <= 0) {
+            return;
+        }
+        for(int64_t missing = value - expectedInterval; missing >= expectedInterval; missing -= expectedInterval) {
+            record(missing);
+        }
+    }
+
+    void merge(const HdrHistogram& other) {
+        for(size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    void reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_ = 0;
+        min_ = INT64_MAX;
+        max_ = 0;
+        sum_ = 0;
+    }
+
+    int64_t count() const { return total_; }
+    int64_t min() const { return total_ ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+
+    // percentile取0~100，返回所在桶的上界，不会低估
+    int64_t percentile(double percentile) const {
+        if(total_ == 0) {
+            return 0;
+        }
+        int64_t target = static_cast<int64_t>(percentile / 100.0 * total_ + 0.5);
+        target = std::max<int64_t>(1, std::min(target, total_));
+        int64_t seen = 0;
+        for(size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if(seen >= target) {
+                return std::min(highestEquivalent(static_cast<int>(i)), max_);
+            }
+        }
+        return max_;
+    }
+
+    // 打印一行：label p50 p90 p99 p99.9 p99.99 max，值除以unit后显示
+    void print(const char* label, double unit, const char* unitName) const {
+        printf("%-28s n=%-9ld p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  p99.99 %8.1f  max %8.1f %s\n",
+               label, static_cast<long>(total_),
+               percentile(50) / unit, percentile(90) / unit, percentile(99) / unit,
+               percentile(99.9) / unit, percentile(99.99) / unit, max() / unit, unitName);
+    }
+private:
+    void recordCount(int64_t value, int64_t n) {
+        if(value < 0) {
+            value = 0;
+        }
+        counts_[indexOf(value)] += n;
+        total_ += n;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += value * n;
+    }
+
+    // 小于128的值一个值一个桶，之后每翻一倍的区间分成64个桶
+    static int indexOf(int64_t value) {
+        int msb = value == 0 ? 0 : 63 - __builtin_clzll(static_cast<uint64_t>(value));
+        int shift = std::max(0, msb - kSubBucketBits);
+        if(shift > kMaxShift) {
+            shift = kMaxShift;
+            value = (2 * kSubBucketCount - 1) << shift; // 超出范围的值记在最后一个桶
+        }
+        return static_cast<int>(shift * kSubBucketCount + (value >> shift));
+    }
+
+    static int64_t highestEquivalent(int index) {
+        int shift = std::max<int64_t>(0, index / kSubBucketCount - 1);
+        int64_t sub = index - shift * kSubBucketCount;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<int64_t> counts_;
+    int64_t total_;
+    int64_t min_;
+    int64_t max_;
+    int64_t sum_;
+};
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "HdrHistogram.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static inline int64_t monotonicNanos() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * 多线程开环负载生成器，对echo服务器按固定速率发请求，不管之前的请求有没有返回
+ * 每个请求的发送时间是预先排好的：第k个请求应该在start + k * interval发出，
+ * 延迟从这个预定时间算起(corrected)，服务器或者生成器自己卡住时，被耽误的请求的排队时间也计入延迟，
+ * 避免闭环测量的协调遗漏(coordinated omission)；同时记录从实际发出时间算起的延迟(uncorrected)用于对比
+ *
+ * 生成器直接使用非阻塞socket和ppoll，不经过被测的reactor，ppoll的超时是纳秒精度，
+ * 不受TimerQueue毫秒级tick的影响
+ * 请求格式：8字节预定发送时间 + 8字节实际发送时间 + 填充，服务器原样返回
+ * 实际发送时间在flush中调用write之前才填写，socket发送缓冲区满、等POLLOUT期间的排队时间不算在uncorrected里
+*/
+class OpenLoopGenerator {
+public:
+    struct Options {
+        Options()
+            : port(0)
+            , threads(1)
+            , connections(1)
+            , rate(10000)
+            , seconds(2.0)
+            , warmup(0.2)
+            , messageSize(64)
+        {}
+
+        uint16_t port;
+        int threads;
+        int connections; // 所有线程的连接总数
+        double rate; // 所有线程合计每秒请求数
+        double seconds; // 发送持续时间，包括warmup
+        double warmup; // 开始的这段时间不计入统计
+        size_t messageSize; // 不小于16
+    };
+
+    struct Result {
+        Result()
+            : sent(0)
+            , received(0)
+            , lateSends(0)
+        {}
+
+        HdrHistogram corrected;
+        HdrHistogram uncorrected;
+        int64_t sent;
+        int64_t received;
+        int64_t lateSends; // 放进发送队列的时间比预定时间晚1ms以上的请求数，说明生成器自己跟不上
+    };
+
+    static Result run(const Options& options) {
+        Options opts = options;
+        opts.messageSize = std::max<size_t>(opts.messageSize, 16);
+        opts.threads = std::max(1, opts.threads);
+        opts.connections = std::max(opts.connections, opts.threads);
+
+        Result total;
+        std::mutex mutex;
+        std::vector<std::thread> threads;
+        const int64_t start = monotonicNanos() + 50 * 1000 * 1000; // 留出建立连接的时间
+        for(int i = 0; i < opts.threads; ++i) {
+            int conns = opts.connections / opts.threads + (i < opts.connections % opts.threads ? 1 : 0);
+            threads.emplace_back([&, conns, i]() {
+                Result result;
+                worker(opts, conns, opts.rate / opts.threads, start + i * 1000, &result);
+                std::unique_lock<std::mutex> lock(mutex);
+                total.corrected.merge(result.corrected);
+                total.uncorrected.merge(result.uncorrected);
+                total.sent += result.sent;
+                total.received += result.received;
+                total.lateSends += result.lateSends;
+            });
+        }
+        for(std::thread& t : threads) {
+            t.join();
+        }
+        return total;
+    }
+private:
+    struct Conn {
+        int fd;
+        std::string out; // 还没有写进socket的请求
+        size_t partial; // out开头属于已经写出一部分的那个请求的字节数，这个请求的发送时间不能再改
+        std::string in; // 还不够一个完整响应的数据
+    };
+
+    static int connectTo(uint16_t port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        ::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+            fprintf(stderr, "OpenLoopGenerator connect error:%d\n", errno);
+            ::close(fd);
+            return -1;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return fd;
+    }
+
+    // 每次write之前给还没有开始发送的请求填上当前时间，EAGAIN以后没写出去的请求下次write时重新填写
+    static void flush(Conn& conn, size_t messageSize) {
+        while(!conn.out.empty()) {
+            const int64_t now = monotonicNanos();
+            for(size_t offset = conn.partial; offset < conn.out.size(); offset += messageSize) {
+                ::memcpy(&conn.out[offset + 8], &now, 8);
+            }
+            ssize_t n = ::write(conn.fd, conn.out.data(), conn.out.size());
+            if(n <= 0) {
+                break; // EAGAIN，等POLLOUT
+            }
+            conn.out.erase(0, n);
+            size_t written = static_cast<size_t>(n);
+            if(written < conn.partial) {
+                conn.partial -= written;
+            }
+            else {
+                conn.partial = (messageSize - (written - conn.partial) % messageSize) % messageSize;
+            }
+        }
+    }
+
+    static void worker(const Options& opts, int numConns, double rate, int64_t start, Result* result) {
+        std::vector<Conn> conns;
+        for(int i = 0; i < numConns; ++i) {
+            int fd = connectTo(opts.port);
+            if(fd >= 0) {
+                conns.push_back(Conn{fd, std::string(), 0, std::string()});
+            }
+        }
+        if(conns.empty()) {
+            return;
+        }
+
+        const int64_t interval = static_cast<int64_t>(1e9 / rate);
+        const int64_t measureFrom = start + static_cast<int64_t>(opts.warmup * 1e9);
+        const int64_t sendUntil = start + static_cast<int64_t>(opts.seconds * 1e9);
+        const int64_t drainUntil = sendUntil + 1000 * 1000 * 1000; // 最多再等1秒未返回的响应
+        std::string message(opts.messageSize, 'x');
+        std::vector<pollfd> pfds(conns.size());
+        int64_t nextSend = start;
+        int64_t outstanding = 0;
+        size_t next = 0;
+        char buf[65536];
+        bool closed = false;
+
+        while(!closed) {
+            int64_t now = monotonicNanos();
+            if(now >= drainUntil || (now >= sendUntil && outstanding == 0)) {
+                break;
+            }
+
+            // 发出所有已经到预定时间的请求，生成器落后时会一次补发多个
+            while(nextSend <= now && nextSend < sendUntil) {
+                Conn& conn = conns[next++ % conns.size()];
+                ::memcpy(&message[0], &nextSend, 8); // 实际发送时间在flush中填写
+                conn.out.append(message);
+                if(now - nextSend > 1000 * 1000) {
+                    ++result->lateSends;
+                }
+                ++result->sent;
+                ++outstanding;
+                nextSend += interval;
+            }
+            for(Conn& conn : conns) {
+                flush(conn, opts.messageSize);
+            }
+
+            for(size_t i = 0; i < conns.size(); ++i) {
+                pfds[i].fd = conns[i].fd;
+                pfds[i].events = POLLIN | (conns[i].out.empty() ? 0 : POLLOUT);
+                pfds[i].revents = 0;
+            }
+            int64_t wait = (nextSend < sendUntil ? nextSend : drainUntil) - monotonicNanos();
+            wait = std::max<int64_t>(0, wait);
+            struct timespec ts = { static_cast<time_t>(wait / 1000000000), static_cast<long>(wait % 1000000000) };
+            int n = ::ppoll(pfds.data(), pfds.size(), &ts, nullptr);
+            if(n <= 0) {
+                continue;
+            }
+
+            for(size_t i = 0; i < conns.size(); ++i) {
+                if(!(pfds[i].revents & (POLLIN | POLLERR | POLLHUP))) {
+                    continue;
+                }
+                Conn& conn = conns[i];
+                ssize_t r = ::read(conn.fd, buf, sizeof buf);
+                if(r == 0 || (r < 0 && errno != EAGAIN)) {
+                    fprintf(stderr, "OpenLoopGenerator connection closed by server\n");
+                    closed = true;
+                    break;
+                }
+                if(r < 0) {
+                    continue;
+                }
+                const int64_t recvTime = monotonicNanos();
+                conn.in.append(buf, r);
+                size_t offset = 0;
+                while(conn.in.size() - offset >= opts.messageSize) {
+                    int64_t intended = 0;
+                    int64_t actual = 0;
+                    ::memcpy(&intended, conn.in.data() + offset, 8);
+                    ::memcpy(&actual, conn.in.data() + offset + 8, 8);
+                    if(intended >= measureFrom) {
+                        result->corrected.record(recvTime - intended);
+                        result->uncorrected.record(recvTime - actual);
+                    }
+                    ++result->received;
+                    --outstanding;
+                    offset += opts.messageSize;
+                }
+                conn.in.erase(0, offset);
+            }
+        }
+
+        for(Conn& conn : conns) {
+            ::close(conn.fd);
+        }
+    }
+};
@@ -0,0 +1,127 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <thread>
+#include <vector>
+
+// Acceptor的批量accept和文件描述符耗尽处理
+// storm：先让mainLoop阻塞，堆积kStormConnections个连接，再统计每个连接对应的唤醒次数
+// exhaustion：把RLIMIT_NOFILE调小，连接数超过上限，统计被丢弃的连接数和mainLoop消耗的CPU时间
+
+static const uint16_t kPort = 9996;
+static const int kStormConnections = 512;
+static const int kExhaustionConnections = 256;
+static const rlim_t kExhaustionFdLimit = 128;
+
+static int connectTo() {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+        ::close(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
+
+static double cpuSeconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+         + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void runStorm(int batch) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "AcceptBench");
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.setAcceptBatch(batch);
+    server.start();
+
+    std::thread clients([&loop, &server, batch]() {
+        // mainLoop暂停的时候建立连接，连接都堆积在全连接队列中
+        loop.runInLoop([]() { ::usleep(300 * 1000); });
+        std::vector<int> sockfds;
+        for(int i = 0; i < kStormConnections; ++i) {
+            int sockfd = connectTo();
+            if(sockfd >= 0) {
+                sockfds.push_back(sockfd);
+            }
+        }
+        ::usleep(500 * 1000);
+        Acceptor::Stats stats = server.acceptStats();
+        printf("storm batch=%-3d accepted %4lu, wakeups %4lu, wakeups/conn %.3f\n", batch,
+               (unsigned long)stats.accepted, (unsigned long)stats.wakeups,
+               stats.accepted ? (double)stats.wakeups / stats.accepted : 0.0);
+        for(int sockfd : sockfds) {
+            ::close(sockfd);
+        }
+        ::usleep(100 * 1000);
+        loop.quit();
+    });
+    loop.loop();
+    clients.join();
+}
+
+static void runExhaustion() {
+    rlimit old;
+    ::getrlimit(RLIMIT_NOFILE, &old);
+    rlimit limit = old;
+    limit.rlim_cur = kExhaustionFdLimit;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "AcceptBench");
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.start();
+
+    double cpuStart = cpuSeconds();
+    double cpuEnd = 0;
+    std::thread clients([&loop, &server, &cpuEnd]() {
+        // 客户端和服务器在同一个进程中，共用同一个fd上限
+        std::vector<int> sockfds;
+        for(int i = 0; i < kExhaustionConnections; ++i) {
+            int sockfd = connectTo();
+            if(sockfd >= 0) {
+                sockfds.push_back(sockfd);
+            }
+            else {
+                break; // 客户端自己也受同一个fd上限限制
+            }
+        }
+        ::usleep(1000 * 1000);
+        Acceptor::Stats stats = server.acceptStats();
+        printf("exhaustion fd limit %lu: accepted %lu, shed %lu, EMFILE %lu, wakeups %lu\n",
+               (unsigned long)kExhaustionFdLimit, (unsigned long)stats.accepted, (unsigned long)stats.shed,
+               (unsigned long)stats.fdExhausted, (unsigned long)stats.wakeups);
+        for(int sockfd : sockfds) {
+            ::close(sockfd);
+        }
+        ::usleep(100 * 1000);
+        loop.quit();
+    });
+    loop.loop();
+    cpuEnd = cpuSeconds();
+    clients.join();
+    printf("exhaustion mainLoop cpu time %.3f s over ~1.1 s wall time\n", cpuEnd - cpuStart);
+
+    ::setrlimit(RLIMIT_NOFILE, &old);
+}
+
+int main() {
+    runStorm(1);
+    runStorm(Acceptor::kDefaultAcceptBatch);
+    runExhaustion();
+    return 0;
+}
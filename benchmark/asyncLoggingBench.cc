@@ -0,0 +1,68 @@
+#include <mymuduo/AsyncLogging.h>
+#include <mymuduo/Logger.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 异步日志的基准测试：测量I/O线程写一条INFO日志的耗时
+// 用法：./asynclogging_bench [日志文件前缀]
+
+static const int kRecordsPerThread = 1000 * 1000;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 每个线程写kRecordsPerThread条日志，返回平均每条的耗时(ns)
+static double run(int numThreads, const std::function<void(int)>& logOne) {
+    std::vector<double> costs(numThreads);
+    std::vector<std::unique_ptr<std::thread>> threads;
+    for(int t = 0; t < numThreads; ++t) {
+        threads.emplace_back(new std::thread([&, t] {
+            double start = nowSeconds();
+            for(int i = 0; i < kRecordsPerThread; ++i) {
+                logOne(i);
+            }
+            costs[t] = (nowSeconds() - start) * 1e9 / kRecordsPerThread;
+        }));
+    }
+    double total = 0;
+    for(int t = 0; t < numThreads; ++t) {
+        threads[t]->join();
+        total += costs[t];
+    }
+    return total / numThreads;
+}
+
+int main(int argc, char* argv[]) {
+    const char* basename = argc > 1 ? argv[1] : "/tmp/asynclogging_bench";
+
+    AsyncLogging log(basename, 500 * 1000 * 1000);
+    log.start();
+    Logger::instance().setOutput(
+        std::bind(&AsyncLogging::append, &log, std::placeholders::_1, std::placeholders::_2));
+    Logger::instance().setFlush(std::bind(&AsyncLogging::flush, &log));
+
+    const char line[] = "[INFO]2023-06-07 10:10:10:TcpConnection::handleRead fd=12 bytes=4096\n";
+    for(int numThreads : {1, 4}) {
+        // 只测后端：一条已经格式化好的日志交给AsyncLogging
+        double appendNs = run(numThreads, [&](int) {
+            log.append(line, sizeof(line) - 1);
+        });
+        // 完整路径：LOG_INFO格式化 + AsyncLogging
+        double logNs = run(numThreads, [](int i) {
+            LOG_INFO("TcpConnection::handleRead fd=%d bytes=%d", 12, i);
+        });
+        printf("threads=%d  AsyncLogging::append %7.1f ns/record  LOG_INFO %7.1f ns/record  dropped=%lu\n",
+            numThreads, appendNs, logNs, static_cast<unsigned long>(log.droppedRecords()));
+    }
+
+    log.stop();
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// 自动背压测试：服务器把source连接上收到的数据原样转发给sink连接，相当于一个代理
+// source端的客户端尽快写，sink端的客户端按限定速率读，分别在关闭和开启背压时运行，
+// 对比服务器发送队列的峰值和转发吞吐量
+// 用法：backpressure_bench [-d 秒数] [-r sink读取速率MiB/s] [-H 高水位KiB] [-L 低水位KiB] [-e 边缘触发]
+
+static const uint16_t kPort = 9991;
+static const int64_t kQueueLimit = 256 * 1024 * 1024; // 不开背压时发送队列超过这个值就提前结束，避免占满内存
+
+static EventLoop* g_loop = nullptr;
+static TcpConnectionPtr g_sink; // 只在loop线程中访问
+static TcpConnectionPtr g_source;
+static std::atomic<int> g_serverConnections(0);
+static bool g_backpressure = false;
+static size_t g_highWaterMark = 1024 * 1024;
+static size_t g_lowWaterMark = 256 * 1024;
+
+static int64_t nowNanos() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 先连上来的是sink，后连上来的是source
+static void onConnection(const TcpConnectionPtr& conn) {
+    if(conn->connected()) {
+        if(!g_sink) {
+            g_sink = conn;
+        }
+        else {
+            g_source = conn;
+            if(g_backpressure) {
+                g_sink->setBackpressure(conn, g_highWaterMark, g_lowWaterMark);
+            }
+        }
+        ++g_serverConnections;
+    }
+    else {
+        if(conn == g_sink) {
+            g_sink.reset();
+        }
+        else if(conn == g_source) {
+            g_source.reset();
+        }
+        --g_serverConnections;
+    }
+}
+
+static void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    if(conn == g_source && g_sink) {
+        g_sink->send(buf);
+    }
+    else {
+        buf->retrieveAll();
+    }
+}
+
+static int connectBlocking() {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        fprintf(stderr, "connect error:%d\n", errno);
+        exit(1);
+    }
+    // 阻塞读写最多等100ms，让线程能及时看到停止标志
+    struct timeval tv = { 0, 100 * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    return fd;
+}
+
+static void closeWithReset(int fd) {
+    linger lg = { 1, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+    ::close(fd);
+}
+
+static void waitServerConnections(int expected) {
+    while(g_serverConnections != expected) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void runOnce(bool backpressure, double seconds, double readRate) {
+    g_loop->runInLoop([backpressure]() { g_backpressure = backpressure; });
+
+    int sinkFd = connectBlocking();
+    waitServerConnections(1);
+    int sourceFd = connectBlocking();
+    waitServerConnections(2);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> received(0);
+    std::atomic<int64_t> sent(0);
+    const int64_t start = nowNanos();
+
+    std::thread writer([&]() {
+        std::string chunk(64 * 1024, 'b');
+        while(!stop) {
+            ssize_t n = ::write(sourceFd, chunk.data(), chunk.size());
+            if(n > 0) {
+                sent += n;
+            }
+            else if(errno != EAGAIN && errno != EINTR) {
+                break;
+            }
+        }
+    });
+
+    // 按readRate字节每秒读取，读得比计划快就睡一会儿
+    std::thread reader([&]() {
+        char buf[64 * 1024];
+        while(!stop) {
+            double elapsed = (nowNanos() - start) / 1e9;
+            if(received > elapsed * readRate) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+            ssize_t n = ::read(sinkFd, buf, sizeof buf);
+            if(n > 0) {
+                received += n;
+            }
+            else if(n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                break;
+            }
+        }
+    });
+
+    int64_t peakQueue = 0;
+    bool exceeded = false;
+    const int64_t deadline = start + static_cast<int64_t>(seconds * 1e9);
+    while(nowNanos() < deadline) {
+        peakQueue = std::max(peakQueue, g_loop->pendingOutputBytes());
+        if(peakQueue > kQueueLimit) {
+            exceeded = true;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double elapsed = (nowNanos() - start) / 1e9;
+    int64_t receivedBytes = received;
+    int64_t sentBytes = sent;
+    stop = true;
+    writer.join();
+    reader.join();
+    closeWithReset(sourceFd);
+    closeWithReset(sinkFd);
+    waitServerConnections(0);
+
+    printf("backpressure %-3s  sink %8.2f MiB/s  source wrote %9.2f MiB  peak server queue %9.2f MiB%s\n",
+           backpressure ? "on" : "off", receivedBytes / elapsed / (1024 * 1024), sentBytes / (1024.0 * 1024),
+           peakQueue / (1024.0 * 1024), exceeded ? "  (limit reached, stopped early)" : "");
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = 2.0;
+    double readRate = 32.0 * 1024 * 1024;
+    bool edgeTriggered = false;
+    int opt = 0;
+    while((opt = ::getopt(argc, argv, "d:r:H:L:e")) != -1) {
+        switch(opt) {
+            case 'd': seconds = atof(optarg); break;
+            case 'r': readRate = atof(optarg) * 1024 * 1024; break;
+            case 'H': g_highWaterMark = static_cast<size_t>(atol(optarg)) * 1024; break;
+            case 'L': g_lowWaterMark = static_cast<size_t>(atol(optarg)) * 1024; break;
+            case 'e': edgeTriggered = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-r MiB/s] [-H KiB] [-L KiB] [-e]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    EventLoop loop;
+    g_loop = &loop;
+    TcpServer server(&loop, InetAddress(kPort), "BackpressureBench");
+    server.setConnectionCallback(onConnection);
+    server.setMessageCallback(onMessage);
+    server.setEdgeTriggered(edgeTriggered);
+    server.start();
+
+    std::thread bench([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        printf("sink reads %.1f MiB/s, high water mark %zu KiB, low water mark %zu KiB, %.1fs per run\n",
+               readRate / (1024 * 1024), g_highWaterMark / 1024, g_lowWaterMark / 1024, seconds);
+        runOnce(false, seconds, readRate);
+        runOnce(true, seconds, readRate);
+        fflush(stdout);
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <mymuduo/Channel.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/Callbacks.h>
+
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+// Channel事件分发的基准测试：poller返回一个可读事件后，Channel::handleEvent调用到处理函数要花多少时间
+// 处理函数和TcpConnection::handleRead一样先取一个shared_ptr给用户回调用
+//   legacy    以前TcpConnection的做法：四个std::function，每个都是std::bind(&T::handleX, this)，channel还tie了连接
+//   callbacks 现在的Channel使用setReadCallback等接口（Acceptor、TimerQueue的用法）
+//   handler   现在的Channel使用ChannelHandler，不tie（TcpConnection的用法）
+// 另外对比为每个连接设置回调的开销：以前每个连接拷贝一份用户回调并std::bind四个Channel回调，现在只拷贝一个shared_ptr
+// 用法：./channeldispatch_bench
+
+static const int kIterations = 20 * 1000 * 1000;
+static const int kSetups = 1000 * 1000;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Connection : public ChannelHandler, public std::enable_shared_from_this<Connection> {
+public:
+    Connection() : reads_(0) {}
+
+    void handleRead(Timestamp) override {
+        std::shared_ptr<Connection> guard(shared_from_this());
+        ++reads_;
+    }
+    void handleWrite() override {}
+    void handleClose() override {}
+    void handleError() override {}
+
+    // 用户在TcpServer上设置的回调，常见的写法是std::bind成员函数
+    void onConnection(const TcpConnectionPtr&) {}
+    void onMessage(const TcpConnectionPtr&, Buffer*, Timestamp) {}
+    void onWriteComplete(const TcpConnectionPtr&) {}
+    void onClose(const TcpConnectionPtr&) {}
+
+    long reads_;
+};
+
+// 以前Channel::handleEventWithGuard的写法
+class LegacyChannel {
+public:
+    LegacyChannel() : revents_(0), tied_(false) {}
+
+    void tie(const std::shared_ptr<void>& obj) { tie_ = obj; tied_ = true; }
+    void set_revent(int revt) { revents_ = revt; }
+
+    __attribute__((noinline)) void handleEvent(Timestamp receiveTime) {
+        if(tied_) {
+            std::shared_ptr<void> guard = tie_.lock();
+            if(guard) {
+                handleEventWithGuard(receiveTime);
+            }
+        }
+        else {
+            handleEventWithGuard(receiveTime);
+        }
+    }
+
+    std::function<void(Timestamp)> readCallback_;
+    std::function<void()> writeCallback_;
+    std::function<void()> closeCallback_;
+    std::function<void()> errorCallback_;
+private:
+    void handleEventWithGuard(Timestamp receiveTime) {
+        if((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) {
+            if(closeCallback_) closeCallback_();
+        }
+        if(revents_ & EPOLLERR) {
+            if(errorCallback_) errorCallback_();
+        }
+        if(revents_ & (EPOLLIN | EPOLLPRI)) {
+            if(readCallback_) readCallback_(receiveTime);
+        }
+        if(revents_ & EPOLLOUT) {
+            if(writeCallback_) writeCallback_();
+        }
+    }
+
+    int revents_;
+    std::weak_ptr<void> tie_;
+    bool tied_;
+};
+
+template<typename ChannelType>
+static double runDispatch(ChannelType& channel) {
+    Timestamp now(Timestamp::now());
+    double start = nowSeconds();
+    for(int i = 0; i < kIterations; ++i) {
+        channel.handleEvent(now);
+    }
+    return (nowSeconds() - start) * 1e9 / kIterations;
+}
+
+// 以前TcpConnection中的回调成员，每个连接一份
+struct LegacyConnectionCallbacks {
+    std::function<void(Timestamp)> read;
+    std::function<void()> write;
+    std::function<void()> close;
+    std::function<void()> error;
+    ConnectionCallback connection;
+    MessageCallback message;
+    WriteCompleteCallback writeComplete;
+    CloseCallback closeConnection;
+};
+
+int main() {
+    using namespace std::placeholders;
+
+    EventLoop loop;
+    std::shared_ptr<Connection> conn(new Connection());
+
+    LegacyChannel legacy;
+    legacy.readCallback_ = std::bind(&Connection::handleRead, conn.get(), _1);
+    legacy.writeCallback_ = std::bind(&Connection::handleWrite, conn.get());
+    legacy.closeCallback_ = std::bind(&Connection::handleClose, conn.get());
+    legacy.errorCallback_ = std::bind(&Connection::handleError, conn.get());
+    legacy.tie(conn);
+    legacy.set_revent(EPOLLIN);
+
+    Channel callbacks(&loop, -1);
+    callbacks.setReadCallback(std::bind(&Connection::handleRead, conn.get(), _1));
+    callbacks.setWriteCallback(std::bind(&Connection::handleWrite, conn.get()));
+    callbacks.setCloseCallback(std::bind(&Connection::handleClose, conn.get()));
+    callbacks.setErrorCallback(std::bind(&Connection::handleError, conn.get()));
+    callbacks.set_revent(EPOLLIN);
+
+    Channel handler(&loop, -1);
+    handler.setHandler(conn.get());
+    handler.set_revent(EPOLLIN);
+
+    double legacyNs = runDispatch(legacy);
+    double callbacksNs = runDispatch(callbacks);
+    double handlerNs = runDispatch(handler);
+
+    // 每个连接建立时设置回调
+    ConnectionCallbacksPtr shared(std::make_shared<ConnectionCallbacks>());
+    shared->connection = std::bind(&Connection::onConnection, conn.get(), _1);
+    shared->message = std::bind(&Connection::onMessage, conn.get(), _1, _2, _3);
+    shared->writeComplete = std::bind(&Connection::onWriteComplete, conn.get(), _1);
+    shared->close = std::bind(&Connection::onClose, conn.get(), _1);
+
+    double start = nowSeconds();
+    for(int i = 0; i < kSetups; ++i) {
+        std::unique_ptr<LegacyConnectionCallbacks> c(new LegacyConnectionCallbacks());
+        c->read = std::bind(&Connection::handleRead, conn.get(), _1);
+        c->write = std::bind(&Connection::handleWrite, conn.get());
+        c->close = std::bind(&Connection::handleClose, conn.get());
+        c->error = std::bind(&Connection::handleError, conn.get());
+        c->connection = shared->connection;
+        c->message = shared->message;
+        c->writeComplete = shared->writeComplete;
+        c->closeConnection = std::bind(&Connection::onClose, conn.get(), _1);
+    }
+    double legacySetupNs = (nowSeconds() - start) * 1e9 / kSetups;
+
+    start = nowSeconds();
+    for(int i = 0; i < kSetups; ++i) {
+        std::unique_ptr<ConnectionCallbacksPtr> c(new ConnectionCallbacksPtr(shared));
+    }
+    double sharedSetupNs = (nowSeconds() - start) * 1e9 / kSetups;
+
+    printf("handleEvent(EPOLLIN):  legacy std::function %5.2f ns  Channel callbacks %5.2f ns  Channel handler %5.2f ns\n",
+           legacyNs, callbacksNs, handlerNs);
+    printf("per-connection callbacks: legacy copies %6.1f ns / %zu bytes  shared %6.1f ns / %zu bytes\n",
+           legacySetupNs, sizeof(LegacyConnectionCallbacks), sharedSetupNs, sizeof(ConnectionCallbacksPtr) + sizeof(bool));
+    printf("sizeof(Channel) %zu  sizeof(TcpConnection) %zu  (%ld reads)\n",
+           sizeof(Channel), sizeof(TcpConnection), conn->reads_);
+    return 0;
+}
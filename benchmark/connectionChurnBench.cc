@@ -0,0 +1,235 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/ConnectionRegistry.h>
+#include <mymuduo/BlockPool.h>
+#include <mymuduo/TcpConnection.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <vector>
+
+// 连接的建立和销毁在服务器一侧花多少CPU，分两部分：
+// 1. TcpServer为每个连接做的登记工作：以前的做法（snprintf拼名字、getsockname、以名字为key的unordered_map）
+//    和ConnectionRegistry（整数ID、名字和本机地址用到时才生成）各重复kIterations次
+// 2. 连接对象的分配：以前TcpConnection、Socket、Channel和shared_ptr的控制块分别new，
+//    现在allocate_shared一次分配，内存块来自loop的BlockPool
+// 3. 端到端：客户端线程不停地connect后RST关闭，默认服务器只有一个loop（accept、建立连接、删除连接都在这个线程），
+//    用getrusage(RUSAGE_THREAD)统计mainLoop线程的CPU时间，除以销毁的连接数，最后打印mainLoop的BlockPool统计
+//    客户端RST关闭时服务器会写ERROR日志，这里把日志级别设为FATAL，只统计连接管理本身的开销
+// 用法：connectionchurn_bench [-d 秒数] [-c 客户端线程数] [-t 服务器subLoop数]
+
+static const uint16_t kPort = 9992;
+static const int kIterations = 1000 * 1000;
+static const int kLiveConnections = 1000; // 登记表中同时存在的连接数
+
+static std::atomic<int64_t> g_closed(0);
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double toMicros(const timeval& tv) {
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void onConnection(const TcpConnectionPtr& conn) {
+    if(!conn->connected()) {
+        ++g_closed;
+    }
+}
+
+static void connectLoop(double deadline) {
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    while(nowSeconds() < deadline) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+            ::close(sockfd);
+            continue;
+        }
+        // 直接RST关闭，客户端不留TIME_WAIT，避免本地端口耗尽
+        linger lg = { 1, 0 };
+        ::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+        ::close(sockfd);
+    }
+}
+
+// 以前TcpServer::newConnection和removeConnectionInLoop中的做法
+static double legacyBookkeeping(int sockfd) {
+    const std::string name = "ConnectionChurnBench";
+    const std::string ipPort = "127.0.0.1:9992";
+    std::unordered_map<std::string, TcpConnectionPtr> connections;
+    std::vector<std::string> live(kLiveConnections);
+    int nextConnId = 1;
+    double start = nowSeconds();
+    for(int i = 0; i < kIterations; ++i) {
+        char buf[64] = {0};
+        snprintf(buf, sizeof(buf), "-%s#%d", ipPort.c_str(), nextConnId);
+        ++nextConnId;
+        std::string connName = name + buf;
+
+        sockaddr_in local;
+        ::memset(&local, 0, sizeof(local));
+        socklen_t addrlen = sizeof(local);
+        ::getsockname(sockfd, (sockaddr*)&local, &addrlen);
+        InetAddress localAddr(local);
+
+        std::string& slot = live[i % kLiveConnections];
+        if(!slot.empty()) {
+            connections.erase(slot);
+        }
+        connections[connName] = TcpConnectionPtr();
+        slot = connName;
+    }
+    return (nowSeconds() - start) * 1e9 / kIterations;
+}
+
+static double registryBookkeeping() {
+    ConnectionRegistry connections;
+    std::vector<ConnectionId> live(kLiveConnections);
+    std::shared_ptr<const std::string> namePrefix(new std::string("ConnectionChurnBench-127.0.0.1:9992#"));
+    double start = nowSeconds();
+    for(int i = 0; i < kIterations; ++i) {
+        std::shared_ptr<const std::string> prefix(namePrefix); // TcpConnection持有一份名字前缀
+        ConnectionId& slot = live[i % kLiveConnections];
+        if(slot != 0) {
+            connections.remove(slot);
+        }
+        slot = connections.allocate();
+        connections.set(slot, TcpConnectionPtr());
+    }
+    return (nowSeconds() - start) * 1e9 / kIterations;
+}
+
+// 大小和以前的TcpConnection一样：Socket和Channel单独分配，对象中只有两个指针
+struct LegacySocket {
+    int fd;
+};
+struct LegacyChannel {
+    char body[sizeof(Channel)];
+};
+struct LegacyConnection {
+    LegacyConnection() : socket(new LegacySocket()), channel(new LegacyChannel()) {}
+    std::unique_ptr<LegacySocket> socket;
+    std::unique_ptr<LegacyChannel> channel;
+    char body[sizeof(TcpConnection) - sizeof(Socket) - sizeof(Channel)];
+};
+struct PooledConnection {
+    char body[sizeof(TcpConnection)];
+};
+
+template<typename Create>
+static double allocationLoop(const Create& create) {
+    std::vector<std::shared_ptr<void>> live(kLiveConnections);
+    double start = nowSeconds();
+    for(int i = 0; i < kIterations; ++i) {
+        live[i % kLiveConnections] = create();
+    }
+    return (nowSeconds() - start) * 1e9 / kIterations;
+}
+
+// 在loop线程中读取它自己的CPU时间
+static rusage loopUsage(EventLoop* loop) {
+    std::shared_ptr<std::promise<rusage>> result(new std::promise<rusage>());
+    loop->runInLoop([result]() {
+        rusage usage;
+        ::getrusage(RUSAGE_THREAD, &usage);
+        result->set_value(usage);
+    });
+    return result->get_future().get();
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = 2.0;
+    int clientThreads = 2;
+    int numLoops = 0;
+    int opt = 0;
+    while((opt = ::getopt(argc, argv, "d:c:t:")) != -1) {
+        switch(opt) {
+            case 'd': seconds = atof(optarg); break;
+            case 'c': clientThreads = atoi(optarg); break;
+            case 't': numLoops = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds] [-c client threads] [-t server loops]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    Logger::setLogLevel(FATAL);
+
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    double legacy = legacyBookkeeping(sockfd);
+    double registry = registryBookkeeping();
+    ::close(sockfd);
+    printf("per-connection bookkeeping: name string + getsockname + map %.1f ns, ConnectionRegistry %.1f ns\n",
+           legacy, registry);
+
+    std::shared_ptr<BlockPool> pool(std::make_shared<BlockPool>());
+    double separate = allocationLoop([]() {
+        return std::shared_ptr<LegacyConnection>(new LegacyConnection());
+    });
+    double pooled = allocationLoop([&pool]() {
+        return std::allocate_shared<PooledConnection>(PoolAllocator<PooledConnection>(pool));
+    });
+    printf("connection object allocation: new x4 %.1f ns, allocate_shared from BlockPool %.1f ns\n",
+           separate, pooled);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ConnectionChurnBench");
+    server.setConnectionCallback(onConnection);
+    server.setThreadNum(numLoops);
+    server.start();
+
+    std::thread bench([&]() {
+        ::usleep(100 * 1000); // 等Acceptor开始监听
+        rusage before = loopUsage(&loop);
+        int64_t closedBefore = g_closed;
+        double start = nowSeconds();
+        std::vector<std::thread> clients;
+        for(int i = 0; i < clientThreads; ++i) {
+            clients.emplace_back(connectLoop, start + seconds);
+        }
+        for(std::thread& t : clients) {
+            t.join();
+        }
+        ::usleep(100 * 1000); // 等服务器处理完积压的连接
+        double elapsed = nowSeconds() - start;
+        rusage after = loopUsage(&loop);
+        int64_t closed = g_closed - closedBefore;
+
+        double user = toMicros(after.ru_utime) - toMicros(before.ru_utime);
+        double sys = toMicros(after.ru_stime) - toMicros(before.ru_stime);
+        printf("%ld connections in %.2fs (%.0f conn/s), server loop CPU per connection: user %.2f us  sys %.2f us  total %.2f us\n",
+               static_cast<long>(closed), elapsed, closed / elapsed,
+               user / closed, sys / closed, (user + sys) / closed);
+        BlockPool::Stats pool = loop.blockPool()->stats();
+        printf("mainLoop BlockPool: block %zu bytes, %zu allocations, %zu from system, %zu returned from other threads\n",
+               pool.blockSize, pool.allocations, pool.systemAllocations, pool.remoteFrees);
+        fflush(stdout);
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+    return 0;
+}
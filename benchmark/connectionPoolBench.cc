@@ -0,0 +1,154 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/ConnectionPool.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <future>
+#include <string>
+#include <vector>
+
+// 上游请求延迟：每个请求新建一条连接（TcpClient），对比从ConnectionPool中复用连接
+// 客户端在一个loop中顺序发送kRequests个请求，每个请求等待echo完整返回后再发下一个
+
+static const uint16_t kPort = 9994;
+static const int kRequests = 2000;
+static const size_t kMessageSize = 64;
+
+static void onEchoMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf->retrieveAllAsString());
+}
+
+class Driver {
+public:
+    Driver(EventLoop* loop, bool pooled)
+        : loop_(loop)
+        , pooled_(pooled)
+        , message_(kMessageSize, 'x')
+        , remaining_(kRequests)
+        , failed_(0)
+    {
+        if(pooled_) {
+            ConnectionPool::Options options;
+            options.maxConnections = 4;
+            pool_.reset(new ConnectionPool(loop_, InetAddress(kPort), "pool", options));
+        }
+    }
+
+    ~Driver() {
+        // 连接池和TcpClient必须在自己的loop中析构
+        std::promise<void> destroyed;
+        loop_->runInLoop([this, &destroyed]() {
+            pool_.reset();
+            client_.reset();
+            destroyed.set_value();
+        });
+        destroyed.get_future().wait();
+    }
+
+    std::future<void> start() {
+        loop_->runInLoop(std::bind(&Driver::next, this));
+        return done_.get_future();
+    }
+
+    void report() {
+        std::sort(latencies_.begin(), latencies_.end());
+        double sum = 0;
+        for(double l : latencies_) {
+            sum += l;
+        }
+        size_t n = latencies_.size();
+        printf("%-22s %6lu requests  avg %7.1f us  p50 %7.1f us  p99 %7.1f us  failed %d\n",
+               pooled_ ? "pooled connections" : "connect per request",
+               n, n ? sum / n : 0, n ? latencies_[n / 2] : 0, n ? latencies_[n * 99 / 100] : 0, failed_);
+    }
+private:
+    void next() {
+        if(remaining_ == 0) {
+            done_.set_value();
+            return;
+        }
+        --remaining_;
+        start_ = Timestamp::now();
+        if(pooled_) {
+            pool_->acquire(std::bind(&Driver::onAcquire, this, std::placeholders::_1));
+        }
+        else {
+            client_.reset(new TcpClient(loop_, InetAddress(kPort), "client"));
+            client_->setConnectionCallback([this](const TcpConnectionPtr& conn) {
+                if(conn->connected()) {
+                    conn->send(message_);
+                }
+            });
+            client_->setMessageCallback(std::bind(&Driver::onMessage, this,
+                std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+            client_->connect();
+        }
+    }
+
+    void onAcquire(const TcpConnectionPtr& conn) {
+        if(!conn) {
+            ++failed_;
+            loop_->queueInLoop(std::bind(&Driver::next, this));
+            return;
+        }
+        conn->setMessageCallback(std::bind(&Driver::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        conn->send(message_);
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        if(buf->readableBytes() < kMessageSize) {
+            return;
+        }
+        buf->retrieveAll();
+        latencies_.push_back(timeDifference(Timestamp::now(), start_) * 1e6);
+        if(pooled_) {
+            pool_->release(conn);
+        }
+        // TcpClient不能在自己的回调中析构
+        loop_->queueInLoop([this]() {
+            client_.reset();
+            next();
+        });
+    }
+
+    EventLoop* loop_;
+    bool pooled_;
+    std::string message_;
+    int remaining_;
+    int failed_;
+    Timestamp start_;
+    std::vector<double> latencies_;
+    std::unique_ptr<ConnectionPool> pool_;
+    std::unique_ptr<TcpClient> client_;
+    std::promise<void> done_;
+};
+
+int main() {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ConnectionPoolBench");
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.setMessageCallback(onEchoMessage);
+    server.setThreadNum(1);
+    server.start();
+
+    EventLoopThread clientThread(EventLoopThread::ThreadInitCallback(), "client");
+    EventLoop* clientLoop = clientThread.startLoop();
+
+    std::thread bench([&loop, clientLoop]() {
+        const bool modes[] = { false, true };
+        for(bool pooled : modes) {
+            Driver driver(clientLoop, pooled);
+            driver.start().wait();
+            driver.report();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+    return 0;
+}
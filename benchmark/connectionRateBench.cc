@@ -0,0 +1,93 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// 新连接建立速率：客户端线程不停地connect/close，统计服务器每秒建立的连接数
+// 对比mainLoop统一accept再分给subLoop（kReusePort），和每个subLoop自己accept（kReusePortPerLoop）
+
+static const uint16_t kPort = 9995;
+static const int kClientThreads = 4;
+static const double kSeconds = 2.0;
+
+static std::atomic<int64_t> g_accepted(0);
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void onConnection(const TcpConnectionPtr& conn) {
+    if(conn->connected()) {
+        ++g_accepted;
+    }
+}
+
+static void connectLoop(double deadline) {
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    while(nowSeconds() < deadline) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+            ::close(sockfd);
+            continue;
+        }
+        // 直接RST关闭，客户端不留TIME_WAIT，避免本地端口耗尽
+        linger lg = { 1, 0 };
+        ::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+        ::close(sockfd);
+    }
+}
+
+static void runOnce(int numLoops, TcpServer::Option option) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ConnectionRateBench", option);
+    server.setConnectionCallback(onConnection);
+    server.setThreadNum(numLoops);
+    server.start();
+
+    g_accepted = 0;
+    double start = 0;
+    std::thread bench([&loop, &start]() {
+        ::usleep(100 * 1000); // 等所有Acceptor开始监听
+        start = nowSeconds();
+        std::vector<std::thread> clients;
+        for(int i = 0; i < kClientThreads; ++i) {
+            clients.emplace_back(connectLoop, start + kSeconds);
+        }
+        for(std::thread& t : clients) {
+            t.join();
+        }
+        ::usleep(100 * 1000); // 等服务器处理完积压的连接
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+
+    printf("%2d loops %-22s %9.0f conn/s\n", numLoops,
+           option == TcpServer::kReusePortPerLoop ? "per-loop acceptors" : "mainLoop acceptor",
+           g_accepted / kSeconds);
+}
+
+int main() {
+    const int loopCounts[] = { 1, 4, 16 };
+    for(int numLoops : loopCounts) {
+        runOnce(numLoops, TcpServer::kReusePort);
+        runOnce(numLoops, TcpServer::kReusePortPerLoop);
+    }
+    return 0;
+}
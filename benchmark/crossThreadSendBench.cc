@@ -0,0 +1,138 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 跨线程send的吞吐量测试：业务线程向属于subloop的连接发送数据，客户端线程读取
+// 对比 send(const std::string&)（拷贝）、send(std::string&&)（移动）、send(SharedBlock)（共享）
+
+static const uint16_t kPort = 9981;
+static const size_t kTotalBytes = 64 * 1024 * 1024;
+
+static std::mutex g_mutex;
+static std::condition_variable g_cond;
+static TcpConnectionPtr g_conn;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void onConnection(const TcpConnectionPtr& conn) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    g_conn = conn->connected() ? conn : TcpConnectionPtr();
+    g_cond.notify_all();
+}
+
+static void readAll(int sockfd, size_t total) {
+    static char buf[256 * 1024];
+    size_t received = 0;
+    while(received < total) {
+        ssize_t n = ::read(sockfd, buf, sizeof buf);
+        if(n <= 0) {
+            break;
+        }
+        received += n;
+    }
+}
+
+enum Mode { kCopy, kMove, kShared };
+static const char* kModeNames[] = { "copy", "move", "shared" };
+
+static void runOnce(Mode mode, size_t payload) {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        return;
+    }
+
+    TcpConnectionPtr conn;
+    {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        while(!g_conn) {
+            g_cond.wait(lock);
+        }
+        conn = g_conn;
+    }
+
+    size_t count = kTotalBytes / payload;
+    std::string message(payload, 'x');
+    SharedBlock block = std::make_shared<const std::string>(message);
+    std::thread reader(readAll, sockfd, count * payload);
+
+    double start = nowSeconds();
+    for(size_t i = 0; i < count; ++i) {
+        switch(mode) {
+        case kCopy: {
+            std::string msg(message); // 业务线程生成的消息
+            conn->send(msg);
+            break;
+        }
+        case kMove: {
+            std::string msg(message);
+            conn->send(std::move(msg));
+            break;
+        }
+        case kShared:
+            conn->send(block);
+            break;
+        }
+    }
+    double sent = nowSeconds();
+    reader.join();
+    double elapsed = nowSeconds() - start;
+
+    printf("%-6s %8zu B x %8zu: send %8.3f s, total %8.3f s, %9.1f MiB/s\n",
+           kModeNames[mode], payload, count, sent - start, elapsed,
+           count * payload / elapsed / 1024 / 1024);
+
+    conn->shutdown();
+    ::close(sockfd);
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while(g_conn) {
+        g_cond.wait(lock);
+    }
+}
+
+int main() {
+    EventLoop loop;
+    InetAddress listenAddr(kPort);
+    TcpServer server(&loop, listenAddr, "CrossThreadSendBench");
+    server.setConnectionCallback(onConnection);
+    server.setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        buf->retrieveAll();
+    });
+    server.setThreadNum(1);
+    server.start();
+
+    std::thread bench([&loop]() {
+        const size_t payloads[] = { 64, 4 * 1024, 1024 * 1024 };
+        for(size_t payload : payloads) {
+            for(int mode = kCopy; mode <= kShared; ++mode) {
+                runOnce(static_cast<Mode>(mode), payload);
+            }
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    bench.join();
+    return 0;
+}
@@ -0,0 +1,449 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/InetAddress.h>
+
+#include "HdrHistogram.h"
+#include "LoadGenerator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 端到端性能测试，服务器和负载都跑在本机回环上，用来在改动reactor以后发现性能回退
+//   pingpong  不同消息大小、连接数下的echo吞吐量
+//   latency   开环负载下的echo延迟分位数，修正了协调遗漏
+//   churn     短连接：connect、一次echo、close的速率和延迟
+//   idle      大量空闲连接对内存和活跃连接延迟的影响
+// 用法：e2e_bench [all|pingpong|latency|churn|idle] [-t 服务器subLoop数] [-d 每项秒数]
+//                 [-c 连接数] [-s 消息字节数] [-r 每秒请求数] [-g 负载线程数] [-n 空闲连接数]
+
+static const uint16_t kPort = 9990;
+
+struct Config {
+    Config()
+        : serverThreads(1)
+        , seconds(2.0)
+        , connections(0)
+        , size(0)
+        , rate(20000)
+        , loadThreads(1)
+        , idle(5000)
+    {}
+
+    int serverThreads;
+    double seconds;
+    int connections; // 0表示使用场景默认值
+    size_t size; // 0表示使用场景默认值
+    double rate;
+    int loadThreads;
+    int idle;
+};
+
+static std::atomic<int64_t> g_serverConnections(0);
+
+static void onServerConnection(const TcpConnectionPtr& conn) {
+    if(conn->connected()) {
+        conn->setTcpNoDelay(true);
+        ++g_serverConnections;
+    }
+    else {
+        --g_serverConnections;
+    }
+}
+
+static void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+}
+
+static void sleepSeconds(double seconds) {
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(seconds * 1e6)));
+}
+
+// 等服务器上的连接数变为expected，最多等timeout秒
+static bool waitServerConnections(int64_t expected, double timeout) {
+    int64_t deadline = monotonicNanos() + static_cast<int64_t>(timeout * 1e9);
+    while(g_serverConnections != expected) {
+        if(monotonicNanos() > deadline) {
+            return false;
+        }
+        sleepSeconds(0.005);
+    }
+    return true;
+}
+
+static int connectBlocking() {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(fd, (sockaddr*)&addr, sizeof addr) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+static bool echoOnce(int fd, const char* msg, size_t len) {
+    if(::write(fd, msg, len) != static_cast<ssize_t>(len)) {
+        return false;
+    }
+    char buf[256];
+    size_t got = 0;
+    while(got < len) {
+        ssize_t n = ::read(fd, buf, std::min(sizeof buf, len - got));
+        if(n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+// 直接RST关闭，客户端不留TIME_WAIT，避免本地端口耗尽
+static void closeWithReset(int fd) {
+    linger lg = { 1, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+    ::close(fd);
+}
+
+static long residentKb() {
+    long pages = 0;
+    long resident = 0;
+    FILE* fp = ::fopen("/proc/self/statm", "r");
+    if(fp != nullptr) {
+        if(::fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        ::fclose(fp);
+    }
+    return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 在loop线程中执行f并等待完成
+static void runInLoopAndWait(EventLoop* loop, const std::function<void()>& f) {
+    std::promise<void> done;
+    loop->runInLoop([&]() {
+        f();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+class LoadThreads {
+public:
+    explicit LoadThreads(int n) {
+        for(int i = 0; i < n; ++i) {
+            threads_.emplace_back(new EventLoopThread(EventLoopThread::ThreadInitCallback(),
+                "load" + std::to_string(i)));
+            loops_.push_back(threads_.back()->startLoop());
+        }
+    }
+
+    const std::vector<EventLoop*>& loops() const { return loops_; }
+private:
+    std::vector<std::unique_ptr<EventLoopThread>> threads_;
+    std::vector<EventLoop*> loops_;
+};
+
+// ---------------- pingpong ----------------
+
+// 连接建立后发出一条消息，之后把收到的数据原样发回，服务器也是echo，消息在两端之间来回传递
+class PingpongSession {
+public:
+    PingpongSession(EventLoop* loop, size_t size, std::atomic<int64_t>* bytes, std::atomic<int>* connected)
+        : client_(loop, InetAddress(kPort), "pingpong")
+        , message_(size, 'p')
+        , bytes_(bytes)
+        , connected_(connected)
+    {
+        client_.setConnectionCallback(std::bind(&PingpongSession::onConnection, this, std::placeholders::_1));
+        client_.setMessageCallback(std::bind(&PingpongSession::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        client_.connect();
+    }
+
+    // 在client所在的loop中析构；连接可能还被排队中的发送任务引用，~TcpClient不会关闭它，
+    // 这里先摘掉指向本对象的回调再强制关闭
+    ~PingpongSession() {
+        TcpConnectionPtr conn = client_.connection();
+        if(conn) {
+            conn->setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+            conn->forceClose();
+        }
+    }
+private:
+    void onConnection(const TcpConnectionPtr& conn) {
+        if(conn->connected()) {
+            conn->setTcpNoDelay(true);
+            ++*connected_;
+            conn->send(message_);
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        bytes_->fetch_add(buf->readableBytes(), std::memory_order_relaxed);
+        conn->send(buf);
+    }
+
+    TcpClient client_;
+    std::string message_;
+    std::atomic<int64_t>* bytes_;
+    std::atomic<int>* connected_;
+};
+
+static void runPingpong(const Config& cfg) {
+    printf("== pingpong: echo throughput, %d server loops, %d load loops, %.1fs each ==\n",
+           cfg.serverThreads, cfg.loadThreads, cfg.seconds);
+    std::vector<int> connCounts = { 1, 10, 100 };
+    std::vector<size_t> sizes = { 64, 1024, 16384, 65536 };
+    if(cfg.connections > 0) {
+        connCounts = { cfg.connections };
+    }
+    if(cfg.size > 0) {
+        sizes = { cfg.size };
+    }
+
+    LoadThreads load(cfg.loadThreads);
+    const std::vector<EventLoop*>& loops = load.loops();
+    for(int conns : connCounts) {
+        for(size_t size : sizes) {
+            std::atomic<int64_t> bytes(0);
+            std::atomic<int> connected(0);
+            std::vector<std::vector<std::unique_ptr<PingpongSession>>> sessions(loops.size());
+            for(size_t i = 0; i < loops.size(); ++i) {
+                int n = conns / loops.size() + (i < conns % loops.size() ? 1 : 0);
+                runInLoopAndWait(loops[i], [&, i, n]() {
+                    for(int k = 0; k < n; ++k) {
+                        sessions[i].emplace_back(new PingpongSession(loops[i], size, &bytes, &connected));
+                    }
+                });
+            }
+            while(connected < conns) {
+                sleepSeconds(0.001);
+            }
+
+            sleepSeconds(0.1); // 预热
+            int64_t startBytes = bytes;
+            int64_t start = monotonicNanos();
+            sleepSeconds(cfg.seconds);
+            int64_t total = bytes - startBytes;
+            double elapsed = (monotonicNanos() - start) / 1e9;
+
+            for(size_t i = 0; i < loops.size(); ++i) {
+                runInLoopAndWait(loops[i], [&, i]() { sessions[i].clear(); });
+            }
+            waitServerConnections(0, 5.0);
+
+            printf("connections %4d  size %6zu  %10.2f MiB/s  %10.0f msgs/s\n",
+                   conns, size, total / elapsed / (1024 * 1024), total / elapsed / size);
+        }
+    }
+}
+
+// ---------------- latency ----------------
+
+static void runLatency(const Config& cfg) {
+    OpenLoopGenerator::Options opts;
+    opts.port = kPort;
+    opts.threads = cfg.loadThreads;
+    opts.connections = cfg.connections > 0 ? cfg.connections : 16;
+    opts.rate = cfg.rate;
+    opts.seconds = cfg.seconds;
+    opts.messageSize = cfg.size > 0 ? cfg.size : 64;
+    printf("== latency: open-loop echo, %.0f req/s over %d connections, %d load threads, %zu bytes, %d server loops ==\n",
+           opts.rate, opts.connections, opts.threads, opts.messageSize, cfg.serverThreads);
+
+    OpenLoopGenerator::Result result = OpenLoopGenerator::run(opts);
+    waitServerConnections(0, 5.0);
+
+    printf("sent %ld  received %ld  late sends %ld\n",
+           static_cast<long>(result.sent), static_cast<long>(result.received), static_cast<long>(result.lateSends));
+    result.corrected.print("from intended send", 1000.0, "us");
+    result.uncorrected.print("from actual send", 1000.0, "us");
+}
+
+// ---------------- churn ----------------
+
+static void runChurn(const Config& cfg) {
+    int threads = cfg.connections > 0 ? cfg.connections : cfg.loadThreads;
+    printf("== churn: connect + 16 byte echo + close, %d client threads, %d server loops, %.1fs ==\n",
+           threads, cfg.serverThreads, cfg.seconds);
+
+    std::mutex mutex;
+    HdrHistogram total;
+    std::atomic<int64_t> failures(0);
+    int64_t deadline = monotonicNanos() + static_cast<int64_t>(cfg.seconds * 1e9);
+    std::vector<std::thread> clients;
+    for(int i = 0; i < threads; ++i) {
+        clients.emplace_back([&]() {
+            HdrHistogram histogram;
+            char msg[16];
+            ::memset(msg, 'c', sizeof msg);
+            while(monotonicNanos() < deadline) {
+                int64_t start = monotonicNanos();
+                int fd = connectBlocking();
+                if(fd < 0) {
+                    ++failures;
+                    continue;
+                }
+                bool ok = echoOnce(fd, msg, sizeof msg);
+                closeWithReset(fd);
+                if(ok) {
+                    histogram.record(monotonicNanos() - start);
+                }
+                else {
+                    ++failures;
+                }
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            total.merge(histogram);
+        });
+    }
+    for(std::thread& t : clients) {
+        t.join();
+    }
+    waitServerConnections(0, 5.0);
+
+    printf("%10.0f connections/s  failures %ld\n", total.count() / cfg.seconds, static_cast<long>(failures.load()));
+    total.print("connect+echo+close", 1000.0, "us");
+}
+
+// ---------------- idle ----------------
+
+static HdrHistogram measureEchoRtt(int iterations) {
+    HdrHistogram histogram;
+    int fd = connectBlocking();
+    if(fd < 0) {
+        return histogram;
+    }
+    char msg[64];
+    ::memset(msg, 'e', sizeof msg);
+    for(int i = 0; i < iterations; ++i) {
+        int64_t start = monotonicNanos();
+        if(!echoOnce(fd, msg, sizeof msg)) {
+            break;
+        }
+        histogram.record(monotonicNanos() - start);
+    }
+    closeWithReset(fd);
+    return histogram;
+}
+
+static void runIdle(const Config& cfg) {
+    // 客户端和服务器在同一个进程中，每条连接占两个fd
+    rlimit limit;
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+    int maxIdle = static_cast<int>((limit.rlim_cur - 256) / 2);
+    int idle = std::min(cfg.idle, maxIdle);
+    printf("== idle: %d idle connections, %d server loops ==\n", idle, cfg.serverThreads);
+
+    const int kIterations = 5000;
+    HdrHistogram before = measureEchoRtt(kIterations);
+    waitServerConnections(0, 5.0);
+
+    long rssBefore = residentKb();
+    int64_t start = monotonicNanos();
+    std::vector<int> fds;
+    fds.reserve(idle);
+    for(int i = 0; i < idle; ++i) {
+        int fd = connectBlocking();
+        if(fd < 0) {
+            break;
+        }
+        fds.push_back(fd);
+    }
+    bool allAccepted = waitServerConnections(static_cast<int64_t>(fds.size()), 10.0);
+    double elapsed = (monotonicNanos() - start) / 1e9;
+    long rssAfter = residentKb();
+
+    HdrHistogram after = measureEchoRtt(kIterations);
+
+    printf("established %zu connections in %.3fs (%.0f conn/s)%s\n",
+           fds.size(), elapsed, fds.size() / elapsed, allAccepted ? "" : ", server did not see all of them");
+    printf("resident memory +%ld KB, %.0f bytes per connection (both ends)\n",
+           rssAfter - rssBefore, fds.empty() ? 0.0 : (rssAfter - rssBefore) * 1024.0 / fds.size());
+    before.print("echo rtt without idle", 1000.0, "us");
+    after.print("echo rtt with idle", 1000.0, "us");
+
+    for(int fd : fds) {
+        closeWithReset(fd);
+    }
+    waitServerConnections(0, 10.0);
+}
+
+int main(int argc, char* argv[]) {
+    std::string scenario = "all";
+    if(argc > 1 && argv[1][0] != '-') {
+        scenario = argv[1];
+        --argc;
+        ++argv;
+    }
+
+    Config cfg;
+    int opt = 0;
+    while((opt = ::getopt(argc, argv, "t:d:c:s:r:g:n:")) != -1) {
+        switch(opt) {
+            case 't': cfg.serverThreads = atoi(optarg); break;
+            case 'd': cfg.seconds = atof(optarg); break;
+            case 'c': cfg.connections = atoi(optarg); break;
+            case 's': cfg.size = static_cast<size_t>(atol(optarg)); break;
+            case 'r': cfg.rate = atof(optarg); break;
+            case 'g': cfg.loadThreads = std::max(1, atoi(optarg)); break;
+            case 'n': cfg.idle = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [all|pingpong|latency|churn|idle] [-t n] [-d s] [-c n] [-s bytes] [-r rate] [-g n] [-n idle]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "E2EBench");
+    server.setConnectionCallback(onServerConnection);
+    server.setMessageCallback(onServerMessage);
+    server.setThreadNum(cfg.serverThreads);
+    server.start();
+
+    std::thread bench([&]() {
+        sleepSeconds(0.05); // 等服务器开始监听
+        if(scenario == "all" || scenario == "pingpong") {
+            runPingpong(cfg);
+        }
+        if(scenario == "all" || scenario == "latency") {
+            runLatency(cfg);
+        }
+        if(scenario == "all" || scenario == "churn") {
+            runChurn(cfg);
+        }
+        if(scenario == "all" || scenario == "idle") {
+            runIdle(cfg);
+        }
+        fflush(stdout);
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+    return 0;
+}
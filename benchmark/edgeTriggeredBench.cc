@@ -0,0 +1,185 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Poller.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+// 水平触发和边缘触发的对比，统计subloop每传输1MB数据调用epoll_wait和epoll_ctl的次数
+// echo：客户端一边写一边读，服务器原样发回
+// source：服务器不停发送，客户端每次只读16KB，服务器经常写不完，水平触发要反复注册/注销EPOLLOUT
+
+static const uint16_t kBasePort = 9982;
+static const size_t kTotalBytes = 64 * 1024 * 1024;
+static const size_t kChunkSize = 64 * 1024;
+static const size_t kSourceChunkSize = 256 * 1024;
+static const size_t kSourceReadSize = 16 * 1024;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void onEchoMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+}
+
+// 同一时间只有一个source连接
+static size_t g_sourceSent = 0;
+static SharedBlock g_sourceChunk;
+
+static void onSourceWriteComplete(const TcpConnectionPtr& conn) {
+    if(g_sourceSent < kTotalBytes) {
+        g_sourceSent += g_sourceChunk->size();
+        conn->send(g_sourceChunk);
+    }
+}
+
+static void onSourceConnection(const TcpConnectionPtr& conn) {
+    if(conn->connected()) {
+        g_sourceSent = 0;
+        onSourceWriteComplete(conn);
+    }
+}
+
+struct Counters {
+    uint64_t polls;
+    uint64_t ctls;
+};
+
+// 计数只能在loop线程中读
+static Counters readCounters(EventLoop* loop) {
+    std::promise<Counters> promise;
+    loop->runInLoop([loop, &promise]() {
+        Counters c = { loop->poller()->pollCalls(), loop->poller()->ctlCalls() };
+        promise.set_value(c);
+    });
+    return promise.get_future().get();
+}
+
+static int connectTo(uint16_t port) {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        ::close(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
+
+static size_t readUntil(int sockfd, size_t total, size_t readSize) {
+    static char buf[kChunkSize];
+    size_t received = 0;
+    while(received < total) {
+        ssize_t n = ::read(sockfd, buf, std::min(readSize, sizeof buf));
+        if(n <= 0) {
+            break;
+        }
+        received += n;
+    }
+    return received;
+}
+
+static void report(const char* name, size_t bytes, double elapsed, Counters before, Counters after) {
+    double mb = bytes / 1024.0 / 1024.0;
+    printf("%-10s %4.0f MiB in %6.3f s (%7.1f MiB/s), epoll_wait/MB %7.2f, epoll_ctl/MB %7.2f\n",
+           name, mb, elapsed, mb / elapsed,
+           (after.polls - before.polls) / mb, (after.ctls - before.ctls) / mb);
+}
+
+static void echoClient(const char* name, uint16_t port, EventLoop* ioLoop) {
+    int sockfd = connectTo(port);
+    if(sockfd < 0) {
+        return;
+    }
+    ::usleep(100 * 1000); // 等连接注册到subloop上
+
+    Counters before = readCounters(ioLoop);
+    double start = nowSeconds();
+
+    std::thread writer([sockfd]() {
+        std::string chunk(kChunkSize, 'x');
+        size_t sent = 0;
+        while(sent < kTotalBytes) {
+            ssize_t n = ::write(sockfd, chunk.data(), chunk.size());
+            if(n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+    });
+    size_t received = readUntil(sockfd, kTotalBytes, kChunkSize);
+    writer.join();
+
+    double elapsed = nowSeconds() - start;
+    report(name, received, elapsed, before, readCounters(ioLoop));
+    ::close(sockfd);
+}
+
+static void sourceClient(const char* name, uint16_t port, EventLoop* ioLoop) {
+    Counters before = readCounters(ioLoop);
+    double start = nowSeconds();
+    int sockfd = connectTo(port);
+    if(sockfd < 0) {
+        return;
+    }
+    size_t received = readUntil(sockfd, kTotalBytes, kSourceReadSize);
+    double elapsed = nowSeconds() - start;
+    report(name, received, elapsed, before, readCounters(ioLoop));
+    ::close(sockfd);
+}
+
+int main() {
+    EventLoop loop;
+    g_sourceChunk = std::make_shared<const std::string>(kSourceChunkSize, 'x');
+
+    // 0: LT echo, 1: ET echo, 2: LT source, 3: ET source，每个server一个subloop
+    std::unique_ptr<TcpServer> servers[4];
+    EventLoop* ioLoops[4] = { nullptr, nullptr, nullptr, nullptr };
+    for(int i = 0; i < 4; ++i) {
+        bool edgeTriggered = (i % 2 == 1);
+        bool source = (i >= 2);
+        EventLoop** ioLoop = &ioLoops[i];
+        servers[i].reset(new TcpServer(&loop, InetAddress(kBasePort + i), edgeTriggered ? "ET" : "LT"));
+        if(source) {
+            servers[i]->setConnectionCallback(onSourceConnection);
+            servers[i]->setWriteCompleteCallback(onSourceWriteComplete);
+        }
+        else {
+            servers[i]->setConnectionCallback([](const TcpConnectionPtr&) {});
+            servers[i]->setMessageCallback(onEchoMessage);
+        }
+        servers[i]->setThreadInitcallback([ioLoop](EventLoop* l) { *ioLoop = l; });
+        servers[i]->setEdgeTriggered(edgeTriggered);
+        servers[i]->setThreadNum(1);
+        servers[i]->start();
+    }
+
+    std::thread bench([&loop, &ioLoops]() {
+        echoClient("echo LT", kBasePort, ioLoops[0]);
+        echoClient("echo ET", kBasePort + 1, ioLoops[1]);
+        sourceClient("source LT", kBasePort + 2, ioLoops[2]);
+        sourceClient("source ET", kBasePort + 3, ioLoops[3]);
+        loop.quit();
+    });
+
+    loop.loop();
+    bench.join();
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <mymuduo/HttpServer.h>
+#include <mymuduo/HttpRequest.h>
+#include <mymuduo/HttpResponse.h>
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 类似wrk的本地压测：kConnections条keep-alive连接，每条连接保持depth个请求在途（流水线），
+// 收到一个完整响应就再发一个，统计kSeconds秒内完成的请求数
+
+static const uint16_t kPort = 9992;
+static const int kConnections = 32;
+static const double kSeconds = 2.0;
+
+static const char kRequest[] = "GET /hello HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: httpBench\r\n\r\n";
+
+static std::atomic<int64_t> g_responses(0);
+static std::atomic<bool> g_counting(false); // 预热阶段也在发请求，只是不计数
+
+static void onRequest(const HttpRequest& req, HttpResponse* resp) {
+    if(req.path() == "/hello") {
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setContentType("text/plain");
+        resp->setBody("hello, world!\n");
+    }
+    else {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+    }
+}
+
+// 从buf中取走完整的响应，返回个数
+static int consumeResponses(Buffer* buf) {
+    int count = 0;
+    while(true) {
+        const char* begin = buf->peek();
+        const char* end = buf->beginWrite();
+        const char* headerEnd = static_cast<const char*>(memmem(begin, end - begin, "\r\n\r\n", 4));
+        if(headerEnd == nullptr) {
+            break;
+        }
+        const char* cl = static_cast<const char*>(memmem(begin, headerEnd - begin, "Content-Length: ", 16));
+        size_t bodyLen = cl ? strtoul(cl + 16, nullptr, 10) : 0;
+        size_t total = headerEnd + 4 - begin + bodyLen;
+        if(buf->readableBytes() < total) {
+            break;
+        }
+        buf->retrieve(total);
+        ++count;
+    }
+    return count;
+}
+
+class LoadClient {
+public:
+    LoadClient(EventLoop* loop, int depth, int index)
+        : client_(loop, InetAddress(kPort), "httpBench-" + std::to_string(index))
+        , depth_(depth)
+    {
+        client_.setConnectionCallback(std::bind(&LoadClient::onConnection, this, std::placeholders::_1));
+        client_.setMessageCallback(std::bind(&LoadClient::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    }
+
+    void connect() { client_.connect(); }
+private:
+    void onConnection(const TcpConnectionPtr& conn) {
+        if(conn->connected()) {
+            std::string requests;
+            for(int i = 0; i < depth_; ++i) {
+                requests.append(kRequest, sizeof(kRequest) - 1);
+            }
+            conn->send(requests);
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        int n = consumeResponses(buf);
+        if(g_counting) {
+            g_responses += n;
+        }
+        std::string requests;
+        for(int i = 0; i < n; ++i) {
+            requests.append(kRequest, sizeof(kRequest) - 1);
+        }
+        conn->send(std::move(requests));
+    }
+
+    TcpClient client_;
+    int depth_;
+};
+
+static void runOnce(EventLoop* clientLoop, int depth) {
+    std::vector<std::unique_ptr<LoadClient>> clients;
+    clientLoop->runInLoop([&]() {
+        for(int i = 0; i < kConnections; ++i) {
+            clients.emplace_back(new LoadClient(clientLoop, depth, i));
+            clients.back()->connect();
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // 连接建立，预热
+    g_responses = 0;
+    g_counting = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(kSeconds * 1000)));
+    g_counting = false;
+    int64_t responses = g_responses;
+
+    std::atomic<bool> destroyed(false);
+    clientLoop->runInLoop([&]() {
+        clients.clear(); // TcpClient在loop线程中析构
+        destroyed = true;
+    });
+    while(!destroyed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // 等服务器关闭连接
+
+    printf("%d connections pipeline depth %2d: %10.0f requests/s\n", kConnections, depth, responses / kSeconds);
+}
+
+int main(int argc, char* argv[]) {
+    int serverThreads = argc > 1 ? atoi(argv[1]) : 1;
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(kPort), "HttpBench");
+    server.setHttpCallback(onRequest);
+    server.setThreadNum(serverThreads);
+    server.start();
+
+    EventLoopThread clientThread(EventLoopThread::ThreadInitCallback(), "httpBenchClient");
+    EventLoop* clientLoop = clientThread.startLoop();
+
+    std::thread bench([&loop, clientLoop]() {
+        const int depths[] = { 1, 16 };
+        for(int depth : depths) {
+            runOnce(clientLoop, depth);
+        }
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// 不同subLoop选择策略在连接负载不均衡时的尾延迟
+// 先建立kHeavyConnections个重连接（服务器不停地向它推送数据），每个重连接之后跟一个马上关闭的短连接，
+// 轮询会把重连接集中到一半的loop上；然后kLightConnections个轻连接做64字节的ping-pong，统计延迟分位数
+
+static const uint16_t kPort = 9997;
+static const int kNumLoops = 4;
+static const int kHeavyConnections = 2;
+static const int kLightConnections = 16;
+static const int kPings = 10000;
+static const size_t kStreamBlockSize = 4 * 1024 * 1024;
+
+static std::mutex g_mutex;
+static std::unordered_set<TcpConnection*> g_heavy;
+static SharedBlock g_block;
+
+static int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool isHeavy(const TcpConnectionPtr& conn) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    return g_heavy.count(conn.get()) > 0;
+}
+
+static void onConnection(const TcpConnectionPtr& conn) {
+    if(!conn->connected()) {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        g_heavy.erase(conn.get());
+    }
+}
+
+// 'H'：开始推送数据，成为重连接；其它数据原样发回
+static void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    if(buf->readableBytes() > 0 && *buf->peek() == 'H') {
+        buf->retrieveAll();
+        {
+            std::unique_lock<std::mutex> lock(g_mutex);
+            g_heavy.insert(conn.get());
+        }
+        conn->send(g_block);
+    }
+    else {
+        conn->send(buf);
+    }
+}
+
+static void onWriteComplete(const TcpConnectionPtr& conn) {
+    if(isHeavy(conn)) {
+        conn->send(g_block);
+    }
+}
+
+static int connectTo() {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+        perror("connect");
+        ::close(sockfd);
+        return -1;
+    }
+    int on = 1;
+    ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+    return sockfd;
+}
+
+static bool pingPong(int sockfd, char* buf, size_t len) {
+    if(::write(sockfd, buf, len) != static_cast<ssize_t>(len)) {
+        return false;
+    }
+    size_t received = 0;
+    while(received < len) {
+        ssize_t n = ::read(sockfd, buf + received, len - received);
+        if(n <= 0) {
+            return false;
+        }
+        received += n;
+    }
+    return true;
+}
+
+static void runOnce(const char* name, EventLoopThreadPool::LoadBalance policy) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "LoadBalanceBench");
+    server.setConnectionCallback(onConnection);
+    server.setMessageCallback(onMessage);
+    server.setWriteCompleteCallback(onWriteComplete);
+    server.setLoadBalance(policy);
+    server.setThreadNum(kNumLoops);
+    server.start();
+
+    std::thread bench([&loop, name]() {
+        std::atomic_bool stop(false);
+        std::vector<int> heavyFds;
+        std::vector<std::thread> readers;
+        char buf[64];
+        ::memset(buf, 'p', sizeof buf);
+
+        for(int i = 0; i < kHeavyConnections; ++i) {
+            int heavy = connectTo();
+            ::write(heavy, "H", 1);
+            heavyFds.push_back(heavy);
+            readers.emplace_back([heavy, &stop]() {
+                static thread_local char sink[64 * 1024];
+                while(!stop && ::read(heavy, sink, sizeof sink) > 0) {
+                }
+            });
+
+            int shortLived = connectTo();
+            pingPong(shortLived, buf, 1);
+            ::close(shortLived);
+            ::usleep(20 * 1000); // 等服务器处理完关闭
+        }
+
+        std::vector<int> lightFds;
+        for(int i = 0; i < kLightConnections; ++i) {
+            lightFds.push_back(connectTo());
+        }
+        ::usleep(100 * 1000);
+
+        std::vector<int64_t> latencies;
+        latencies.reserve(kPings);
+        for(int i = 0; i < kPings; ++i) {
+            int64_t start = nowMicros();
+            if(!pingPong(lightFds[i % kLightConnections], buf, sizeof buf)) {
+                break;
+            }
+            latencies.push_back(nowMicros() - start);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        size_t n = latencies.size();
+        if(n > 0) {
+            printf("%-18s p50 %6ld us, p99 %6ld us, p99.9 %6ld us, max %6ld us\n", name,
+                   (long)latencies[n / 2], (long)latencies[n * 99 / 100],
+                   (long)latencies[n * 999 / 1000], (long)latencies[n - 1]);
+        }
+
+        stop = true;
+        for(int fd : lightFds) {
+            ::close(fd);
+        }
+        for(int fd : heavyFds) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        for(std::thread& t : readers) {
+            t.join();
+        }
+        for(int fd : heavyFds) {
+            ::close(fd);
+        }
+        ::usleep(100 * 1000);
+        loop.quit();
+    });
+    loop.loop();
+    bench.join();
+}
+
+int main() {
+    g_block = std::make_shared<const std::string>(kStreamBlockSize, 'x');
+    runOnce("round-robin", EventLoopThreadPool::kRoundRobin);
+    runOnce("least-connections", EventLoopThreadPool::kLeastConnections);
+    runOnce("least-pending", EventLoopThreadPool::kLeastPendingBytes);
+    runOnce("power-of-two", EventLoopThreadPool::kPowerOfTwoChoices);
+    runOnce("hash-by-peer", EventLoopThreadPool::kHashByPeer);
+    return 0;
+}
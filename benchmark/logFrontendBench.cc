@@ -0,0 +1,68 @@
+#include <mymuduo/Logger.h>
+#include <mymuduo/LogStream.h>
+
+#include <stdio.h>
+#include <string>
+#include <chrono>
+#include <functional>
+
+// 日志前端的基准测试：被过滤掉的日志和输出的日志各要花多少时间
+// 输出端设置为空函数，只测格式化的开销，后端的开销见asyncLoggingBench
+// 用法：./logfrontend_bench
+
+static const int kIterations = 5 * 1000 * 1000;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double run(const std::function<void(int)>& logOne) {
+    double start = nowSeconds();
+    for(int i = 0; i < kIterations; ++i) {
+        logOne(i);
+    }
+    return (nowSeconds() - start) * 1e9 / kIterations;
+}
+
+static size_t g_bytes = 0;
+
+static void nullOutput(const char*, size_t len) {
+    g_bytes += len;
+}
+
+// 以前的宏：每次都写共享的级别，清零1KB的栈缓冲区，snprintf，再构造std::string交给log
+static void legacyLog(int fd, int bytes) {
+    char buf[1024] = {0};
+    snprintf(buf, 1024, "TcpConnection::handleRead fd=%d bytes=%d", fd, bytes);
+    std::string msg(buf);
+    Logger::instance().log(INFO, msg.data(), msg.size());
+}
+
+int main() {
+    Logger::instance().setOutput(nullOutput);
+
+    Logger::setLogLevel(ERROR);
+    double printfOff = run([](int i) {
+        LOG_INFO("TcpConnection::handleRead fd=%d bytes=%d", 12, i);
+    });
+    double streamOff = run([](int i) {
+        LOG_STREAM(INFO) << "TcpConnection::handleRead fd=" << 12 << " bytes=" << i;
+    });
+
+    Logger::setLogLevel(INFO);
+    double legacyOn = run([](int i) {
+        legacyLog(12, i);
+    });
+    double printfOn = run([](int i) {
+        LOG_INFO("TcpConnection::handleRead fd=%d bytes=%d", 12, i);
+    });
+    double streamOn = run([](int i) {
+        LOG_STREAM(INFO) << "TcpConnection::handleRead fd=" << 12 << " bytes=" << i;
+    });
+
+    printf("filtered:  LOG_INFO %6.1f ns  LOG_STREAM %6.1f ns\n", printfOff, streamOff);
+    printf("enabled:   legacy   %6.1f ns  LOG_INFO %6.1f ns  LOG_STREAM %6.1f ns\n", legacyOn, printfOn, streamOn);
+    printf("(%lu bytes formatted)\n", static_cast<unsigned long>(g_bytes));
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Poller.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+#include <thread>
+
+// epoll和io_uring两种Poller的echo对比
+// 客户端在kConnections个连接上各发一个64字节的请求，收齐所有回应以后再发下一轮
+// 统计subloop每个请求的事件等待系统调用（epoll_wait/io_uring_enter等待）和注册系统调用（epoll_ctl/io_uring_enter提交）
+// churn：反复建立、关闭连接，统计每个连接的注册系统调用，io_uring把注册变化和等待放在同一次io_uring_enter中提交
+
+static const uint16_t kBasePort = 9990;
+static const int kConnections = 16;
+static const int kRounds = 20000;
+static const size_t kMessageSize = 64;
+static const int kChurnConnections = 2000;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+    conn->send(buf);
+}
+
+struct Counters {
+    uint64_t polls;
+    uint64_t ctls;
+};
+
+// 计数只能在loop线程中读
+static Counters readCounters(EventLoop* loop) {
+    std::promise<Counters> promise;
+    loop->runInLoop([loop, &promise]() {
+        Counters c = { loop->poller()->pollCalls(), loop->poller()->ctlCalls() };
+        promise.set_value(c);
+    });
+    return promise.get_future().get();
+}
+
+static void echoClient(const char* name, uint16_t port, EventLoop* ioLoop) {
+    std::vector<int> sockfds;
+    for(int i = 0; i < kConnections; ++i) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        ::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+            perror("connect");
+            return;
+        }
+        int on = 1;
+        ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+        sockfds.push_back(sockfd);
+    }
+    ::usleep(100 * 1000); // 等连接注册到subloop上
+
+    char message[kMessageSize];
+    ::memset(message, 'x', sizeof message);
+    char buf[kMessageSize];
+
+    Counters before = readCounters(ioLoop);
+    double start = nowSeconds();
+    for(int round = 0; round < kRounds; ++round) {
+        for(int sockfd : sockfds) {
+            if(::write(sockfd, message, sizeof message) != sizeof message) {
+                perror("write");
+                return;
+            }
+        }
+        for(int sockfd : sockfds) {
+            size_t received = 0;
+            while(received < kMessageSize) {
+                ssize_t n = ::read(sockfd, buf, kMessageSize - received);
+                if(n <= 0) {
+                    perror("read");
+                    return;
+                }
+                received += n;
+            }
+        }
+    }
+    double elapsed = nowSeconds() - start;
+    Counters after = readCounters(ioLoop);
+
+    double requests = static_cast<double>(kRounds) * kConnections;
+    printf("%-12s %8.0f req/s, wait syscalls/req %.3f, ctl syscalls/req %.3f\n",
+           name, requests / elapsed,
+           (after.polls - before.polls) / requests, (after.ctls - before.ctls) / requests);
+
+    for(int sockfd : sockfds) {
+        ::close(sockfd);
+    }
+}
+
+static void churnClient(const char* name, uint16_t port, EventLoop* ioLoop) {
+    Counters before = readCounters(ioLoop);
+    double start = nowSeconds();
+    for(int i = 0; i < kChurnConnections; ++i) {
+        int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        ::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(::connect(sockfd, (sockaddr*)&addr, sizeof addr) < 0) {
+            perror("connect");
+            return;
+        }
+        // 收到回应说明连接已经注册到subloop上
+        char c = 'x';
+        if(::write(sockfd, &c, 1) != 1 || ::read(sockfd, &c, 1) != 1) {
+            perror("churn");
+            return;
+        }
+        ::close(sockfd);
+    }
+    double elapsed = nowSeconds() - start;
+    ::usleep(100 * 1000); // 等最后一个连接关闭
+    Counters after = readCounters(ioLoop);
+
+    printf("%-12s %8.0f conn/s, wait syscalls/conn %.3f, ctl syscalls/conn %.3f\n",
+           name, kChurnConnections / elapsed,
+           (after.polls - before.polls) / static_cast<double>(kChurnConnections),
+           (after.ctls - before.ctls) / static_cast<double>(kChurnConnections));
+}
+
+int main() {
+    EventLoop loop;
+
+    struct Config {
+        const char* name;
+        EventLoop::PollerType type;
+        bool edgeTriggered;
+    };
+    const Config configs[] = {
+        { "epoll LT", EventLoop::kEpollPoller, false },
+        { "epoll ET", EventLoop::kEpollPoller, true },
+        { "io_uring LT", EventLoop::kIoUringPoller, false }, // 单次poll，处理完重新注册
+        { "io_uring ET", EventLoop::kIoUringPoller, true }, // multishot poll
+    };
+    const int kNumConfigs = sizeof configs / sizeof configs[0];
+
+    std::unique_ptr<TcpServer> servers[kNumConfigs];
+    EventLoop* ioLoops[kNumConfigs];
+    for(int i = 0; i < kNumConfigs; ++i) {
+        EventLoop** ioLoop = &ioLoops[i];
+        servers[i].reset(new TcpServer(&loop, InetAddress(kBasePort + i), configs[i].name));
+        servers[i]->setConnectionCallback([](const TcpConnectionPtr&) {});
+        servers[i]->setMessageCallback(onMessage);
+        servers[i]->setThreadInitcallback([ioLoop](EventLoop* l) { *ioLoop = l; });
+        servers[i]->setPollerType(configs[i].type);
+        servers[i]->setEdgeTriggered(configs[i].edgeTriggered);
+        servers[i]->setThreadNum(1);
+        servers[i]->start();
+    }
+
+    std::thread bench([&]() {
+        for(int i = 0; i < kNumConfigs; ++i) {
+            echoClient(configs[i].name, kBasePort + i, ioLoops[i]);
+        }
+        for(int i = 0; i < kNumConfigs; ++i) {
+            churnClient(configs[i].name, kBasePort + i, ioLoops[i]);
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    bench.join();
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 跨线程投递回调的基准测试：多个生产者线程向一个loop投递回调
+// 对比EventLoop::queueInLoop（无锁队列+唤醒合并）和原来的 mutex+vector+每次写eventfd 的实现
+
+static const int kPostsPerProducer = 200 * 1000;
+
+static int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 原来的EventLoop::queueInLoop/doPendingFunctors，单独实现一个最小的loop用来对比
+class LegacyLoop {
+public:
+    using Functor = std::function<void()>;
+
+    LegacyLoop()
+        : quit_(false)
+        , wakeupFd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+        , epollfd_(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = wakeupFd_;
+        ::epoll_ctl(epollfd_, EPOLL_CTL_ADD, wakeupFd_, &ev);
+    }
+
+    ~LegacyLoop() {
+        ::close(wakeupFd_);
+        ::close(epollfd_);
+    }
+
+    void loop() {
+        epoll_event events[16];
+        while(!quit_) {
+            int n = ::epoll_wait(epollfd_, events, 16, 10000);
+            if(n > 0) {
+                uint64_t one = 0;
+                ssize_t r = ::read(wakeupFd_, &one, sizeof one);
+                (void)r;
+            }
+            std::vector<Functor> functors;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                functors.swap(pendingFunctors_);
+            }
+            for(const Functor& functor : functors) {
+                functor();
+            }
+        }
+    }
+
+    void quit() { quit_ = true; }
+
+    void queueInLoop(Functor cb) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pendingFunctors_.emplace_back(cb);
+        }
+        uint64_t one = 1;
+        ssize_t n = ::write(wakeupFd_, &one, sizeof one);
+        (void)n;
+    }
+private:
+    std::atomic_bool quit_;
+    int wakeupFd_;
+    int epollfd_;
+    std::mutex mutex_;
+    std::vector<Functor> pendingFunctors_;
+};
+
+struct Result {
+    double postsPerSecond;
+    double avgLatencyUs;
+    double p99LatencyUs;
+};
+
+// post: 向loop投递一个回调；回调在loop线程中记录投递到执行的延迟
+template<typename Post>
+static Result run(int numProducers, Post post, std::vector<int64_t>* latencies, std::function<void()> onDone) {
+    const int total = numProducers * kPostsPerProducer;
+    latencies->assign(total, 0);
+    std::atomic<int> index(0);
+    int executed = 0;
+    int64_t start = nowNanos();
+    int64_t end = 0;
+
+    std::vector<std::unique_ptr<std::thread>> producers;
+    for(int p = 0; p < numProducers; ++p) {
+        producers.emplace_back(new std::thread([&] {
+            for(int i = 0; i < kPostsPerProducer; ++i) {
+                int64_t postTime = nowNanos();
+                post([&, postTime] {
+                    (*latencies)[index++] = nowNanos() - postTime;
+                    if(++executed == total) {
+                        end = nowNanos();
+                        onDone();
+                    }
+                });
+            }
+        }));
+    }
+    for(auto& t : producers) {
+        t->join();
+    }
+
+    // 等待loop执行完所有回调
+    while(index.load() < total) {
+        ::usleep(1000);
+    }
+    ::usleep(10 * 1000);
+
+    std::sort(latencies->begin(), latencies->end());
+    double sum = 0;
+    for(int64_t l : *latencies) {
+        sum += l;
+    }
+    Result result;
+    result.postsPerSecond = total / ((end - start) / 1e9);
+    result.avgLatencyUs = sum / total / 1000;
+    result.p99LatencyUs = (*latencies)[total * 99 / 100] / 1000.0;
+    return result;
+}
+
+int main() {
+    std::vector<int64_t> latencies;
+
+    EventLoopThread loopThread;
+    EventLoop* loop = loopThread.startLoop();
+
+    for(int numProducers : {1, 4, 8}) {
+        Result current = run(numProducers,
+            [loop](EventLoop::Functor cb) { loop->queueInLoop(std::move(cb)); },
+            &latencies, [] {});
+
+        LegacyLoop legacy;
+        std::thread legacyThread([&] { legacy.loop(); });
+        Result old = run(numProducers,
+            [&legacy](LegacyLoop::Functor cb) { legacy.queueInLoop(std::move(cb)); },
+            &latencies, [&legacy] { legacy.quit(); });
+        legacyThread.join();
+
+        printf("producers=%d\n", numProducers);
+        printf("  mpsc+coalesced wakeup  %10.0f posts/s  avg %8.1f us  p99 %8.1f us\n",
+            current.postsPerSecond, current.avgLatencyUs, current.p99LatencyUs);
+        printf("  mutex+vector (legacy)  %10.0f posts/s  avg %8.1f us  p99 %8.1f us\n",
+            old.postsPerSecond, old.avgLatencyUs, old.p99LatencyUs);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/TimerId.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// 定时器队列的基准测试：在100万个未到期定时器的规模下，测量插入、取消（重设）和到期的速率
+
+static const int kNumTimers = 1000 * 1000;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* what, int count, double seconds) {
+    printf("%-28s %8d timers  %8.3f ms  %10.0f ops/s  %6.1f ns/op\n",
+        what, count, seconds * 1000, count / seconds, seconds * 1e9 / count);
+}
+
+int main() {
+    EventLoop loop;
+    std::mt19937 rng(2023);
+
+    // 1. 插入：延迟在1秒到1小时之间均匀分布，覆盖时间轮的各层
+    std::uniform_real_distribution<double> longDelay(1.0, 3600.0);
+    std::vector<double> delays(kNumTimers);
+    for(double& d : delays) {
+        d = longDelay(rng);
+    }
+
+    std::vector<TimerId> ids(kNumTimers);
+    double start = nowSeconds();
+    for(int i = 0; i < kNumTimers; ++i) {
+        ids[i] = loop.runAfter(delays[i], [] {});
+    }
+    report("insert", kNumTimers, nowSeconds() - start);
+
+    // 2. 重设：保持100万个定时器，每个连接收到消息时取消旧定时器再添加新的
+    start = nowSeconds();
+    for(int i = 0; i < kNumTimers; ++i) {
+        loop.cancel(ids[i]);
+        ids[i] = loop.runAfter(delays[kNumTimers - 1 - i], [] {});
+    }
+    report("cancel+insert (re-arm)", kNumTimers, nowSeconds() - start);
+
+    // 3. 取消
+    start = nowSeconds();
+    for(int i = 0; i < kNumTimers; ++i) {
+        loop.cancel(ids[i]);
+    }
+    report("cancel", kNumTimers, nowSeconds() - start);
+
+    // 4. 到期：100万个定时器分布在100ms内，等它们全部到期后再进入事件循环，只测量处理时间
+    std::uniform_real_distribution<double> shortDelay(0.0, 0.1);
+    int fired = 0;
+    double expireStart = 0;
+    for(int i = 0; i < kNumTimers; ++i) {
+        loop.runAfter(shortDelay(rng), [&] {
+            if(++fired == kNumTimers) {
+                report("expire", kNumTimers, nowSeconds() - expireStart);
+                loop.quit();
+            }
+        });
+    }
+    ::usleep(200 * 1000);
+    expireStart = nowSeconds();
+    loop.loop();
+    return 0;
+}
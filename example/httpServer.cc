@@ -0,0 +1,50 @@
+#include <mymuduo/HttpServer.h>
+#include <mymuduo/AdminServer.h>
+#include <mymuduo/HttpRequest.h>
+#include <mymuduo/HttpResponse.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Logger.h>
+#include <string>
+
+// curl http://127.0.0.1:8000/hello
+// curl -d 'some data' http://127.0.0.1:8000/echo
+// curl -H 'Transfer-Encoding: chunked' -d @file http://127.0.0.1:8000/echo
+// curl http://127.0.0.1:8001/metrics
+void onRequest(const HttpRequest& req, HttpResponse* resp) {
+    if(req.path() == "/") {
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setContentType("text/html");
+        resp->setBody("<html><head><title>mymuduo</title></head>"
+            "<body><h1>Hello</h1>Now is " + Timestamp::now().toFormattedString() + "</body></html>");
+    }
+    else if(req.path() == "/hello") {
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setContentType("text/plain");
+        resp->setBody("hello, world!\n");
+    }
+    else if(req.path() == "/echo") {
+        if(req.method() != HttpRequest::kPost && req.method() != HttpRequest::kPut) {
+            resp->setStatusCode(HttpResponse::k405MethodNotAllowed);
+            return;
+        }
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setContentType("application/octet-stream");
+        resp->setBody(req.body().as_string());
+    }
+    else {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+        resp->setCloseConnection(true);
+    }
+}
+
+int main() {
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(8000), "HttpServer-01");
+    server.setHttpCallback(onRequest);
+    server.setThreadNum(3);
+    server.start();
+    AdminServer admin(&loop, InetAddress(8001)); // 在mainLoop上提供各个loop的统计
+    admin.start();
+    loop.loop();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Logger.h>
+#include <string>
+#include <functional>
+
+// 连接testServer的echo客户端，服务端没有启动时按指数退避重试
+class EchoClient {
+public:
+    EchoClient(EventLoop* loop,
+            const InetAddress& serverAddr,
+            const std::string& name)
+        : client_(loop, serverAddr, name), loop_(loop)
+    {
+        client_.setConnectionCallback(
+            std::bind(&EchoClient::onConnection, this, std::placeholders::_1)
+        );
+        client_.setMessageCallback(
+            std::bind(&EchoClient::onMessage, this,
+                std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
+        );
+        client_.setConnectTimeout(3.0);
+    }
+
+    void connect() {
+        client_.connect();
+    }
+private:
+    void onConnection(const TcpConnectionPtr& conn) {
+        if(conn->connected()) {
+            LOG_INFO("Connection UP : %s", conn->peerAddress().toIpPort().c_str());
+            conn->send("hello mymuduo\n");
+        }
+        else {
+            LOG_INFO("Connection DOWN : %s", conn->peerAddress().toIpPort().c_str());
+            loop_->quit();
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr&,
+                Buffer* buf,
+                Timestamp)
+    {
+        std::string msg = buf->retrieveAllAsString();
+        LOG_INFO("echo : %s", msg.c_str());
+    }
+
+    TcpClient client_;
+    EventLoop* loop_;
+};
+
+int main() {
+    EventLoop loop;
+    InetAddress serverAddr(8000);
+    EchoClient client(&loop, serverAddr, "EchoClient-01");
+    client.connect();
+    loop.loop();
+    return 0;
+}